@@ -0,0 +1,171 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/* Benchmarks helpers: timing and one JSON object per result line */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Default run time of one benchmark (ns), BENCH_TIME=<seconds> to change */
+#define BENCH_DEFAULT_NS	1000000000ULL
+
+static inline uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t bench_duration_ns(void)
+{
+	const char *s = getenv("BENCH_TIME");
+
+	if (s != NULL && atof(s) > 0)
+		return (uint64_t) (atof(s) * 1e9);
+	return BENCH_DEFAULT_NS;
+}
+
+/* Keep the compiler from optimizing a benchmarked result away */
+static inline void bench_use(const void *p)
+{
+	__asm__ __volatile__("" : : "r" (p) : "memory");
+}
+
+/* Calls are timed in batches of about this duration (ns) */
+#define BENCH_BATCH_NS		10000ULL
+
+/* Per call time of each batch of the last bench_run(), for percentiles */
+static uint64_t		*benchSamples;
+static unsigned int	benchNbSamples, benchMaxSamples;
+
+static inline void bench_sample(uint64_t ns)
+{
+	if (benchNbSamples == benchMaxSamples) {
+		benchMaxSamples = benchMaxSamples ? benchMaxSamples * 2 : 1024;
+		benchSamples = realloc(benchSamples, benchMaxSamples *
+				       sizeof(*benchSamples));
+		if (benchSamples == NULL) {
+			perror("bench");
+			exit(1);
+		}
+	}
+	benchSamples[benchNbSamples++] = ns;
+}
+
+static inline int bench_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* 'pct' percentile of 'nb' samples, sorted on the way */
+static inline uint64_t bench_percentile(uint64_t *samples, unsigned int nb,
+					double pct)
+{
+	unsigned int i;
+
+	if (nb == 0)
+		return 0;
+	qsort(samples, nb, sizeof(*samples), bench_cmp);
+	i = (unsigned int) (pct / 100 * nb);
+	return samples[i < nb ? i : nb - 1];
+}
+
+/*
+ * Run 'op' (with 'arg') in batches until the benchmark duration is over.
+ * Return the number of calls, '*ns' is set to the time spent.
+ */
+static inline uint64_t bench_run(void (*op)(void *), void *arg, uint64_t *ns)
+{
+	uint64_t	end, start, now, prev;
+	uint64_t	iters = 1;
+	unsigned int	i, batch;
+
+	benchNbSamples = 0;
+
+	/* Size batches from a first call: slow operations are timed alone */
+	start = bench_now_ns();
+	op(arg);
+	now = bench_now_ns();
+	batch = BENCH_BATCH_NS / (now - start + 1);
+	batch = batch < 1 ? 1 : batch > 64 ? 64 : batch;
+
+	end = start + bench_duration_ns();
+	do {
+		prev = now;
+		for (i = 0; i < batch; i++)
+			op(arg);
+		iters += batch;
+		now = bench_now_ns();
+		bench_sample((now - prev) / batch);
+	} while (now < end);
+	*ns = now - start;
+
+	return iters;
+}
+
+/*
+ * Print one result: throughput, p50/p99 per call time over the batches
+ * and, if bytes > 0, bandwidth
+ */
+static inline void bench_report(const char *name, uint64_t iters,
+				uint64_t ns, uint64_t bytesPerOp)
+{
+	double secs = ns / 1e9;
+
+	printf("{\"bench\": \"%s\", \"iterations\": %llu, "
+	       "\"ns_per_op\": %.1f, \"ops_per_s\": %.0f",
+	       name, (unsigned long long) iters, (double) ns / iters,
+	       iters / secs);
+	if (benchNbSamples > 0)
+		printf(", \"p50_ns\": %llu, \"p99_ns\": %llu",
+		       (unsigned long long) bench_percentile(benchSamples,
+						benchNbSamples, 50),
+		       (unsigned long long) bench_percentile(benchSamples,
+						benchNbSamples, 99));
+	if (bytesPerOp > 0)
+		printf(", \"mb_per_s\": %.1f",
+		       (double) bytesPerOp * iters / secs / 1e6);
+	printf("}\n");
+	fflush(stdout);
+}
+
+/* Print a latency distribution measured by the benchmark itself */
+static inline void bench_report_latency(const char *name, uint64_t *samples,
+					unsigned int nb)
+{
+	printf("{\"bench\": \"%s\", \"samples\": %u, \"p50_ns\": %llu, "
+	       "\"p99_ns\": %llu, \"max_ns\": %llu}\n", name, nb,
+	       (unsigned long long) bench_percentile(samples, nb, 50),
+	       (unsigned long long) bench_percentile(samples, nb, 99),
+	       (unsigned long long) bench_percentile(samples, nb, 100));
+	fflush(stdout);
+}
+
+#endif /* BENCH_H */
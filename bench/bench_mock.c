@@ -0,0 +1,113 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * End to end benchmarks against neard_mock, run on a private bus by
+ * 'make bench': construct time, tag found to callback latency (from the
+ * signal reception) and Tag.Write throughput.
+ */
+
+#include "bench.h"
+
+#include <glib.h>
+
+#include "neardal.h"
+
+#define NB_CONSTRUCTS	50
+#define NB_SAMPLES_MAX	100000
+
+static uint64_t		samples[NB_SAMPLES_MAX];
+static unsigned int	nbSamples;
+static char		*lastTag;
+static unsigned int	nbErrors;
+
+static void on_tag_found(const char *tagName, void *ud)
+{
+	const neardal_event_info *info = neardal_current_event_info();
+
+	(void) ud;
+	if (info != NULL && info->received != 0 && nbSamples < NB_SAMPLES_MAX)
+		samples[nbSamples++] = bench_now_ns() - info->received;
+	g_free(lastTag);
+	lastTag = g_strdup(tagName);
+}
+
+static gboolean on_timeout(gpointer loop)
+{
+	g_main_loop_quit(loop);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void op_write(void *arg)
+{
+	if (neardal_tag_write(arg) != NEARDAL_SUCCESS)
+		nbErrors++;
+}
+
+int main(void)
+{
+	neardal_record	rcd = {
+		.type	= "URI",
+		.uri	= "https://example.com/nfc/bench",
+	};
+	GMainLoop	*loop;
+	char		**adapters = NULL;
+	uint64_t	iters, ns, start;
+	int		len;
+
+	/* Connection, Neard objects read and proxies, from scratch */
+	for (nbSamples = 0; nbSamples < NB_CONSTRUCTS; nbSamples++) {
+		start = bench_now_ns();
+		if (neardal_get_adapters(&adapters, &len) != NEARDAL_SUCCESS) {
+			fprintf(stderr, "bench_mock: no Neard, run it under "
+				"mock/run-mock.sh\n");
+			return 1;
+		}
+		samples[nbSamples] = bench_now_ns() - start;
+		neardal_free_array(&adapters);
+		neardal_destroy();
+	}
+	bench_report_latency("construct", samples, nbSamples);
+
+	nbSamples = 0;
+	neardal_set_cb_tag_found(on_tag_found, NULL);
+	loop = g_main_loop_new(NULL, FALSE);
+	g_timeout_add(bench_duration_ns() / 1000000, on_timeout, loop);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+	if (lastTag == NULL) {
+		fprintf(stderr, "bench_mock: no tag found (--tag-rate?)\n");
+		return 1;
+	}
+	bench_report_latency("tag_found_to_callback", samples, nbSamples);
+
+	/* Synchronous writes on the last tag found, still in the field */
+	rcd.name = lastTag;
+	iters = bench_run(op_write, &rcd, &ns);
+	bench_report("tag_write", iters, ns, 0);
+	if (nbErrors > 0)
+		fprintf(stderr, "bench_mock: %u write errors\n", nbErrors);
+
+	g_free(lastTag);
+	neardal_destroy();
+
+	return 0;
+}
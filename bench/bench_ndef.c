@@ -0,0 +1,169 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/* NDEF parser throughput, on a typical tag content (TLV wrapped) */
+
+#include "bench.h"
+
+#include <string.h>
+
+#include "neardal_ndef.h"
+
+#define NB_RCDS_MAX	16
+
+static unsigned char	tlv[1024];
+static unsigned int	tlvLen;
+
+/* Append a record, 'flags' giving MB/ME/CF/SR/IL and the TNF */
+static unsigned int put_record(unsigned char *p, unsigned char flags,
+			       const char *type, const unsigned char *payload,
+			       unsigned int payloadLen)
+{
+	unsigned int typeLen = type ? strlen(type) : 0;
+	unsigned int len = 0;
+
+	if (payloadLen > 255)
+		flags &= ~NEARDAL_NDEF_SR;
+	p[len++] = flags;
+	p[len++] = typeLen;
+	if (flags & NEARDAL_NDEF_SR) {
+		p[len++] = payloadLen;
+	} else {
+		p[len++] = payloadLen >> 24;
+		p[len++] = payloadLen >> 16;
+		p[len++] = payloadLen >> 8;
+		p[len++] = payloadLen;
+	}
+	memcpy(p + len, type, typeLen);
+	len += typeLen;
+	memcpy(p + len, payload, payloadLen);
+
+	return len + payloadLen;
+}
+
+/*
+ * Smart Poster (URI + Text), Bluetooth OOB record, then a 3 chunks
+ * text/plain record (300 bytes)
+ */
+static void build_message(void)
+{
+	static const unsigned char uri[] = "\x01" "example.com/nfc/poster";
+	static const unsigned char text[] = "\x02" "en" "Hello from neardal";
+	unsigned char	sp[128], msg[1024], data[300];
+	unsigned int	spLen = 0, msgLen = 0;
+
+	memset(data, 'x', sizeof(data));
+
+	spLen += put_record(sp + spLen, NEARDAL_NDEF_MB | NEARDAL_NDEF_SR |
+			    NEARDAL_NDEF_TNF_WELL_KNOWN, "U", uri,
+			    sizeof(uri) - 1);
+	spLen += put_record(sp + spLen, NEARDAL_NDEF_ME | NEARDAL_NDEF_SR |
+			    NEARDAL_NDEF_TNF_WELL_KNOWN, "T", text,
+			    sizeof(text) - 1);
+
+	msgLen += put_record(msg + msgLen, NEARDAL_NDEF_MB | NEARDAL_NDEF_SR |
+			     NEARDAL_NDEF_TNF_WELL_KNOWN, "Sp", sp, spLen);
+	msgLen += put_record(msg + msgLen, NEARDAL_NDEF_SR |
+			     NEARDAL_NDEF_TNF_MIME,
+			     "application/vnd.bluetooth.ep.oob", data, 64);
+	msgLen += put_record(msg + msgLen, NEARDAL_NDEF_CF | NEARDAL_NDEF_SR |
+			     NEARDAL_NDEF_TNF_MIME, "text/plain", data, 100);
+	msgLen += put_record(msg + msgLen, NEARDAL_NDEF_CF | NEARDAL_NDEF_SR |
+			     NEARDAL_NDEF_TNF_UNCHANGED, NULL, data, 100);
+	msgLen += put_record(msg + msgLen, NEARDAL_NDEF_ME | NEARDAL_NDEF_SR |
+			     NEARDAL_NDEF_TNF_UNCHANGED, NULL, data, 100);
+
+	/* NULL TLV, NDEF message TLV (3 bytes length), terminator TLV */
+	tlv[tlvLen++] = 0x00;
+	tlv[tlvLen++] = 0x03;
+	tlv[tlvLen++] = 0xFF;
+	tlv[tlvLen++] = msgLen >> 8;
+	tlv[tlvLen++] = msgLen;
+	memcpy(tlv + tlvLen, msg, msgLen);
+	tlvLen += msgLen;
+	tlv[tlvLen++] = 0xFE;
+}
+
+static void op_parse(void *arg)
+{
+	neardal_ndef_record	rcds[NB_RCDS_MAX];
+	const unsigned char	*msg;
+	unsigned int		msgLen, nb;
+
+	(void) arg;
+	neardal_ndef_find_message(tlv, tlvLen, &msg, &msgLen);
+	neardal_ndef_parse(msg, msgLen, rcds, NB_RCDS_MAX, &nb);
+	bench_use(rcds);
+}
+
+static void op_iter(void *arg)
+{
+	neardal_ndef_iter	iter;
+	neardal_ndef_record	rcd;
+	const unsigned char	*msg;
+	unsigned int		msgLen;
+
+	(void) arg;
+	neardal_ndef_find_message(tlv, tlvLen, &msg, &msgLen);
+	neardal_ndef_iter_init(&iter, msg, msgLen, 0);
+	while (neardal_ndef_iter_next(&iter, &rcd) == NEARDAL_SUCCESS)
+		bench_use(&rcd);
+}
+
+static void op_copy_chunked(void *arg)
+{
+	neardal_ndef_record	*rcd = arg;
+	unsigned char		out[512];
+
+	bench_use(out + neardal_ndef_copy_payload(rcd, out, sizeof(out)));
+}
+
+int main(void)
+{
+	neardal_ndef_record	rcds[NB_RCDS_MAX];
+	const unsigned char	*msg;
+	unsigned int		msgLen, nb;
+	uint64_t		iters, ns;
+
+	build_message();
+
+	/* Sanity check: Sp, U, T, OOB, chunked text */
+	if (neardal_ndef_find_message(tlv, tlvLen, &msg, &msgLen)
+			!= NEARDAL_SUCCESS ||
+	    neardal_ndef_parse(msg, msgLen, rcds, NB_RCDS_MAX, &nb)
+			!= NEARDAL_SUCCESS ||
+	    nb != 5 || rcds[1].depth != 1 || rcds[4].chunks != 3 ||
+	    rcds[4].totalLen != 300) {
+		fprintf(stderr, "bench_ndef: unexpected parse result\n");
+		return 1;
+	}
+
+	iters = bench_run(op_parse, NULL, &ns);
+	bench_report("ndef_parse", iters, ns, tlvLen);
+
+	iters = bench_run(op_iter, NULL, &ns);
+	bench_report("ndef_iter_flat", iters, ns, tlvLen);
+
+	iters = bench_run(op_copy_chunked, &rcds[4], &ns);
+	bench_report("ndef_copy_chunked_payload", iters, ns,
+		     rcds[4].totalLen);
+
+	return 0;
+}
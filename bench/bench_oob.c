@@ -0,0 +1,108 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/* Handover OOB blobs parsers throughput (Bluetooth EIR, WiFi WSC) */
+
+#include "bench.h"
+
+#include <string.h>
+
+#include "neardal_oob.h"
+
+/* OOB length, address, class of device, hash, randomizer, name, UUIDs */
+static const unsigned char eir[] = {
+	0x00, 0x00,
+	0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+	0x04, 0x0D, 0x04, 0x04, 0x20,
+	0x11, 0x0E, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+		    0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+	0x11, 0x0F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+		    0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+	0x0C, 0x09, 'n', 'e', 'a', 'r', 'd', 'a', 'l', ' ', 'h', 's', 't',
+	0x07, 0x03, 0x0B, 0x11, 0x0E, 0x11, 0x1E, 0x11,
+};
+
+/* Version, credential (index, SSID, auth, encryption, key, MAC) */
+static const unsigned char wsc[] = {
+	0x10, 0x4A, 0x00, 0x01, 0x10,
+	0x10, 0x0E, 0x00, 0x46,
+		0x10, 0x26, 0x00, 0x01, 0x01,
+		0x10, 0x45, 0x00, 0x0B, 'n', 'e', 'a', 'r', 'd', 'a', 'l',
+					'-', 'n', 'e', 't',
+		0x10, 0x03, 0x00, 0x02, 0x00, 0x20,
+		0x10, 0x0F, 0x00, 0x02, 0x00, 0x08,
+		0x10, 0x27, 0x00, 0x18, 'c', 'o', 'r', 'r', 'e', 'c', 't',
+					' ', 'h', 'o', 'r', 's', 'e', ' ',
+					'b', 'a', 't', 't', 'e', 'r', 'y',
+					' ', 'o', 'k',
+		0x10, 0x20, 0x00, 0x06, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+static unsigned char eirBlob[sizeof(eir)];
+
+static void op_eir(void *arg)
+{
+	neardal_oob_eir oob;
+
+	(void) arg;
+	neardal_oob_parse_eir(eirBlob, sizeof(eirBlob), &oob);
+	bench_use(&oob);
+}
+
+static void op_wsc(void *arg)
+{
+	neardal_oob_wsc oob;
+
+	(void) arg;
+	neardal_oob_parse_wsc(wsc, sizeof(wsc), &oob);
+	bench_use(&oob);
+}
+
+int main(void)
+{
+	neardal_oob_eir	e;
+	neardal_oob_wsc	w;
+	uint64_t	iters, ns;
+
+	memcpy(eirBlob, eir, sizeof(eir));
+	eirBlob[0] = sizeof(eir);
+
+	/* Sanity check, then a truncated blob must be refused */
+	if (neardal_oob_parse_eir(eirBlob, sizeof(eirBlob), &e)
+			!= NEARDAL_SUCCESS || e.classOfDevice == NULL ||
+	    e.randomizer == NULL || e.nameLen != 11 || !e.nameComplete ||
+	    e.uuid16Len != 6 ||
+	    neardal_oob_parse_wsc(wsc, sizeof(wsc), &w) != NEARDAL_SUCCESS ||
+	    w.ssidLen != 11 || w.networkKeyLen != 24 || w.authType != 0x20 ||
+	    w.encrType != 0x08 || w.macAddress == NULL || w.version != 0x10 ||
+	    neardal_oob_parse_wsc(wsc, sizeof(wsc) - 1, &w)
+			!= NEARDAL_ERROR_INVALID_RECORD) {
+		fprintf(stderr, "bench_oob: unexpected parse result\n");
+		return 1;
+	}
+
+	iters = bench_run(op_eir, NULL, &ns);
+	bench_report("oob_parse_eir", iters, ns, sizeof(eirBlob));
+
+	iters = bench_run(op_wsc, NULL, &ns);
+	bench_report("oob_parse_wsc", iters, ns, sizeof(wsc));
+
+	return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Record encoding (Write/Push dictionary): text format parser vs typed,
+ * and decoding of a registry entry
+ */
+
+#include "bench.h"
+
+#include <glib.h>
+
+#include "neardal.h"
+
+/* Encoder as it was, parsing a GVariant text format for every field */
+#define LEGACY_IN(_builder, _format, _data)				\
+do {									\
+	if ((_data))							\
+		g_variant_builder_add_parsed((_builder),		\
+						(_format), (_data));	\
+} while (0)
+
+static GVariant *legacy_record_to_g_variant(neardal_record *in)
+{
+	GVariantBuilder b;
+
+	g_variant_builder_init(&b, G_VARIANT_TYPE_ARRAY);
+
+	LEGACY_IN(&b, "{'Action', <%s>}", in->action);
+	LEGACY_IN(&b, "{'Carrier', <%s>}", in->carrier);
+	LEGACY_IN(&b, "{'Encoding', <%s>}", in->encoding);
+	LEGACY_IN(&b, "{'Language', <%s>}", in->language);
+	LEGACY_IN(&b, "{'MIME', <%s>}", in->mime);
+	LEGACY_IN(&b, "{'Name', <%s>}", in->name);
+	LEGACY_IN(&b, "{'Representation', <%s>}", in->representation);
+	LEGACY_IN(&b, "{'Size', <%u>}", in->uriObjSize);
+	LEGACY_IN(&b, "{'Type', <%s>}", in->type);
+	LEGACY_IN(&b, "{'SSID', <%s>}", in->ssid);
+	LEGACY_IN(&b, "{'Passphrase', <%s>}", in->passphrase);
+	LEGACY_IN(&b, "{'Authentication', <%s>}", in->authentication);
+	LEGACY_IN(&b, "{'Encryption', <%s>}", in->encryption);
+	LEGACY_IN(&b, "{'URI', <%s>}", in->uri);
+
+	return g_variant_builder_end(&b);
+}
+
+static void op_legacy(void *arg)
+{
+	g_variant_unref(g_variant_ref_sink(legacy_record_to_g_variant(arg)));
+}
+
+static void op_typed(void *arg)
+{
+	g_variant_unref(g_variant_ref_sink(neardal_record_to_g_variant(arg)));
+}
+
+static void op_decode(void *arg)
+{
+	neardal_free_record(neardal_g_variant_to_record(arg));
+}
+
+int main(void)
+{
+	neardal_record	text = {
+		.name		= "/org/neard/nfc0/tag0/record0",
+		.type		= "Text",
+		.encoding	= "UTF-8",
+		.language	= "en",
+		.representation	= "Hello from neardal",
+	};
+	neardal_record	uri = {
+		.name		= "/org/neard/nfc0/tag0/record1",
+		.type		= "URI",
+		.uri		= "https://example.com/nfc/poster",
+		.uriObjSize	= 30,
+	};
+	GVariant	*a, *b;
+	uint64_t	iters, ns;
+
+	/* Both encoders must agree (entries order aside) */
+	a = g_variant_ref_sink(legacy_record_to_g_variant(&uri));
+	b = g_variant_ref_sink(neardal_record_to_g_variant(&uri));
+	if (g_variant_n_children(a) != g_variant_n_children(b)) {
+		fprintf(stderr, "bench_record: encoders disagree\n");
+		return 1;
+	}
+	g_variant_unref(a);
+	g_variant_unref(b);
+
+	iters = bench_run(op_legacy, &text, &ns);
+	bench_report("record_encode_text_parsed", iters, ns, 0);
+	iters = bench_run(op_typed, &text, &ns);
+	bench_report("record_encode_text_typed", iters, ns, 0);
+
+	iters = bench_run(op_legacy, &uri, &ns);
+	bench_report("record_encode_uri_parsed", iters, ns, 0);
+	iters = bench_run(op_typed, &uri, &ns);
+	bench_report("record_encode_uri_typed", iters, ns, 0);
+
+	a = g_variant_ref_sink(neardal_record_to_g_variant(&text));
+	iters = bench_run(op_decode, a, &ns);
+	bench_report("record_decode_text", iters, ns, 0);
+	g_variant_unref(a);
+
+	a = g_variant_ref_sink(neardal_record_to_g_variant(&uri));
+	iters = bench_run(op_decode, a, &ns);
+	bench_report("record_decode_uri", iters, ns, 0);
+	g_variant_unref(a);
+
+	return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Registry lookups through the public API, against neard_mock on a private
+ * bus ('make bench' runs it once per registry size):
+ *	bench_registry adapters		with neard_mock --adapters=N
+ *	bench_registry tags		with neard_mock --tags=N --records=R
+ * The registry is read once settled, no D-Bus traffic is timed. The object
+ * looked up is the last one listed (worst case).
+ */
+
+#include "bench.h"
+
+#include <string.h>
+#include <glib.h>
+
+#include "neardal.h"
+
+/* Registry settled once unchanged for this long (ms) */
+#define SETTLE_MS	500
+/* Give up waiting for the tags after (s) */
+#define SETTLE_MAX_S	60
+
+static void op_get_adapter(void *arg)
+{
+	neardal_adapter *adp = NULL;
+
+	neardal_get_adapter_properties(arg, &adp);
+	neardal_free_adapter(adp);
+}
+
+static void op_get_tag(void *arg)
+{
+	neardal_tag *tag = NULL;
+
+	neardal_get_tag_properties(arg, &tag);
+	neardal_free_tag(tag);
+}
+
+static void op_get_records(void *arg)
+{
+	char	**array = NULL;
+	int	len;
+
+	neardal_get_records(arg, &array, &len);
+	neardal_free_array(&array);
+}
+
+static void op_get_record(void *arg)
+{
+	const neardal_record *rcd = NULL;
+
+	neardal_get_record_properties_shared(arg, &rcd);
+	neardal_release_record_shared(rcd);
+}
+
+static void on_record_found(const char *rcdName, void *ud)
+{
+	(void) rcdName;
+	(void) ud;
+}
+
+/* Number of tags of 'adapter', once neard_mock stopped adding them */
+static int tags_settle(const char *adapter)
+{
+	char		**tags = NULL;
+	int		len = 0, last = -1;
+	uint64_t	stable = bench_now_ns(), end;
+
+	end = stable + SETTLE_MAX_S * 1000000000ULL;
+	while (bench_now_ns() < end) {
+		while (g_main_context_iteration(NULL, FALSE))
+			;
+		len = 0;
+		if (neardal_get_tags((char *) adapter, &tags, &len) ==
+				NEARDAL_SUCCESS)
+			neardal_free_array(&tags);
+		if (len != last) {
+			last = len;
+			stable = bench_now_ns();
+		} else if (len > 0 &&
+			   bench_now_ns() - stable > SETTLE_MS * 1000000ULL) {
+			return len;
+		}
+		g_usleep(10000);
+	}
+
+	return 0;
+}
+
+static int bench_adapters(char **adapters, int nbAdapters)
+{
+	char		label[64];
+	char		*adapter = adapters[nbAdapters - 1];
+	uint64_t	iters, ns;
+
+	snprintf(label, sizeof(label), "get_adapter_n%d", nbAdapters);
+	iters = bench_run(op_get_adapter, adapter, &ns);
+	bench_report(label, iters, ns, 0);
+
+	return 0;
+}
+
+static int bench_tags(const char *adapter)
+{
+	neardal_tag	*tag = NULL;
+	char		label[64], **tags = NULL, *name;
+	int		nbTags, nbRecords;
+	uint64_t	iters, ns;
+
+	/* Records are only cached once a client wants them */
+	neardal_set_cb_record_found(on_record_found, NULL);
+
+	nbTags = tags_settle(adapter);
+	if (nbTags == 0 ||
+	    neardal_get_tags((char *) adapter, &tags, &nbTags) !=
+			NEARDAL_SUCCESS) {
+		fprintf(stderr, "bench_registry: no tag (--tags?)\n");
+		return 1;
+	}
+	name = tags[nbTags - 1];
+
+	snprintf(label, sizeof(label), "get_tag_n%d", nbTags);
+	iters = bench_run(op_get_tag, name, &ns);
+	bench_report(label, iters, ns, 0);
+
+	if (neardal_get_tag_properties(name, &tag) != NEARDAL_SUCCESS ||
+	    tag->nbRecords == 0) {
+		fprintf(stderr, "bench_registry: no record (--records?)\n");
+		neardal_free_tag(tag);
+		neardal_free_array(&tags);
+		return 1;
+	}
+	nbRecords = nbTags * tag->nbRecords;
+
+	snprintf(label, sizeof(label), "get_records_n%d", nbRecords);
+	iters = bench_run(op_get_records, name, &ns);
+	bench_report(label, iters, ns, 0);
+
+	snprintf(label, sizeof(label), "get_record_n%d", nbRecords);
+	iters = bench_run(op_get_record, tag->records[0], &ns);
+	bench_report(label, iters, ns, 0);
+
+	neardal_free_tag(tag);
+	neardal_free_array(&tags);
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	char	**adapters = NULL;
+	int	len, ret;
+
+	if (argc != 2 || (strcmp(argv[1], "adapters") &&
+			  strcmp(argv[1], "tags"))) {
+		fprintf(stderr, "Usage: bench_registry adapters|tags\n");
+		return 1;
+	}
+
+	if (neardal_get_adapters(&adapters, &len) != NEARDAL_SUCCESS) {
+		fprintf(stderr, "bench_registry: no Neard, run it under "
+			"mock/run-mock.sh\n");
+		return 1;
+	}
+
+	if (!strcmp(argv[1], "adapters"))
+		ret = bench_adapters(adapters, len);
+	else
+		ret = bench_tags(adapters[0]);
+
+	neardal_free_array(&adapters);
+	neardal_destroy();
+
+	return ret;
+}
@@ -20,6 +20,8 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <string.h>
 
@@ -40,6 +42,19 @@ neardalCtx neardalMgr = {.proxy = NULL};
 /*---------------------------------------------------------------------------
  * Context Management
  ---------------------------------------------------------------------------*/
+/*****************************************************************************
+ * neardal_prv_bus_type: bus Neard is looked for on, NEARDAL_BUS=session
+ * selects the session bus (mock daemon on a private bus)
+ ****************************************************************************/
+static GBusType neardal_prv_bus_type(void)
+{
+	const char *bus = getenv("NEARDAL_BUS");
+
+	if (bus != NULL && !strcmp(bus, "session"))
+		return G_BUS_TYPE_SESSION;
+	return NEARDAL_DBUS_TYPE;
+}
+
 /*****************************************************************************
  * neardal_prv_construct: create NEARDAL object instance, Neard Dbus
  * connection, register Neard's events
@@ -48,14 +63,16 @@ void neardal_prv_construct(errorCode_t *ec)
 {
 	errorCode_t	err = NEARDAL_SUCCESS;
 
-	if (neardalMgr.proxy != NULL)
+	/* Connected, or replaying a capture (nothing to connect to) */
+	if (neardalMgr.proxy != NULL || neardalMgr.replay == TRUE)
 		goto exit;
 
 	NEARDAL_TRACEIN();
-	memset(&neardalMgr.conn, 0, sizeof(neardalCtx) - sizeof(neardalCb));
+	memset(&neardalMgr.conn, 0,
+	       sizeof(neardalCtx) - offsetof(neardalCtx, conn));
 
 	/* Create DBUS connection */
-	neardalMgr.conn = g_bus_get_sync(NEARDAL_DBUS_TYPE, NULL,
+	neardalMgr.conn = g_bus_get_sync(neardal_prv_bus_type(), NULL,
 					   &neardalMgr.gerror);
 	if (neardalMgr.conn != NULL) {
 		err = neardal_agent_acquire_dbus_name();
@@ -99,13 +116,46 @@ exit:
 void neardal_destroy(void)
 {
 	NEARDAL_TRACEIN();
-	if (neardalMgr.proxy != NULL) {
+	if (neardalMgr.proxy != NULL || neardalMgr.replay == TRUE) {
 		neardal_tools_prv_free_gerror(&neardalMgr.gerror);
 		neardal_mgr_destroy();
 	}
+	neardalMgr.replay = FALSE;
 	neardal_agent_stop_owning_dbus_name();
 }
 
+/*****************************************************************************
+ * neardal_open_adapter: restrict NEARDAL to one adapter (NULL for all). If
+ * already constructed, the Neard objects registry is built again, agents
+ * stay registered.
+ ****************************************************************************/
+errorCode_t neardal_open_adapter(const char *adpName)
+{
+	errorCode_t	err = NEARDAL_SUCCESS;
+
+	NEARDAL_TRACEIN();
+	if (adpName != NULL && !g_variant_is_object_path(adpName))
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	g_free(neardalMgr.adpScope);
+	neardalMgr.adpScope = g_strdup(adpName);
+
+	if (neardalMgr.proxy == NULL) {
+		neardal_prv_construct(&err);
+		return err;
+	}
+
+	/* Same connection: org.neardal and the agents known by Neard are kept */
+	neardal_mgr_destroy();
+	err = neardal_mgr_create();
+	if (err != NEARDAL_SUCCESS)
+		NEARDAL_TRACEF("neardal_mgr_create() exit (err %d: %s)\n",
+			       err, neardal_error_get_text(err));
+	neardal_tools_prv_free_gerror(&neardalMgr.gerror);
+
+	return err;
+}
+
 /*****************************************************************************
  * neardal_set_cb_adapter_added: setup a client callback for
  * 'NEARDAL adapter added'.
@@ -242,6 +292,9 @@ errorCode_t neardal_set_cb_record_found(record_cb cb_rcd_found,
 	if (neardalMgr.proxy == NULL)
 		neardal_prv_construct(NULL);
 
+	if (cb_rcd_found != NULL)
+		neardal_mgr_prv_want_records();
+
 	return NEARDAL_SUCCESS;
 }
 
@@ -480,6 +533,7 @@ errorCode_t neardal_set_adapter_property(const char *adpName,
 	const gchar	*propKey	= NULL;
 	GVariant	*propValue	= NULL;
 	GVariant	*variantTmp	= NULL;
+	guint64		start;
 
 	if (neardalMgr.proxy == NULL)
 		neardal_prv_construct(&err);
@@ -504,10 +558,13 @@ errorCode_t neardal_set_adapter_property(const char *adpName,
 	propValue = g_variant_new_variant(variantTmp);
 	g_variant_ref_sink(propValue);
 	NEARDAL_TRACE_LOG("Sending:\n%s=%s\n", propKey,
-			  g_variant_print(propValue, TRUE));
+			  neardal_trace_variant(propValue));
 
+	start = neardal_stats_call_begin(NEARDAL_METHOD_SET_PROPERTY);
 	properties_call_set_sync(adpProp->props, "org.neard.Adapter",
 				propKey, propValue, 0, &neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_SET_PROPERTY, start,
+			   neardalMgr.gerror == NULL);
 
 	if (neardalMgr.gerror == NULL)
 		err = NEARDAL_SUCCESS;
@@ -520,6 +577,8 @@ errorCode_t neardal_set_adapter_property(const char *adpName,
 	}
 
 exit:
+	NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_ADP_SET_PROP, adpName, adpPropId,
+			    err);
 	neardal_tools_prv_free_gerror(&neardalMgr.gerror);
 	neardalMgr.gerror = NULL;
 	g_variant_unref(propValue);
@@ -534,6 +593,7 @@ errorCode_t neardal_start_poll_loop(char *adpName, int mode)
 {
 	errorCode_t	err		= NEARDAL_SUCCESS;
 	AdpProp		*adpProp	= NULL;
+	guint64		start;
 
 	if (neardalMgr.proxy == NULL)
 		neardal_prv_construct(&err);
@@ -553,6 +613,7 @@ errorCode_t neardal_start_poll_loop(char *adpName, int mode)
 		goto exit;
 	}
 
+	start = neardal_stats_call_begin(NEARDAL_METHOD_START_POLL_LOOP);
 	if (mode == NEARD_ADP_MODE_INITIATOR)
 		org_neard_adapter_call_start_poll_loop_sync(adpProp->proxy,
 							ADP_MODE_INITIATOR,
@@ -571,6 +632,8 @@ errorCode_t neardal_start_poll_loop(char *adpName, int mode)
 							, ADP_MODE_INITIATOR
 							, NULL,
 							&neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_START_POLL_LOOP, start,
+			   neardalMgr.gerror == NULL);
 
 	if (neardalMgr.gerror != NULL) {
 		NEARDAL_TRACE_ERR(
@@ -582,6 +645,7 @@ errorCode_t neardal_start_poll_loop(char *adpName, int mode)
 	}
 
 exit:
+	NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_POLL, adpName, mode, err);
 	return err;
 }
 
@@ -592,6 +656,7 @@ errorCode_t neardal_stop_poll(char *adpName)
 {
 	errorCode_t	err = NEARDAL_SUCCESS;
 	AdpProp		*adpProp	= NULL;
+	guint64		start;
 
 	if (neardalMgr.proxy == NULL)
 		neardal_prv_construct(&err);
@@ -606,8 +671,11 @@ errorCode_t neardal_stop_poll(char *adpName)
 		goto exit;
 
 	if (adpProp->polling) {
+		start = neardal_stats_call_begin(NEARDAL_METHOD_STOP_POLL_LOOP);
 		org_neard_adapter_call_stop_poll_loop_sync(adpProp->proxy, NULL,
 						   &neardalMgr.gerror);
+		neardal_stats_call(NEARDAL_METHOD_STOP_POLL_LOOP, start,
+				   neardalMgr.gerror == NULL);
 
 		err = NEARDAL_SUCCESS;
 		if (neardalMgr.gerror != NULL) {
@@ -621,6 +689,7 @@ errorCode_t neardal_stop_poll(char *adpName)
 	}
 
 exit:
+	NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_POLL, adpName, -1, err);
 	return err;
 }
 
@@ -949,6 +1018,7 @@ exit:
  *****************************************************************************/
 errorCode_t neardal_get_records(char *tag, char ***array, int *len)
 {
+	errorCode_t err = NEARDAL_SUCCESS;
 	GVariant **data = NULL;
 	guint data_len, i;
 	char *prefix;
@@ -956,6 +1026,12 @@ errorCode_t neardal_get_records(char *tag, char ***array, int *len)
 	if (tag == NULL || array == NULL || len == NULL)
 		return NEARDAL_ERROR_INVALID_PARAMETER;
 
+	neardal_prv_construct(&err);
+	if (err != NEARDAL_SUCCESS)
+		return err;
+
+	neardal_mgr_prv_want_records();
+
 	prefix = g_strconcat(tag, "/", NULL);
 	data_len = neardal_data_to_arrayv((void ***) &data);
 
@@ -985,6 +1061,8 @@ errorCode_t neardal_get_record_properties(const char *name,
 	if (err != NEARDAL_SUCCESS)
 		goto exit;
 
+	neardal_mgr_prv_want_records();
+
 	if (!(data = g_datalist_get_data(&(neardalMgr.dbus_data), name))) {
 		err = NEARDAL_ERROR_NO_RECORD;
 		goto exit;
@@ -995,64 +1073,86 @@ exit:
 	return err;
 }
 
+errorCode_t neardal_get_record_properties_shared(const char *name,
+						 const neardal_record **record)
+{
+	errorCode_t err = NEARDAL_SUCCESS;
+	GVariant *data;
+
+	NEARDAL_ASSERT_RET(name != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
+	NEARDAL_ASSERT_RET(record != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
+
+	neardal_prv_construct(&err);
+	if (err != NEARDAL_SUCCESS)
+		goto exit;
+
+	neardal_mgr_prv_want_records();
+
+	if (!(data = g_datalist_get_data(&(neardalMgr.dbus_data), name))) {
+		err = NEARDAL_ERROR_NO_RECORD;
+		goto exit;
+	}
+
+	*record = neardal_record_cache_prv_get(data);
+exit:
+	return err;
+}
+
 /*---------------------------------------------------------------------------
  * NFC Agent Management
  ---------------------------------------------------------------------------*/
 /*****************************************************************************
- * neardal_agent_set_NDEF_cb: register or unregister a callback to handle a
- * record macthing a registered tag type. This callback will received the
- * whole NDEF as a raw byte stream and the records object paths.
- * If the callback is null, the agent is unregistered
+ * neardal_agent_prv_set_NDEF: register or unregister (no callback set in
+ * 'agent') the NDEF agent of a tag type
  ****************************************************************************/
-errorCode_t neardal_agent_set_NDEF_cb(char *tagType
-				     , ndef_agent_cb cb_ndef_agent
-				     , ndef_agent_free_cb cb_ndef_release_agent
-				     , void *user_data)
+static errorCode_t neardal_agent_prv_set_NDEF(const char *tagType,
+					      neardal_ndef_agent_t *agent)
 {
 	errorCode_t		err	= NEARDAL_ERROR_INVALID_PARAMETER;
-	neardal_ndef_agent_t	agent;
+	guint64			start;
 
-
-	memset(&agent, 0, sizeof(neardal_ndef_agent_t));
 	if (tagType == NULL)
 		goto exit;
 	err = NEARDAL_ERROR_NO_MEMORY;
 
-	agent.cb_ndef_agent		= cb_ndef_agent;
-	agent.cb_ndef_release_agent	= cb_ndef_release_agent;
-	agent.pid			= getpid();
-	agent.user_data			= user_data;
-	agent.tagType			= g_strdup(tagType);
+	agent->pid			= getpid();
+	/* Kept as is to register the agent again after a Neard restart */
+	agent->tagType			= g_strdup(tagType);
 	{ /* replace ':' with '_' */
-		int len = strlen(agent.tagType);
-		while (len > 0) {
-			if (agent.tagType[len] == ':')
-				agent.tagType[len] = '_';
-			len--;
-		}
+		gchar *objName = g_strdelimit(g_strdup(tagType), ":", '_');
+
+		agent->objPath = g_strdup_printf("%s/%s/%d",
+						AGENT_PREFIX,
+						objName,
+						agent->pid);
+		g_free(objName);
 	}
-	agent.objPath = g_strdup_printf("%s/%s/%d", 
-					AGENT_PREFIX, 
-					agent.tagType,
-					agent.pid);
-	if (agent.objPath == NULL)
+	if (agent->objPath == NULL)
 		goto exit;
 
-	if (cb_ndef_agent != NULL)
+	if (NEARDAL_NDEF_AGENT_SET(agent)) {
 		/* RegisterNDEFAgent */
+		start = neardal_stats_call_begin(
+					NEARDAL_METHOD_REGISTER_NDEF_AGENT);
 		org_neard_manager_call_register_ndefagent_sync(neardalMgr.proxy,
-							     agent.objPath,
+							     agent->objPath,
 							     tagType, NULL,
 							&neardalMgr.gerror);
-	else
+		neardal_stats_call(NEARDAL_METHOD_REGISTER_NDEF_AGENT, start,
+				   neardalMgr.gerror == NULL);
+	} else {
 		/* UnregisterNDEFAgent */
+		start = neardal_stats_call_begin(
+					NEARDAL_METHOD_UNREGISTER_NDEF_AGENT);
 		org_neard_manager_call_unregister_ndefagent_sync(neardalMgr.proxy,
-							    agent.objPath,
+							    agent->objPath,
 							    tagType, NULL,
 							 &neardalMgr.gerror);
+		neardal_stats_call(NEARDAL_METHOD_UNREGISTER_NDEF_AGENT, start,
+				   neardalMgr.gerror == NULL);
+	}
 
-
-	err = neardal_ndefagent_prv_manage(agent);
+	err = neardal_ndefagent_prv_manage(*agent);
 	if (err != NEARDAL_SUCCESS)
 		goto exit;
 
@@ -1068,65 +1168,120 @@ errorCode_t neardal_agent_set_NDEF_cb(char *tagType
 exit:
 	if (err != NEARDAL_SUCCESS)
 		neardal_tools_prv_free_gerror(&neardalMgr.gerror);
-	g_free(agent.objPath);
-	g_free(agent.tagType);
+	g_free(agent->objPath);
+	g_free(agent->tagType);
 
 	return err;
 }
 
 /*****************************************************************************
- * neardal_agent_set_handover_cb: register or unregister two callbacks to
- * handle handover connection. Two callbacks are used, the first one
- * (oob_request) is used to get Out Of Band data, the second one (oob_push) is
- * used to pass remote Out Of Band data.
- * If one of this callback is null, the agent is unregistered
+ * neardal_agent_set_NDEF_cb: register or unregister a callback to handle a
+ * record macthing a registered tag type. This callback will received the
+ * whole NDEF as a raw byte stream and the records object paths.
+ * If the callback is null, the agent is unregistered
  ****************************************************************************/
-errorCode_t neardal_agent_set_handover_cb(
-						const gchar* carrier
-					  , oob_push_agent_cb cb_oob_push_agent
-					  , oob_req_agent_cb  cb_oob_req_agent
-				, oob_agent_free_cb cb_oob_release_agent
-					  , void *user_data)
+errorCode_t neardal_agent_set_NDEF_cb(char *tagType
+				     , ndef_agent_cb cb_ndef_agent
+				     , ndef_agent_free_cb cb_ndef_release_agent
+				     , void *user_data)
 {
-	errorCode_t			err;
-	neardal_handover_agent_t	agent;
+	neardal_ndef_agent_t	agent;
 
+	memset(&agent, 0, sizeof(neardal_ndef_agent_t));
+	agent.cb_ndef_agent		= cb_ndef_agent;
+	agent.cb_ndef_release_agent	= cb_ndef_release_agent;
+	agent.user_data			= user_data;
 
-	err = NEARDAL_ERROR_NO_MEMORY;
+	return neardal_agent_prv_set_NDEF(tagType, &agent);
+}
 
-	memset(&agent, 0, sizeof(neardal_handover_agent_t));
-	agent.cb_oob_push_agent		= cb_oob_push_agent;
-	agent.cb_oob_req_agent		= cb_oob_req_agent;
-	agent.cb_oob_release_agent	= cb_oob_release_agent;
-	agent.pid			= getpid();
+/*****************************************************************************
+ * neardal_agent_set_NDEF_bytes_cb: same as neardal_agent_set_NDEF_cb(), the
+ * NDEF and records object paths are given without copy
+ ****************************************************************************/
+errorCode_t neardal_agent_set_NDEF_bytes_cb(const char *tagType
+				     , ndef_agent_bytes_cb cb_ndef_agent
+				     , ndef_agent_free_cb cb_ndef_release_agent
+				     , void *user_data)
+{
+	neardal_ndef_agent_t	agent;
+
+	memset(&agent, 0, sizeof(neardal_ndef_agent_t));
+	agent.cb_ndef_bytes_agent	= cb_ndef_agent;
+	agent.cb_ndef_release_agent	= cb_ndef_release_agent;
 	agent.user_data			= user_data;
-	agent.objPath			= g_strdup_printf("%s/handover/%d"
+
+	return neardal_agent_prv_set_NDEF(tagType, &agent);
+}
+
+/*****************************************************************************
+ * neardal_agent_set_NDEF_async_cb: same as neardal_agent_set_NDEF_bytes_cb(),
+ * the call is acknowledged later with neardal_agent_complete_ndef()
+ ****************************************************************************/
+errorCode_t neardal_agent_set_NDEF_async_cb(const char *tagType
+				     , ndef_agent_async_cb cb_ndef_agent
+				     , ndef_agent_free_cb cb_ndef_release_agent
+				     , void *user_data)
+{
+	neardal_ndef_agent_t	agent;
+
+	memset(&agent, 0, sizeof(neardal_ndef_agent_t));
+	agent.cb_ndef_async_agent	= cb_ndef_agent;
+	agent.cb_ndef_release_agent	= cb_ndef_release_agent;
+	agent.user_data			= user_data;
+
+	return neardal_agent_prv_set_NDEF(tagType, &agent);
+}
+
+/*****************************************************************************
+ * neardal_agent_prv_set_handover: create and register, or unregister (no
+ * callbacks set in 'agent'), the handover agent of a carrier
+ ****************************************************************************/
+static errorCode_t neardal_agent_prv_set_handover(const gchar *carrier,
+					neardal_handover_agent_t *agent)
+{
+	errorCode_t			err;
+	guint64				start;
+
+	err = NEARDAL_ERROR_NO_MEMORY;
+
+	agent->pid			= getpid();
+	agent->objPath			= g_strdup_printf("%s/handover/%d"
 							 , AGENT_PREFIX
-							 , agent.pid);
-	agent.carrierType	= g_strdup(carrier);
-	if (agent.objPath == NULL)
+							 , agent->pid);
+	agent->carrierType	= g_strdup(carrier);
+	if (agent->objPath == NULL)
 		goto exit;
 
-	err = neardal_handoveragent_prv_manage(agent);
+	err = neardal_handoveragent_prv_manage(*agent);
 	if (err != NEARDAL_SUCCESS)
 		goto exit;
 
-	if (cb_oob_push_agent != NULL && cb_oob_req_agent != NULL)
+	if (NEARDAL_HANDOVER_AGENT_SET(agent)) {
 		/* RegisterHandoverAgent */
+		start = neardal_stats_call_begin(
+				NEARDAL_METHOD_REGISTER_HANDOVER_AGENT);
 		org_neard_manager_call_register_handover_agent_sync(
 							       neardalMgr.proxy,
-							       agent.objPath,
-							       agent.carrierType,
+							       agent->objPath,
+							       agent->carrierType,
 							       NULL,
 							   &neardalMgr.gerror);
-	else
+		neardal_stats_call(NEARDAL_METHOD_REGISTER_HANDOVER_AGENT,
+				   start, neardalMgr.gerror == NULL);
+	} else {
 		/* UnregisterHandoverAgent */
+		start = neardal_stats_call_begin(
+				NEARDAL_METHOD_UNREGISTER_HANDOVER_AGENT);
 		org_neard_manager_call_unregister_handover_agent_sync(
 							neardalMgr.proxy,
-							agent.objPath,
-							agent.carrierType,
+							agent->objPath,
+							agent->carrierType,
 							NULL,
 							 &neardalMgr.gerror);
+		neardal_stats_call(NEARDAL_METHOD_UNREGISTER_HANDOVER_AGENT,
+				   start, neardalMgr.gerror == NULL);
+	}
 
 
 	if (neardalMgr.gerror != NULL) {
@@ -1141,7 +1296,76 @@ errorCode_t neardal_agent_set_handover_cb(
 exit:
 	if (err != NEARDAL_SUCCESS)
 		neardal_tools_prv_free_gerror(&neardalMgr.gerror);
-	g_free(agent.objPath);
+	g_free(agent->objPath);
+	g_free(agent->carrierType);
 
 	return err;
 }
+
+/*****************************************************************************
+ * neardal_agent_set_handover_cb: register or unregister two callbacks to
+ * handle handover connection. Two callbacks are used, the first one
+ * (oob_request) is used to get Out Of Band data, the second one (oob_push) is
+ * used to pass remote Out Of Band data.
+ * If one of this callback is null, the agent is unregistered
+ ****************************************************************************/
+errorCode_t neardal_agent_set_handover_cb(
+						const gchar* carrier
+					  , oob_push_agent_cb cb_oob_push_agent
+					  , oob_req_agent_cb  cb_oob_req_agent
+				, oob_agent_free_cb cb_oob_release_agent
+					  , void *user_data)
+{
+	neardal_handover_agent_t	agent;
+
+	memset(&agent, 0, sizeof(neardal_handover_agent_t));
+	agent.cb_oob_push_agent		= cb_oob_push_agent;
+	agent.cb_oob_req_agent		= cb_oob_req_agent;
+	agent.cb_oob_release_agent	= cb_oob_release_agent;
+	agent.user_data			= user_data;
+
+	return neardal_agent_prv_set_handover(carrier, &agent);
+}
+
+/*****************************************************************************
+ * neardal_agent_set_handover_bytes_cb: same as neardal_agent_set_handover_cb()
+ * with Out Of Band data exchanged as GBytes, without copy
+ ****************************************************************************/
+errorCode_t neardal_agent_set_handover_bytes_cb(const gchar *carrier
+				, oob_push_bytes_agent_cb cb_oob_push_agent
+				, oob_req_bytes_agent_cb cb_oob_req_agent
+				, oob_agent_free_cb cb_oob_release_agent
+				, void *user_data)
+{
+	neardal_handover_agent_t	agent;
+
+	memset(&agent, 0, sizeof(neardal_handover_agent_t));
+	agent.cb_oob_push_bytes_agent	= cb_oob_push_agent;
+	agent.cb_oob_req_bytes_agent	= cb_oob_req_agent;
+	agent.cb_oob_release_agent	= cb_oob_release_agent;
+	agent.user_data			= user_data;
+
+	return neardal_agent_prv_set_handover(carrier, &agent);
+}
+
+/*****************************************************************************
+ * neardal_agent_set_handover_async_cb: same as
+ * neardal_agent_set_handover_bytes_cb(), Out Of Band data are given later
+ * with neardal_agent_complete_oob()
+ ****************************************************************************/
+errorCode_t neardal_agent_set_handover_async_cb(const gchar *carrier
+				, oob_push_bytes_agent_cb cb_oob_push_agent
+				, oob_req_async_agent_cb cb_oob_req_agent
+				, oob_agent_free_cb cb_oob_release_agent
+				, void *user_data)
+{
+	neardal_handover_agent_t	agent;
+
+	memset(&agent, 0, sizeof(neardal_handover_agent_t));
+	agent.cb_oob_push_bytes_agent	= cb_oob_push_agent;
+	agent.cb_oob_req_async_agent	= cb_oob_req_agent;
+	agent.cb_oob_release_agent	= cb_oob_release_agent;
+	agent.user_data			= user_data;
+
+	return neardal_agent_prv_set_handover(carrier, &agent);
+}
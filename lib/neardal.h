@@ -29,7 +29,15 @@
 
 #ifndef NEARDAL_H
 #define NEARDAL_H
+
+#include <stdint.h>
+
 #include "neardal_errors.h"
+#include "neardal_ndef.h"
+#include "neardal_oob.h"
+#include "neardal_trace_ring.h"
+#include "neardal_timeline.h"
+#include "neardal_capture.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -135,6 +143,31 @@ typedef struct {
 	unsigned int uriObjSize;/**< URI object size. */
 } neardal_record;
 
+/*! @brief neardal_record string fields, in structure order */
+typedef enum {
+	NEARDAL_RECORD_FIELD_ACTION,
+	NEARDAL_RECORD_FIELD_CARRIER,
+	NEARDAL_RECORD_FIELD_ENCODING,
+	NEARDAL_RECORD_FIELD_LANGUAGE,
+	NEARDAL_RECORD_FIELD_MIME,
+	NEARDAL_RECORD_FIELD_NAME,
+	NEARDAL_RECORD_FIELD_REPRESENTATION,
+	NEARDAL_RECORD_FIELD_TYPE,
+	NEARDAL_RECORD_FIELD_SSID,
+	NEARDAL_RECORD_FIELD_PASSPHRASE,
+	NEARDAL_RECORD_FIELD_ENCRYPTION,
+	NEARDAL_RECORD_FIELD_AUTHENTICATION,
+	NEARDAL_RECORD_FIELD_URI,
+	NEARDAL_RECORD_FIELD_COUNT
+} neardal_record_field;
+
+/**
+ * NFC record in a single memory block (a 32 bytes header of field offsets
+ * followed by the strings), for records kept in large numbers. Opaque, see
+ * neardal_record_compact(). Release with neardal_compact_record_free().
+ */
+typedef struct neardal_compact_record neardal_compact_record;
+
 /* @}*/
 
 /*! @brief NEARDAL Callbacks
@@ -203,6 +236,19 @@ typedef void (*ndef_agent_cb) (unsigned char **rcdArray, unsigned int rcdLen,
 			       unsigned char *ndefArray, unsigned int ndefLen,
 			       void *user_data);
 
+/**
+ * @brief Callback prototype for a registered tag type, without copy. Records
+ * paths and NDEF point into the D-Bus message.
+ *
+ * @param records NULL terminated array of records path (as identifier=dbus
+ * object path), empty (never NULL) without records, valid during the call
+ * only
+ * @param ndef raw NDEF data, take a reference (g_bytes_ref()) to keep it
+ * @param user_data Client user data
+ **/
+typedef void (*ndef_agent_bytes_cb) (const char * const *records, GBytes *ndef,
+				     void *user_data);
+
 /**
  * @brief Callback prototype to cleanup agent user data. Gets called when
  * Neard unregisters the agent.
@@ -261,6 +307,115 @@ typedef void (*oob_push_agent_cb) (unsigned char *blobEIR,
  **/
 typedef void (*oob_agent_free_cb) (void *user_data);
 
+/**
+ * @brief Callback prototype to get Out Of Band data from the handover agent,
+ * without copy
+ *
+ * @param blob remote Out Of Band blob (EIR, WSC...) of the request, pointing
+ * into the D-Bus message (empty if none), take a reference (g_bytes_ref()) to
+ * keep it
+ * @param user_data Client user data
+ * @return Out Of Band data used to build a Handover Request or Select message
+ * (the reference is given to neardal), NULL on error
+ **/
+typedef GBytes *(*oob_req_bytes_agent_cb) (GBytes *blob, void *user_data);
+
+/**
+ * @brief Callback prototype to pass remote Out Of Band data to agent to
+ * start handover, without copy
+ *
+ * @param blob remote Out Of Band blob, take a reference to keep it
+ * @param user_data Client user data
+ **/
+typedef void (*oob_push_bytes_agent_cb) (GBytes *blob, void *user_data);
+
+/**
+ * @brief Pending agent call, handed to an asynchronous agent callback and
+ * given back to @link neardal_agent_complete_oob @endlink or
+ * @link neardal_agent_complete_ndef @endlink (exactly once). If the agent is
+ * released (or neardal destroyed) first, Neard gets an error reply right
+ * away and completing the call only frees it.
+ **/
+typedef struct neardal_agent_invocation neardal_agent_invocation;
+
+/**
+ * @brief Callback prototype for a registered tag type, acknowledged later
+ * with @link neardal_agent_complete_ndef @endlink
+ *
+ * @param inv pending call
+ * @param records NULL terminated array of records path, empty (never NULL)
+ * without records, valid during the call only
+ * @param ndef raw NDEF data, take a reference (g_bytes_ref()) to keep it
+ * @param user_data Client user data
+ **/
+typedef void (*ndef_agent_async_cb) (neardal_agent_invocation *inv,
+				     const char * const *records, GBytes *ndef,
+				     void *user_data);
+
+/**
+ * @brief Callback prototype to get Out Of Band data from the handover agent,
+ * given later with @link neardal_agent_complete_oob @endlink. Neardal keeps
+ * on dispatching events meanwhile.
+ *
+ * @param inv pending call
+ * @param blob remote Out Of Band blob of the request (empty if none), take a
+ * reference (g_bytes_ref()) to keep it
+ * @param user_data Client user data
+ **/
+typedef void (*oob_req_async_agent_cb) (neardal_agent_invocation *inv,
+					GBytes *blob, void *user_data);
+
+/*!
+ * @brief NEARDAL event kinds (see @link neardal_add_listener @endlink)
+ **/
+typedef enum {
+	NEARDAL_EVENT_ADAPTER_ADDED = 0,
+	NEARDAL_EVENT_ADAPTER_REMOVED,
+	NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED,
+	NEARDAL_EVENT_TAG_FOUND,
+	NEARDAL_EVENT_TAG_LOST,
+	NEARDAL_EVENT_DEV_FOUND,
+	NEARDAL_EVENT_DEV_LOST,
+	NEARDAL_EVENT_RECORD_FOUND,
+	NEARDAL_EVENT_COUNT
+} neardal_event;
+
+/*! @brief Bit of an event kind in @link neardal_listener_filter @endlink */
+#define NEARDAL_EVENT_MASK(ev)		(1U << (ev))
+/*! @brief All event kinds */
+#define NEARDAL_EVENT_MASK_ALL		(NEARDAL_EVENT_MASK(NEARDAL_EVENT_COUNT) - 1)
+
+/*!
+ * @brief NEARDAL listener filter. NULL (or 0) members match everything.
+ * A predicate only applies to events carrying the attribute: tag type for
+ * tags and their records, record type for records.
+ **/
+typedef struct {
+/*! @brief Adapter DBus object path */
+	const char	*adpName;
+/*! @brief Tag type (as in neardal_tag type, e.g. "Type 2") */
+	const char	*tagType;
+/*! @brief Record type (as in neardal_record type, e.g. "URI") */
+	const char	*rcdType;
+/*! @brief Event kinds, NEARDAL_EVENT_MASK() bits */
+	unsigned int	events;
+} neardal_listener_filter;
+
+/*!
+ * @brief NEARDAL listener callbacks. NULL members are not subscribed.
+ **/
+typedef struct {
+	adapter_cb	adp_added;		/**< 'adapter added' */
+	adapter_cb	adp_removed;		/**< 'adapter removed' */
+	adapter_prop_cb	adp_prop_changed;	/**< 'adapter property
+						changed' */
+	tag_cb		tag_found;		/**< 'tag found' */
+	tag_cb		tag_lost;		/**< 'tag lost' */
+	dev_cb		dev_found;		/**< 'device found' */
+	dev_cb		dev_lost;		/**< 'device lost' */
+	record_cb	rcd_found;		/**< 'record found' */
+} neardal_listener_cb;
+
 /* @}*/
 
 
@@ -312,6 +467,19 @@ errorCode_t neardal_start_poll_loop(char *adpName, int mode);
 */
 errorCode_t neardal_stop_poll(char *adpName);
 
+/*! \fn errorCode_t neardal_open_adapter(const char *adpName)
+ * @brief Restrict NEARDAL to one adapter. Only this adapter (and its tags,
+ * devices and records) is managed, and the DBus match rules are installed
+ * for it only: the bus daemon drops the traffic of the other adapters.
+ * If NEARDAL is already in use, the known Neard objects are read again for
+ * the new adapter; registered agents are kept.
+ *
+ * @param adpName DBus interface adapter name (as identifier=dbus object
+ * path), NULL to manage all adapters again
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_open_adapter(const char *adpName);
+
 /*! \fn errorCode_t neardal_get_adapters(char ***array, int *len)
  * @brief get an array of NEARDAL adapters present
  *
@@ -551,6 +719,41 @@ errorCode_t neardal_set_cb_dev_lost(dev_cb cb_dev_lost,
 errorCode_t neardal_get_record_properties(const char *recordName,
 					  neardal_record **record);
 
+/*! \fn errorCode_t neardal_get_record_properties_shared(
+ * const char *recordName, const neardal_record **record)
+ * @brief Get properties of a record as a shared, read only, decoded record.
+ * Records of same content (e.g. the same tag tapped again) get the same
+ * decoded record when the record cache is enabled (see
+ * @link neardal_record_cache_set_size @endlink). As it may come from another
+ * tag, the 'name' field of a shared record is NULL.
+ *
+ * @param recordName DBus interface record name (as identifier=dbus object path)
+ * @param record shared record, release with
+ * @link neardal_release_record_shared @endlink
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_get_record_properties_shared(const char *recordName,
+						 const neardal_record **record);
+
+/*! \fn void neardal_release_record_shared(const neardal_record *record)
+ * @brief Release a record got with
+ * @link neardal_get_record_properties_shared @endlink
+ *
+ * @param record shared record
+ * @return nothing
+ **/
+void neardal_release_record_shared(const neardal_record *record);
+
+/*! \fn errorCode_t neardal_record_cache_set_size(unsigned int size)
+ * @brief Set the number of distinct record contents kept decoded for
+ * @link neardal_get_record_properties_shared @endlink, least recently used
+ * ones are evicted first. Disabled (0) by default.
+ *
+ * @param size number of record contents kept, 0 to disable the cache
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_record_cache_set_size(unsigned int size);
+
 /*! \fn void neardal_free_record(neardal_record *record)
  * @brief Release memory allocated for properties of a record
  *
@@ -572,6 +775,30 @@ void neardal_free_record(neardal_record *record);
 errorCode_t neardal_set_cb_record_found(record_cb cb_rcd_found,
 					 void *user_data);
 
+/*! \fn unsigned int neardal_add_listener(
+ * const neardal_listener_filter *filter, const neardal_listener_cb *cb,
+ * void *user_data)
+ * @brief Add a client listener. Unlike neardal_set_cb_xxx(), several
+ * listeners can be registered, each one receiving the events matching its
+ * filter. The callbacks set with neardal_set_cb_xxx() are invoked first.
+ *
+ * @param filter Events filter (optional, NULL for all events)
+ * @param cb Client callbacks (copied)
+ * @param user_data Client user data given to all callbacks
+ * @return listener identifier, 0 on error
+ **/
+unsigned int neardal_add_listener(const neardal_listener_filter *filter,
+				  const neardal_listener_cb *cb,
+				  void *user_data);
+
+/*! \fn errorCode_t neardal_remove_listener(unsigned int id)
+ * @brief Remove a client listener (can be called from its callbacks)
+ *
+ * @param id listener identifier returned by neardal_add_listener()
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_remove_listener(unsigned int id);
+
 /*! \fn errorCode_t neardal_agent_set_NDEF_cb(char *tagType, agent_cb cb_agent,
  * void *user_data)
  * @brief register or unregister a callback to handle a record macthing
@@ -589,6 +816,53 @@ errorCode_t neardal_agent_set_NDEF_cb(char *tagType
 				     , ndef_agent_free_cb cb_ndef_release_agent
 				      , void *user_data);
 
+/*! \fn errorCode_t neardal_agent_set_NDEF_bytes_cb(const char *tagType,
+ * ndef_agent_bytes_cb cb_ndef_agent, ndef_agent_free_cb cb_ndef_release_agent,
+ * void *user_data)
+ * @brief Same as @link neardal_agent_set_NDEF_cb @endlink, the NDEF and the
+ * records paths reach the callback without being copied.
+ * If the callback is null, the agent is unregistered.
+ * @param tagType tag type to register
+ * @param cb_ndef_agent Client callback for the registered tag type
+ * @param cb_ndef_release_agent Client callback to cleanup agent user data
+ * @param user_data Client user data
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_agent_set_NDEF_bytes_cb(const char *tagType
+				      , ndef_agent_bytes_cb cb_ndef_agent
+				     , ndef_agent_free_cb cb_ndef_release_agent
+				      , void *user_data);
+
+/*! \fn errorCode_t neardal_agent_set_NDEF_async_cb(const char *tagType,
+ * ndef_agent_async_cb cb_ndef_agent, ndef_agent_free_cb cb_ndef_release_agent,
+ * void *user_data)
+ * @brief Same as @link neardal_agent_set_NDEF_bytes_cb @endlink, Neard is
+ * answered when the client calls @link neardal_agent_complete_ndef @endlink.
+ * If the callback is null, the agent is unregistered.
+ * @param tagType tag type to register
+ * @param cb_ndef_agent Client callback for the registered tag type
+ * @param cb_ndef_release_agent Client callback to cleanup agent user data
+ * @param user_data Client user data
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_agent_set_NDEF_async_cb(const char *tagType
+				      , ndef_agent_async_cb cb_ndef_agent
+				     , ndef_agent_free_cb cb_ndef_release_agent
+				      , void *user_data);
+
+/*! \fn errorCode_t neardal_agent_complete_ndef(neardal_agent_invocation *inv,
+ * errorCode_t status)
+ * @brief Answer a GetNDEF call given to an asynchronous NDEF agent. May be
+ * called from any thread, the reply is sent from the thread running neardal
+ * main loop.
+ * @param inv pending call (released)
+ * @param status NEARDAL_SUCCESS, or the error returned to Neard
+ * @return errorCode_t error code, NEARDAL_ERROR_GENERAL_ERROR if the call was
+ * aborted on agent release
+ **/
+errorCode_t neardal_agent_complete_ndef(neardal_agent_invocation *inv,
+					errorCode_t status);
+
 
 /*! \fn errorCode_t neardal_agent_set_handover_cb(
  * 					  const gchar* carrier
@@ -611,6 +885,89 @@ errorCode_t neardal_agent_set_handover_cb(
 				, oob_agent_free_cb cb_oob_release_agent
 					  , void *user_data);
 
+/*! \fn errorCode_t neardal_agent_set_handover_bytes_cb(
+ *					  const gchar *carrier
+ *					, oob_push_bytes_agent_cb cb_oob_push_agent
+ *					, oob_req_bytes_agent_cb cb_oob_req_agent
+ *					, oob_agent_free_cb cb_oob_release_agent
+ *					, void *user_data)
+ * @brief Same as @link neardal_agent_set_handover_cb @endlink, the Out Of
+ * Band data are exchanged as GBytes, without copy.
+ * If one of this callback is null, the agent is unregistered.
+ * @param carrier carrier type ("bluetooth" and "wifi" are valid choices)
+ * @param cb_oob_push_agent used to pass remote Out Of Band data
+ * @param cb_oob_req_agent used to get Out Of Band data
+ * @param cb_oob_release_agent used to cleanup agent user data
+ * @param user_data Client user data
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_agent_set_handover_bytes_cb(const gchar *carrier
+				, oob_push_bytes_agent_cb cb_oob_push_agent
+				, oob_req_bytes_agent_cb cb_oob_req_agent
+				, oob_agent_free_cb cb_oob_release_agent
+				, void *user_data);
+
+/*! \fn errorCode_t neardal_agent_set_handover_async_cb(
+ *					  const gchar *carrier
+ *					, oob_push_bytes_agent_cb cb_oob_push_agent
+ *					, oob_req_async_agent_cb cb_oob_req_agent
+ *					, oob_agent_free_cb cb_oob_release_agent
+ *					, void *user_data)
+ * @brief Same as @link neardal_agent_set_handover_bytes_cb @endlink, the Out
+ * Of Band data are given later with @link neardal_agent_complete_oob @endlink,
+ * so that a slow lookup does not block neardal main loop.
+ * If one of this callback is null, the agent is unregistered.
+ * @param carrier carrier type ("bluetooth" and "wifi" are valid choices)
+ * @param cb_oob_push_agent used to pass remote Out Of Band data
+ * @param cb_oob_req_agent used to request Out Of Band data
+ * @param cb_oob_release_agent used to cleanup agent user data
+ * @param user_data Client user data
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_agent_set_handover_async_cb(const gchar *carrier
+				, oob_push_bytes_agent_cb cb_oob_push_agent
+				, oob_req_async_agent_cb cb_oob_req_agent
+				, oob_agent_free_cb cb_oob_release_agent
+				, void *user_data);
+
+/*! \fn errorCode_t neardal_agent_complete_oob(neardal_agent_invocation *inv,
+ * const unsigned char *data, unsigned int len)
+ * @brief Give the Out Of Band data requested from an asynchronous handover
+ * agent. May be called from any thread, the reply is sent from the thread
+ * running neardal main loop.
+ * @param inv pending call (released)
+ * @param data Out Of Band data (copied), NULL to answer with an error
+ * @param len Out Of Band data length
+ * @return errorCode_t error code, NEARDAL_ERROR_GENERAL_ERROR if the call was
+ * aborted on agent release
+ **/
+errorCode_t neardal_agent_complete_oob(neardal_agent_invocation *inv,
+				       const unsigned char *data,
+				       unsigned int len);
+
+/*! \fn errorCode_t neardal_agent_set_oob_cache(const char *blobKey,
+ * const unsigned char *data, unsigned int len)
+ * @brief Set the Out Of Band data of a blob key ("EIR", "nokia.com:bt" or
+ * "WSC"). Handover requests for this key (or without blob, for an agent of
+ * the matching carrier) are then answered by neardal without calling the
+ * handover agent, until @link neardal_agent_invalidate_oob_cache @endlink.
+ * @param blobKey blob key
+ * @param data Out Of Band data (copied), NULL to invalidate
+ * @param len Out Of Band data length
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_agent_set_oob_cache(const char *blobKey,
+					const unsigned char *data,
+					unsigned int len);
+
+/*! \fn errorCode_t neardal_agent_invalidate_oob_cache(const char *blobKey)
+ * @brief Forget the Out Of Band data set for a blob key, the handover agent
+ * is called again for it
+ * @param blobKey blob key, NULL for all
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_agent_invalidate_oob_cache(const char *blobKey);
+
 /*! @fn errorCode_t neardal_free_array(char ***array)
  *
  * @brief free memory used by array of adapters/tags/device or records
@@ -636,9 +993,247 @@ GVariant *neardal_record_to_g_variant(neardal_record *in);
  */
 neardal_record *neardal_g_variant_to_record(GVariant *in);
 
+/*! \fn neardal_compact_record *neardal_record_compact(
+ * const neardal_record *record)
+ * @brief Build the compact form of a record (one allocation). Properties
+ * unknown to neardal are not kept.
+ *
+ * @param record record to convert
+ * @return compact record, NULL if its strings exceed 64 KB
+ **/
+neardal_compact_record *neardal_record_compact(const neardal_record *record);
+
+/*! \fn neardal_record *neardal_compact_record_expand(
+ * const neardal_compact_record *compact)
+ * @brief Build a neardal_record back from its compact form
+ *
+ * @param compact compact record
+ * @return record, release with @link neardal_free_record @endlink
+ **/
+neardal_record *neardal_compact_record_expand(
+				const neardal_compact_record *compact);
+
+/*! \fn const char *neardal_compact_record_get(
+ * const neardal_compact_record *compact, neardal_record_field field)
+ * @brief Get a string field of a compact record
+ *
+ * @param compact compact record
+ * @param field field to get
+ * @return string (inside the compact record), NULL if not set
+ **/
+const char *neardal_compact_record_get(const neardal_compact_record *compact,
+				       neardal_record_field field);
+
+/*! \fn unsigned int neardal_compact_record_uri_size(
+ * const neardal_compact_record *compact)
+ * @brief Get the URI object size (neardal_record uriObjSize)
+ **/
+unsigned int neardal_compact_record_uri_size(
+				const neardal_compact_record *compact);
+
+/*! \fn unsigned int neardal_compact_record_size(
+ * const neardal_compact_record *compact)
+ * @brief Get the size in bytes of a compact record. The block holds no
+ * pointer, it may be copied with memcpy() (e.g. into a larger buffer).
+ **/
+unsigned int neardal_compact_record_size(const neardal_compact_record *compact);
+
+/*! \fn void neardal_compact_record_free(neardal_compact_record *compact)
+ * @brief Release a compact record
+ **/
+void neardal_compact_record_free(neardal_compact_record *compact);
+
+/*! @brief D-Bus methods timed by neardal statistics */
+typedef enum {
+	NEARDAL_METHOD_START_POLL_LOOP = 0,
+	NEARDAL_METHOD_STOP_POLL_LOOP,
+	NEARDAL_METHOD_SET_PROPERTY,
+	NEARDAL_METHOD_TAG_WRITE,
+	NEARDAL_METHOD_DEV_PUSH,
+	NEARDAL_METHOD_GET_MANAGED_OBJECTS,
+	NEARDAL_METHOD_REGISTER_NDEF_AGENT,
+	NEARDAL_METHOD_UNREGISTER_NDEF_AGENT,
+	NEARDAL_METHOD_REGISTER_HANDOVER_AGENT,
+	NEARDAL_METHOD_UNREGISTER_HANDOVER_AGENT,
+	NEARDAL_METHOD_NEW_PROXY,	/* Proxy creation (properties load) */
+	NEARDAL_METHOD_COUNT
+} neardal_method;
+
+/*! @brief D-Bus messages received from Neard, counted by statistics */
+typedef enum {
+	NEARDAL_MSG_INTERFACES_ADDED = 0,
+	NEARDAL_MSG_INTERFACES_REMOVED,
+	NEARDAL_MSG_PROPERTY_CHANGED,	/* PropertyChanged/PropertiesChanged */
+	NEARDAL_MSG_AGENT_REQUEST,	/* Agent method called by Neard */
+	NEARDAL_MSG_COUNT
+} neardal_msg;
+
+/*!
+ * @brief Log-linear histogram bucketing: values (ns) below
+ * 2^NEARDAL_HIST_SUB_BITS have their own bucket, above each power of 2 is
+ * split in 2^NEARDAL_HIST_SUB_BITS buckets (12.5 % resolution). The last
+ * bucket collects values above 2^41 ns (about 36 minutes).
+ */
+#define NEARDAL_HIST_SUB_BITS	3
+#define NEARDAL_HIST_BUCKETS	((41 - NEARDAL_HIST_SUB_BITS + 1) << \
+				 NEARDAL_HIST_SUB_BITS)
+
+/*! @brief Latency histogram */
+typedef struct {
+	uint64_t	count;		/* Number of values */
+	uint64_t	sum;		/* Sum of values (ns) */
+	uint64_t	min;		/* Smallest value (ns), 0 if none */
+	uint64_t	max;		/* Largest value (ns) */
+	uint64_t	buckets[NEARDAL_HIST_BUCKETS];
+} neardal_histogram;
+
+/*! @brief Statistics of a D-Bus method */
+typedef struct {
+	neardal_histogram	latency;	/* All calls */
+	uint64_t		errors;		/* Calls which failed */
+} neardal_method_stats;
+
+/*! @brief Events of an adapter (its own, its tags, devices, records) */
+typedef struct {
+	char		*name;
+	uint64_t	events[NEARDAL_EVENT_COUNT];
+} neardal_adapter_stats;
+
+/*! @brief neardal statistics, since startup or neardal_reset_stats() */
+typedef struct {
+	neardal_method_stats	methods[NEARDAL_METHOD_COUNT];
+	uint64_t		messages[NEARDAL_MSG_COUNT];
+	/* Events raised, by kind */
+	uint64_t		events[NEARDAL_EVENT_COUNT];
+	/* Client callbacks invoked (legacy and listeners), by event kind */
+	uint64_t		callbacks[NEARDAL_EVENT_COUNT];
+	/* Neard message arrival to client callbacks (queueing), by kind */
+	neardal_histogram	eventLatency[NEARDAL_EVENT_COUNT];
+	unsigned int		nbAdapters;
+	neardal_adapter_stats	*adapters;
+} neardal_stats;
+
+/*! \fn errorCode_t neardal_get_stats(neardal_stats **stats)
+ * @brief Take a snapshot of neardal statistics. Counters are updated
+ * without lock, a snapshot taken while calls are running may be off by the
+ * calls in progress.
+ * @param stats snapshot, to be released with neardal_free_stats()
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_get_stats(neardal_stats **stats);
+
+/*! \fn void neardal_free_stats(neardal_stats *stats)
+ * @brief Release a statistics snapshot
+ **/
+void neardal_free_stats(neardal_stats *stats);
+
+/*! \fn void neardal_reset_stats(void)
+ * @brief Reset all statistics to zero
+ **/
+void neardal_reset_stats(void);
+
+/*! \fn uint64_t neardal_histogram_percentile(const neardal_histogram *hist,
+ * double percentile)
+ * @brief Estimate a percentile of a histogram, from the bucket holding it
+ * @param hist histogram
+ * @param percentile percentile, 0 to 100 (e.g. 99.9)
+ * @return value (ns), 0 if the histogram is empty
+ **/
+uint64_t neardal_histogram_percentile(const neardal_histogram *hist,
+				      double percentile);
+
+/*! @brief Timing of the event being delivered to client callbacks */
+typedef struct {
+	neardal_event	kind;
+	/* CLOCK_MONOTONIC time (ns) the Neard message was received, 0 if the
+	 * event was not raised by a Neard signal (e.g. registry resync) */
+	uint64_t	received;
+	/* CLOCK_MONOTONIC time (ns) the event was delivered to callbacks */
+	uint64_t	dispatched;
+} neardal_event_info;
+
+/*! \fn const neardal_event_info *neardal_current_event_info(void)
+ * @brief Get the timing of the event being delivered, to be called from a
+ * client callback (legacy or listener)
+ * @return event timing, NULL outside of a callback
+ **/
+const neardal_event_info *neardal_current_event_info(void);
+
+/*! \fn const char *neardal_method_name(neardal_method method)
+ * @brief Get the D-Bus name of a timed method
+ * @return method name, "Unknown" if not valid
+ **/
+const char *neardal_method_name(neardal_method method);
+
+/*!
+ * @brief NEARDAL log levels, a message is output if its level is lower or
+ * equal to the level of its category
+ **/
+typedef enum {
+	NEARDAL_LOG_NONE = 0,	/**< No output */
+	NEARDAL_LOG_ERROR,	/**< Errors */
+	NEARDAL_LOG_INFO,	/**< Errors and informational messages */
+	NEARDAL_LOG_DEBUG	/**< Everything, debug traces included */
+} neardal_log_level;
+
+/*!
+ * @brief NEARDAL log categories, one per library module
+ **/
+typedef enum {
+	NEARDAL_LOG_CAT_CORE = 0,	/**< Library core ("core") */
+	NEARDAL_LOG_CAT_MANAGER,	/**< Neard manager ("manager") */
+	NEARDAL_LOG_CAT_ADAPTER,	/**< Adapters ("adapter") */
+	NEARDAL_LOG_CAT_TAG,		/**< Tags ("tag") */
+	NEARDAL_LOG_CAT_DEVICE,		/**< Devices ("device") */
+	NEARDAL_LOG_CAT_RECORD,		/**< Records ("record") */
+	NEARDAL_LOG_CAT_AGENT,		/**< NDEF and handover agents
+					("agent") */
+	NEARDAL_LOG_CAT_COUNT		/**< Number of categories */
+} neardal_log_category;
+
+/*! @brief Pseudo category addressing all of them in
+ * @link neardal_log_set_level @endlink */
+#define NEARDAL_LOG_CAT_ALL	NEARDAL_LOG_CAT_COUNT
+
+/*! \fn errorCode_t neardal_log_set_level(neardal_log_category category,
+ * neardal_log_level level)
+ * @brief Set at runtime the log level of a category (or of all of them with
+ * NEARDAL_LOG_CAT_ALL). Messages above the level are neither formatted nor
+ * are their arguments evaluated.
+ * Default is NEARDAL_LOG_INFO (NEARDAL_LOG_DEBUG if compiled with
+ * --enable-trace), the NEARDAL_LOG environment variable overriding it (see
+ * neardal_log_configure()).
+ * @param category log category
+ * @param level maximum level of the messages output
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_log_set_level(neardal_log_category category,
+				  neardal_log_level level);
+
+/*! \fn neardal_log_level neardal_log_get_level(
+ * neardal_log_category category)
+ * @brief Get the log level of a category
+ * @param category log category
+ * @return the category level (NEARDAL_LOG_NONE if unknown)
+ **/
+neardal_log_level neardal_log_get_level(neardal_log_category category);
+
+/*! \fn errorCode_t neardal_log_configure(const char *spec)
+ * @brief Set log levels from a text specification, as done at startup with
+ * the NEARDAL_LOG environment variable.
+ * 'spec' is a comma separated list of 'level' (all categories) or
+ * 'category=level' items, applied in order. Levels are 'none', 'error',
+ * 'info' and 'debug', categories are 'core', 'manager', 'adapter', 'tag',
+ * 'device', 'record', 'agent' or '*'.
+ * e.g. NEARDAL_LOG=error,agent=debug
+ * @param spec levels specification
+ * @return errorCode_t error code, levels are left untouched on error
+ **/
+errorCode_t neardal_log_configure(const char *spec);
+
 void neardal_trace(const char *func, FILE *fp, char *fmt, ...)
 	__attribute__((format(printf, 3, 4)));
-int (*neardal_output_cb)(FILE *fp, const char *fmt, va_list ap);
+extern int (*neardal_output_cb)(FILE *fp, const char *fmt, va_list ap);
 
 #ifdef __cplusplus
 }
@@ -18,6 +18,8 @@
  *
  */
 
+#define NEARDAL_LOG_CATEGORY	NEARDAL_LOG_CAT_ADAPTER
+
 #include <stdio.h>
 #include <string.h>
 #include <glib.h>
@@ -40,6 +42,7 @@ void neardal_adp_prv_cb_tag_found(OrgNeardTag *proxy,
 	AdpProp		*adpProp	= user_data;
 	errorCode_t	err;
 	TagProp		*tagProp;
+	guint64		start;
 
 	NEARDAL_TRACEIN();
 	(void) proxy; /* remove warning */
@@ -48,9 +51,12 @@ void neardal_adp_prv_cb_tag_found(OrgNeardTag *proxy,
 	NEARDAL_ASSERT(adpProp != NULL);
 
 	NEARDAL_TRACEF("Adding tag '%s'\n", arg_unnamed_arg0);
+	NEARDAL_TIMELINE_TAG(arg_unnamed_arg0, TRUE);
 	/* Invoking Callback 'Tag Found' before adding it (otherwise
 	 * callback 'Record Found' would be called before ) */
+	start = NEARDAL_TIMELINE_NOW();
 	err = neardal_tag_prv_add((char *) arg_unnamed_arg0, adpProp);
+	NEARDAL_TIMELINE_SPAN("TagProp creation", arg_unnamed_arg0, start);
 	if (err == NEARDAL_SUCCESS) {
 		tagProp = g_list_nth_data(adpProp->tagList, 0);
 		neardal_tag_notify_tag_found(tagProp);
@@ -77,14 +83,14 @@ void neardal_adp_prv_cb_tag_lost(OrgNeardTag *proxy,
 	NEARDAL_ASSERT(adpProp != NULL);
 
 	NEARDAL_TRACEF("Removing tag '%s'\n", arg_unnamed_arg0);
+	NEARDAL_TIMELINE_TAG(arg_unnamed_arg0, FALSE);
 	/* Invoking Callback 'Tag Found' before adding it (otherwise
 	 * callback 'Record Found' would be called before ) */
 	err = neardal_adp_prv_get_tag(adpProp, (char *) arg_unnamed_arg0,
 						  &tagProp);
 	if (err == NEARDAL_SUCCESS) {
-		if (neardalMgr.cb.tag_lost != NULL)
-			(neardalMgr.cb.tag_lost)((char *) arg_unnamed_arg0,
-					      neardalMgr.cb.tag_lost_ud);
+		neardal_listener_prv_notify_tag(NEARDAL_EVENT_TAG_LOST,
+						tagProp);
 		neardal_tag_prv_remove(tagProp);
 		NEARDAL_TRACEF("NEARDAL LIB tagList contains %d elements\n",
 			      g_list_length(adpProp->tagList));
@@ -145,9 +151,8 @@ void neardal_adp_prv_cb_dev_lost(void *proxy,
 	err = neardal_adp_prv_get_dev(adpProp, (char *) arg_unnamed_arg0,
 						  &devProp);
 	if (err == NEARDAL_SUCCESS) {
-		if (neardalMgr.cb.dev_lost != NULL)
-			(neardalMgr.cb.dev_lost)((char *) arg_unnamed_arg0,
-					      neardalMgr.cb.dev_lost_ud);
+		neardal_listener_prv_notify_dev(NEARDAL_EVENT_DEV_LOST,
+						devProp);
 		neardal_dev_prv_remove(devProp);
 		NEARDAL_TRACEF("NEARDAL LIB devList contains %d elements\n",
 			      g_list_length(adpProp->devList));
@@ -155,15 +160,12 @@ void neardal_adp_prv_cb_dev_lost(void *proxy,
 }
 
 /*****************************************************************************
- * neardal_adp_prv_cb_property_changed: Callback called when a NFC tag
- * is found
+ * neardal_adp_prv_property_changed: one property of the adapter changed
  ****************************************************************************/
-static void neardal_adp_prv_cb_property_changed(OrgNeardAdapter *proxy,
-						const gchar *arg_unnamed_arg0,
-						GVariant *arg_unnamed_arg1,
-						void        *user_data)
+static void neardal_adp_prv_property_changed(AdpProp *adpProp,
+					     const gchar *arg_unnamed_arg0,
+					     GVariant *arg_unnamed_arg1)
 {
-	AdpProp		*adpProp	= NULL;
 	errorCode_t	err		= NEARDAL_ERROR_NO_TAG;
 	char		*dbusObjPath	= NULL;
 	void		*clientValue	= NULL;
@@ -173,17 +175,9 @@ static void neardal_adp_prv_cb_property_changed(OrgNeardAdapter *proxy,
 	GVariant	*gvalue		= NULL;
 	gsize		mode_len;
 
-	(void) proxy; /* remove warning */
-	(void) user_data; /* remove warning */
 	NEARDAL_TRACEIN();
 	NEARDAL_ASSERT(arg_unnamed_arg0 != NULL);
 
-	neardal_mgr_prv_get_adapter_from_proxy(proxy, &adpProp);
-	if (adpProp == NULL) {
-		err = NEARDAL_ERROR_GENERAL_ERROR;
-		goto exit;
-	}
-
 	gvalue = g_variant_get_variant(arg_unnamed_arg1);
 	if (gvalue == NULL) {
 		err = NEARDAL_ERROR_GENERAL_ERROR;
@@ -309,11 +303,9 @@ static void neardal_adp_prv_cb_property_changed(OrgNeardAdapter *proxy,
 		array = NULL;
 	}
 
-	if (neardalMgr.cb.adp_prop_changed != NULL)
-		(neardalMgr.cb.adp_prop_changed)(adpProp->name,
-						  (char *) arg_unnamed_arg0,
-						  clientValue,
-					neardalMgr.cb.adp_prop_changed_ud);
+	neardal_listener_prv_notify_adapter_prop(adpProp->name,
+						 (char *) arg_unnamed_arg0,
+						 clientValue);
 	return;
 
 exit:
@@ -323,37 +315,54 @@ exit:
 	return;
 }
 
-static void neardal_adp_prv_cb_properties_changed(
-				Properties *props __attribute__ ((unused)),
-				const gchar *interface,
-				GVariant *changed,
-				const gchar *const *invalidated,
-				void *user_data)
+/*****************************************************************************
+ * neardal_adp_prv_properties_changed: 'PropertiesChanged' of an adapter,
+ * received from Neard or replayed from a capture
+ ****************************************************************************/
+void neardal_adp_prv_properties_changed(AdpProp *adp, GVariant *changed)
 {
 	char *s = NULL;
 	GVariant *v = NULL;
 	GVariantIter iter;
-	AdpProp *adp;
+	guint64 start = NEARDAL_TIMELINE_NOW();
 
-	neardal_mgr_prv_get_adapter_from_proxy(user_data, &adp);
-
-	NEARDAL_ASSERT(adp != NULL);
-	NEARDAL_ASSERT(g_strv_length((gchar **) invalidated) == 0);
+	neardal_stats_msg(NEARDAL_MSG_PROPERTY_CHANGED);
 
-	NEARDAL_TRACEF("Interface: %s\n", interface);
 	NEARDAL_TRACEF("Adapter: %s\n", adp->name);
-	NEARDAL_TRACEF("Changed: %s\n", g_variant_print(changed, TRUE));
+	NEARDAL_TRACEF("Changed: %s\n", neardal_trace_variant(changed));
 
+	NEARDAL_PROBE2(signal_received, "PropertiesChanged", adp->name);
+	neardal_stats_msg_begin("PropertiesChanged", adp->name);
 	g_variant_iter_init(&iter, changed);
 
 	while (g_variant_iter_loop(&iter, "{sv}", &s, &v)) {
 		GVariant *vb = g_variant_new_variant(v);
 		g_variant_ref_sink(vb);
 		NEARDAL_TRACEF("Property: %s=%s\n", s,
-				g_variant_print(vb, TRUE));
-		neardal_adp_prv_cb_property_changed(user_data, s, vb, 0);
+				neardal_trace_variant(vb));
+		neardal_adp_prv_property_changed(adp, s, vb);
 		g_variant_unref(vb);
 	}
+	NEARDAL_TIMELINE_SIGNAL("PropertiesChanged", adp->name, start);
+	neardal_stats_msg_end();
+}
+
+static void neardal_adp_prv_cb_properties_changed(
+				Properties *props __attribute__ ((unused)),
+				const gchar *interface,
+				GVariant *changed,
+				const gchar *const *invalidated,
+				void *user_data)
+{
+	AdpProp *adp = NULL;
+
+	neardal_mgr_prv_get_adapter_from_proxy(user_data, &adp);
+
+	NEARDAL_ASSERT(adp != NULL);
+	NEARDAL_ASSERT(g_strv_length((gchar **) invalidated) == 0);
+
+	NEARDAL_TRACEF("Interface: %s\n", interface);
+	neardal_adp_prv_properties_changed(adp, changed);
 }
 
 static GVariant *neardal_adp_properties_get(char *name)
@@ -371,7 +380,7 @@ static GVariant *neardal_adp_properties_get(char *name)
 		g_free(s);
 		s = NULL;
 		path = g_variant_get_child_value(neardalMgr.dbus_objs, i);
-		NEARDAL_TRACEF("Found path: %s\n", g_variant_print(path, TRUE));
+		NEARDAL_TRACEF("Found path: %s\n", neardal_trace_variant(path));
 		break;
 	}
 
@@ -391,7 +400,7 @@ static GVariant *neardal_adp_properties_get(char *name)
 		interface = g_variant_get_child_value(tmp, i);
 		g_variant_unref(tmp);
 		NEARDAL_TRACEF("Found interface: %s\n",
-				g_variant_print(interface, TRUE));
+				neardal_trace_variant(interface));
 		continue;
 	}
 
@@ -401,7 +410,7 @@ static GVariant *neardal_adp_properties_get(char *name)
 	properties = g_variant_get_child_value(interface, 1);
 	g_variant_unref(interface);
 
-	NEARDAL_TRACEF("%s\n", g_variant_print(properties, TRUE));
+	NEARDAL_TRACEF("%s\n", neardal_trace_variant(properties));
 
 	return properties;
 }
@@ -419,7 +428,7 @@ static errorCode_t neardal_adp_prv_read_properties(AdpProp *adpProp)
 
 	NEARDAL_TRACEIN();
 	NEARDAL_ASSERT_RET(adpProp != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
-	NEARDAL_ASSERT_RET(adpProp->proxy != NULL
+	NEARDAL_ASSERT_RET(adpProp->proxy != NULL || neardalMgr.replay == TRUE
 			  , NEARDAL_ERROR_INVALID_PARAMETER);
 
 	if (!(tmp = neardal_adp_properties_get(adpProp->name))) {
@@ -429,7 +438,7 @@ static errorCode_t neardal_adp_prv_read_properties(AdpProp *adpProp)
 		goto exit;
 	}
 
-	NEARDAL_TRACEF("Reading:\n%s\n", g_variant_print(tmp, TRUE));
+	NEARDAL_TRACEF("Reading:\n%s\n", neardal_trace_variant(tmp));
 	tmpOut = g_variant_lookup_value(tmp, "Tags", G_VARIANT_TYPE_ARRAY);
 	if (tmpOut != NULL) {
 		array = g_variant_dup_objv(tmpOut, &len);
@@ -503,6 +512,57 @@ exit:
 	return err;
 }
 
+/*****************************************************************************
+ * neardal_adp_prv_resync: Compare a known adapter with the properties read
+ * after a Neard restart, only real changes are notified to the client
+ ****************************************************************************/
+void neardal_adp_prv_resync(AdpProp *adpProp, GVariant *props)
+{
+	static const gchar	*keys[] = { "Mode", "Polling", "Powered", NULL };
+	GVariant		*v, *vb;
+	gboolean		changed;
+	gsize			len;
+	int			i;
+
+	NEARDAL_TRACEIN();
+	NEARDAL_ASSERT(adpProp != NULL);
+	NEARDAL_ASSERT(props != NULL);
+
+	for (i = 0; keys[i] != NULL; i++) {
+		v = g_variant_lookup_value(props, keys[i], NULL);
+		if (v == NULL)
+			continue;
+
+		if (g_variant_is_of_type(v, G_VARIANT_TYPE_STRING))
+			changed = g_strcmp0(adpProp->mode,
+					    g_variant_get_string(v, NULL)) != 0;
+		else if (!strcmp(keys[i], "Polling"))
+			changed = adpProp->polling != g_variant_get_boolean(v);
+		else
+			changed = adpProp->powered != g_variant_get_boolean(v);
+
+		if (changed == TRUE) {
+			vb = g_variant_ref_sink(g_variant_new_variant(v));
+			neardal_adp_prv_property_changed(adpProp, keys[i],
+							 vb);
+			g_variant_unref(vb);
+		}
+		g_variant_unref(v);
+	}
+
+	v = g_variant_lookup_value(props, "Protocols", G_VARIANT_TYPE_ARRAY);
+	if (v != NULL) {
+		g_strfreev(adpProp->protocols);
+		adpProp->protocols = g_variant_dup_strv(v, &len);
+		adpProp->lenProtocols = len;
+		if (adpProp->lenProtocols == 0) {
+			g_strfreev(adpProp->protocols);
+			adpProp->protocols = NULL;
+		}
+		g_variant_unref(v);
+	}
+}
+
 /*****************************************************************************
  * neardal_adp_prv_get_tag: Get NFC tag from adapter
  ****************************************************************************/
@@ -567,6 +627,7 @@ errorCode_t neardal_adp_prv_get_dev(AdpProp *adpProp, gchar *devName,
 static errorCode_t neardal_adp_prv_init(AdpProp *adpProp)
 {
 	errorCode_t	err = NEARDAL_SUCCESS;
+	guint64		start;
 
 	NEARDAL_TRACEIN();
 	NEARDAL_ASSERT_RET(adpProp != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
@@ -586,12 +647,19 @@ static errorCode_t neardal_adp_prv_init(AdpProp *adpProp)
 	if (adpProp->name == NULL)
 		return err;
 
+	/* Replayed capture: properties only, no Neard to talk to */
+	if (neardalMgr.replay == TRUE)
+		return neardal_adp_prv_read_properties(adpProp);
+
+	start = neardal_stats_call_begin(NEARDAL_METHOD_NEW_PROXY);
 	adpProp->proxy = org_neard_adapter_proxy_new_sync(neardalMgr.conn,
 					G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
 							NEARD_DBUS_SERVICE,
 							adpProp->name,
 							NULL, /* GCancellable */
 							&neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_NEW_PROXY, start,
+			   neardalMgr.gerror == NULL);
 
 	if (neardalMgr.gerror != NULL) {
 		NEARDAL_TRACE_ERR(
@@ -611,9 +679,12 @@ static errorCode_t neardal_adp_prv_init(AdpProp *adpProp)
 		adpProp->props = NULL;
 	}
 
+	start = neardal_stats_call_begin(NEARDAL_METHOD_NEW_PROXY);
 	adpProp->props = properties_proxy_new_sync(neardalMgr.conn, 0,
 				NEARD_DBUS_SERVICE, adpProp->name, NULL,
 				&neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_NEW_PROXY, start,
+			   neardalMgr.gerror == NULL);
 
 	if (neardalMgr.gerror) {
 		NEARDAL_TRACE_ERR("Error creating Properties proxy: %s\n",
@@ -705,15 +776,15 @@ errorCode_t neardal_adp_add(gchar *adapterName)
 
 		adpList = &neardalMgr.prop.adpList;
 		*adpList = g_list_prepend(*adpList, (gpointer) adpProp);
+		NEARDAL_PROBE2(registry_add, "Adapter", adpProp->name);
 		err = neardal_adp_prv_init(adpProp);
 
 		NEARDAL_TRACEF("NEARDAL LIB adapterList contains %d elements\n",
 			g_list_length(*adpList));
 
 		/* Invoke client cb 'adapter added' */
-		if (neardalMgr.cb.adp_added != NULL)
-				(neardalMgr.cb.adp_added)((char *) adapterName,
-						neardalMgr.cb.adp_added_ud);
+		neardal_listener_prv_notify_adapter(
+				NEARDAL_EVENT_ADAPTER_ADDED, adapterName);
 
 		/* Notify 'Tag Found' */
 		len = 0;
@@ -749,6 +820,7 @@ errorCode_t neardal_adp_remove(AdpProp *adpProp)
 		neardal_tag_prv_remove(tagProp);
 	}
 
+	NEARDAL_PROBE2(registry_remove, "Adapter", adpProp->name);
 	adpList = &neardalMgr.prop.adpList;
 	(*adpList) = g_list_remove((*adpList), (gconstpointer) adpProp);
 	neardal_adp_prv_free(&adpProp);
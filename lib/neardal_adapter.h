@@ -63,6 +63,18 @@ errorCode_t neardal_adp_prv_get_tag(AdpProp * adpProp, gchar *tagName,
 errorCode_t neardal_adp_prv_get_dev(AdpProp * adpProp, gchar *devName,
 				       DevProp * *devProp);
 
+/*****************************************************************************
+ * neardal_adp_prv_resync: refresh a known adapter from the properties read
+ * after a Neard restart, notifying the client of changed values only
+ ****************************************************************************/
+void neardal_adp_prv_resync(AdpProp *adpProp, GVariant *props);
+
+/*****************************************************************************
+ * neardal_adp_prv_properties_changed: handle an adapter 'PropertiesChanged'
+ * (received or replayed)
+ ****************************************************************************/
+void neardal_adp_prv_properties_changed(AdpProp *adpProp, GVariant *changed);
+
 /*****************************************************************************
  * neardal_adp_add: add new NEARDAL adapter, initialize DBus Proxy
  * connection, register adapter signal
@@ -18,6 +18,8 @@
  *
  */
 
+#define NEARDAL_LOG_CATEGORY	NEARDAL_LOG_CAT_AGENT
+
 #include <stdio.h>
 #include <string.h>
 #include <glib.h>
@@ -35,66 +37,297 @@ static gboolean neardal_agent_prv_remove(gchar *objPath)
 						     , objPath);
 }
 
+/*****************************************************************************
+ * neardal_agent_prv_unexport: Remove the object of an agent which goes away,
+ * its 'object-removed' handler disconnected first (not to release it twice)
+ ****************************************************************************/
+static gboolean neardal_agent_prv_unexport(gpointer agent_data, gchar *objPath)
+{
+	g_signal_handlers_disconnect_by_data(neardalMgr.agentMgr, agent_data);
+	return neardal_agent_prv_remove(objPath);
+}
+
+static void neardal_agent_prv_free_ndef(gpointer data)
+{
+	neardal_ndef_agent_t *agent_data = data;
+
+	g_free(agent_data->objPath);
+	g_free(agent_data->tagType);
+	g_free(agent_data);
+}
+
+static void neardal_agent_prv_free_handover(gpointer data)
+{
+	neardal_handover_agent_t *agent_data = data;
+
+	g_free(agent_data->objPath);
+	g_free(agent_data->carrierType);
+	g_free(agent_data);
+}
+
+/* Pending agent method call, completed later by the client */
+struct neardal_agent_invocation {
+	GDBusMethodInvocation	*invocation;	/* NULL once aborted */
+	GMainContext		*context;	/* where the call was received */
+	gconstpointer		agent;		/* agent which received it */
+	const gchar		*key;		/* RequestOOB: OOB data key */
+	GVariant		*result;	/* reply, NULL on error */
+	errorCode_t		err;
+};
+
+/* Calls not completed yet by the client, aborted on agent release */
+static GList	*agentInvs;
+G_LOCK_DEFINE_STATIC(agentInvs);
+
+static neardal_agent_invocation *neardal_agent_prv_defer(
+					GDBusMethodInvocation *invocation,
+					gconstpointer agent,
+					const gchar *key)
+{
+	neardal_agent_invocation *inv = g_new0(neardal_agent_invocation, 1);
+
+	inv->invocation = g_object_ref(invocation);
+	inv->context = g_main_context_ref_thread_default();
+	inv->agent = agent;
+	inv->key = key;
+
+	G_LOCK(agentInvs);
+	agentInvs = g_list_prepend(agentInvs, inv);
+	G_UNLOCK(agentInvs);
+
+	return inv;
+}
+
+/*****************************************************************************
+ * neardal_agent_prv_abort: Reply an error to the calls of an agent (all the
+ * agents if NULL) the client did not complete, so that Neard doesn't wait
+ * for its timeout. The client still completes them, which then only frees
+ * them.
+ ****************************************************************************/
+static void neardal_agent_prv_abort(gconstpointer agent)
+{
+	neardal_agent_invocation	*inv;
+	GList				*node, *next;
+
+	G_LOCK(agentInvs);
+	for (node = agentInvs; node != NULL; node = next) {
+		next = node->next;
+		inv = node->data;
+		if (agent != NULL && inv->agent != agent)
+			continue;
+
+		NEARDAL_TRACEF("Abort %s() call\n",
+			       g_dbus_method_invocation_get_method_name(
+							inv->invocation));
+		g_dbus_method_invocation_return_error(inv->invocation,
+				G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+				"Agent released");
+		g_object_unref(inv->invocation);
+		g_main_context_unref(inv->context);
+		inv->invocation = NULL;
+		inv->context = NULL;
+		agentInvs = g_list_delete_link(agentInvs, node);
+	}
+	G_UNLOCK(agentInvs);
+}
+
+/*****************************************************************************
+ * neardal_agent_prv_take: Claim a call for completion. FALSE if it was
+ * aborted, it is then freed.
+ ****************************************************************************/
+static gboolean neardal_agent_prv_take(neardal_agent_invocation *inv)
+{
+	gboolean aborted;
+
+	G_LOCK(agentInvs);
+	aborted = (inv->invocation == NULL);
+	if (aborted == FALSE)
+		agentInvs = g_list_remove(agentInvs, inv);
+	G_UNLOCK(agentInvs);
+
+	if (aborted == TRUE) {
+		NEARDAL_TRACE_ERR("Call already aborted (agent released)\n");
+		g_free(inv);
+	}
+
+	return !aborted;
+}
+
+/*****************************************************************************
+ * neardal_agent_prv_complete: Reply to a deferred call, from the thread which
+ * received it
+ ****************************************************************************/
+static gboolean neardal_agent_prv_complete(gpointer user_data)
+{
+	neardal_agent_invocation *inv = user_data;
+
+	NEARDAL_TRACEF("%s() reply (err=%d)\n",
+		       g_dbus_method_invocation_get_method_name(
+							inv->invocation),
+		       inv->err);
+	if (inv->err == NEARDAL_SUCCESS)
+		g_dbus_method_invocation_return_value(inv->invocation,
+						      inv->result);
+	else
+		g_dbus_method_invocation_return_error(inv->invocation,
+				G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
+				"%s", neardal_error_get_text(inv->err));
+
+	g_object_unref(inv->invocation);
+	g_main_context_unref(inv->context);
+	g_free(inv);
+
+	return G_SOURCE_REMOVE;
+}
+
+/*****************************************************************************
+ * neardal_agent_complete_oob: Give the Out Of Band data of a deferred
+ * RequestOOB call (NULL on error). May be called from any thread.
+ ****************************************************************************/
+errorCode_t neardal_agent_complete_oob(neardal_agent_invocation *inv,
+				       const unsigned char *data,
+				       unsigned int len)
+{
+	GVariant *entry;
+
+	NEARDAL_ASSERT_RET(inv != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
+
+	if (neardal_agent_prv_take(inv) == FALSE)
+		return NEARDAL_ERROR_GENERAL_ERROR;
+
+	if (data != NULL && inv->key != NULL) {
+		entry = g_variant_new_dict_entry(
+				g_variant_new_string(inv->key),
+				g_variant_new_variant(
+					g_variant_new_fixed_array(
+						G_VARIANT_TYPE_BYTE,
+						data, len, 1)));
+		inv->result = g_variant_new("(@a{sv})", g_variant_new_array(
+					G_VARIANT_TYPE("{sv}"), &entry, 1));
+		inv->err = NEARDAL_SUCCESS;
+	} else
+		inv->err = NEARDAL_ERROR_GENERAL_ERROR;
+
+	g_main_context_invoke(inv->context, neardal_agent_prv_complete, inv);
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_agent_complete_ndef: Acknowledge a deferred GetNDEF call. May be
+ * called from any thread.
+ ****************************************************************************/
+errorCode_t neardal_agent_complete_ndef(neardal_agent_invocation *inv,
+					errorCode_t status)
+{
+	NEARDAL_ASSERT_RET(inv != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
+
+	if (neardal_agent_prv_take(inv) == FALSE)
+		return NEARDAL_ERROR_GENERAL_ERROR;
+
+	inv->err = status;
+	if (status == NEARDAL_SUCCESS)
+		inv->result = g_variant_new("()");
+
+	g_main_context_invoke(inv->context, neardal_agent_prv_complete, inv);
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_agent_prv_records: records object paths ("ao", or "as"), borrowed
+ * from 'v', an empty array if none. Only the returned array must be freed
+ * (g_free()).
+ ****************************************************************************/
+static const gchar **neardal_agent_prv_records(GVariant *v, gsize *len)
+{
+	*len = 0;
+	if (v != NULL &&
+	    g_variant_is_of_type(v, G_VARIANT_TYPE_OBJECT_PATH_ARRAY))
+		return g_variant_get_objv(v, len);
+	if (v != NULL && g_variant_is_of_type(v, G_VARIANT_TYPE_STRING_ARRAY))
+		return g_variant_get_strv(v, len);
+
+	return g_new0(const gchar *, 1);
+}
+
 static gboolean on_GetNDEF(neardalNDEFAgent             *ndefAgent,
                            GDBusMethodInvocation       *invocation
                            , GVariant                   *values
                            , gpointer                   user_data)
 {
 	neardal_ndef_agent_t	*agent_data	= user_data;
-	gchar			**rcdArray	= NULL;
+	const gchar		**rcdArray	= NULL;
 	gsize			rcdLen		= 0;
 	gchar			*ndefArray	= NULL;
 	gsize			ndefLen		= 0;
-	gconstpointer		value;
-
-	(void) ndefAgent;       /* Avoid warning */
-	(void) invocation;      /* Avoid warning */
+	GVariant		*records, *ndef;
+	GBytes			*bytes;
 
 	NEARDAL_TRACEIN();
-	NEARDAL_TRACEF("%s\n", g_variant_print(values, TRUE));
-
-	if (agent_data != NULL) {
-		NEARDAL_TRACEF("ndefAgent pid=%d, obj path is : %s\n"
-			      , agent_data->pid
-			      , agent_data->objPath);
-		if (agent_data->cb_ndef_agent != NULL) {
-			GVariant	*tmpOut	 = NULL;
-
-			tmpOut = g_variant_lookup_value(values, "Records",
-							G_VARIANT_TYPE_ARRAY);
-			if (tmpOut != NULL) {
-				rcdArray = (gchar**) g_variant_dup_strv(tmpOut
-								, &rcdLen);
-
-				if (rcdLen == 0) {
-					g_strfreev(rcdArray);
-					rcdArray = NULL;
-				}
-			}
-			tmpOut = g_variant_lookup_value(values, "NDEF",
-							G_VARIANT_TYPE_ARRAY);
-			if (tmpOut != NULL) {
-				value = g_variant_get_data(tmpOut);
-				ndefLen = g_variant_get_size(tmpOut);
-
-				if (ndefLen > 0) {
-					ndefArray = g_try_malloc0(ndefLen);
-					if (ndefArray != NULL)
-						memcpy(ndefArray, value
-						      , ndefLen);
-				}
-			}
-			(agent_data->cb_ndef_agent)(
-					(unsigned char **) rcdArray
-					, rcdLen
-					, (unsigned char *) ndefArray
-					, ndefLen
-					, agent_data->user_data);
-			g_free(ndefArray);
-			g_strfreev(rcdArray);
+	NEARDAL_PROBE2(agent_request, "GetNDEF",
+		       agent_data ? agent_data->objPath : "");
+	neardal_stats_msg(NEARDAL_MSG_AGENT_REQUEST);
+	NEARDAL_TRACEF("%s\n", neardal_trace_variant(values));
+
+	/* Neard only waits for the acknowledge, deferred by an async agent */
+	if (agent_data == NULL || agent_data->cb_ndef_async_agent == NULL)
+		neardal_ndefagent_complete_get_ndef(ndefAgent, invocation);
+
+	if (agent_data == NULL)
+		return TRUE;
+
+	NEARDAL_TRACEF("ndefAgent pid=%d, obj path is : %s\n"
+		      , agent_data->pid
+		      , agent_data->objPath);
+
+	records = g_variant_lookup_value(values, "Records", NULL);
+	ndef = g_variant_lookup_value(values, "NDEF", G_VARIANT_TYPE_ARRAY);
+	rcdArray = neardal_agent_prv_records(records, &rcdLen);
+	NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_AGENT_NDEF, agent_data->objPath,
+			    rcdLen, 0);
+
+	if (agent_data->cb_ndef_async_agent != NULL) {
+		bytes = ndef ? g_variant_get_data_as_bytes(ndef) :
+			       g_bytes_new_static(NULL, 0);
+		(agent_data->cb_ndef_async_agent)(
+				neardal_agent_prv_defer(invocation, agent_data,
+							NULL),
+				rcdArray, bytes, agent_data->user_data);
+		g_bytes_unref(bytes);
+	} else if (agent_data->cb_ndef_bytes_agent != NULL) {
+		/* No copy: strings and bytes stay in the message */
+		bytes = ndef ? g_variant_get_data_as_bytes(ndef) :
+			       g_bytes_new_static(NULL, 0);
+		(agent_data->cb_ndef_bytes_agent)(rcdArray, bytes,
+						  agent_data->user_data);
+		g_bytes_unref(bytes);
+	} else if (agent_data->cb_ndef_agent != NULL) {
+		gchar **rcdCopy = rcdLen ? g_strdupv((gchar **) rcdArray) :
+					   NULL;
+
+		if (ndef != NULL && (ndefLen = g_variant_get_size(ndef)) > 0) {
+			ndefArray = g_try_malloc0(ndefLen);
+			if (ndefArray != NULL)
+				memcpy(ndefArray, g_variant_get_data(ndef)
+				      , ndefLen);
 		}
+		(agent_data->cb_ndef_agent)(
+				(unsigned char **) rcdCopy
+				, rcdLen
+				, (unsigned char *) ndefArray
+				, ndefLen
+				, agent_data->user_data);
+		g_free(ndefArray);
+		g_strfreev(rcdCopy);
 	}
 
+	g_free(rcdArray);
+	if (records != NULL)
+		g_variant_unref(records);
+	if (ndef != NULL)
+		g_variant_unref(ndef);
+
 	return TRUE;
 }
 
@@ -105,22 +338,33 @@ static gboolean on_NDEF_Release( neardalNDEFAgent		*agent
 	neardal_ndef_agent_t	*agent_data = user_data;
 	NEARDAL_TRACEIN();
 
-	if (invocation != NULL)
+	/* No invocation when the agent object is removed */
+	if (invocation != NULL) {
+		NEARDAL_PROBE2(agent_request, "Release",
+			       agent_data ? agent_data->objPath : "");
+		neardal_stats_msg(NEARDAL_MSG_AGENT_REQUEST);
 		neardal_ndefagent_complete_release(agent, invocation);
+	}
 	if (agent_data != NULL) {
 		NEARDAL_TRACEF("agent '%s'\n",agent_data->objPath);
+		NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_AGENT_RELEASE,
+				    agent_data->objPath, 0, 0);
+
+		neardalMgr.ndefAgentList = g_list_remove(
+				neardalMgr.ndefAgentList, agent_data);
+
+		neardal_agent_prv_abort(agent_data);
 
 		if (agent_data->cb_ndef_release_agent)
 			(agent_data->cb_ndef_release_agent)(
 							agent_data->user_data);
 
-		if (neardal_agent_prv_remove(agent_data->objPath) == TRUE)
+		if (neardal_agent_prv_unexport(agent_data,
+					       agent_data->objPath) == TRUE)
 			NEARDAL_TRACE("removed\n");
 		else
 			NEARDAL_TRACE("not removed!\n");
-		g_free(agent_data->objPath);
-		g_free(agent_data->tagType);
-		g_free(agent_data);
+		neardal_agent_prv_free_ndef(agent_data);
 	}
 
 	return TRUE;
@@ -130,11 +374,150 @@ static void on_ndef_object_removed( GDBusObjectManager *manager
 			      , GDBusObject        *object
 			      , gpointer            user_data)
 {
+	neardal_ndef_agent_t	*agent_data = user_data;
+
 	NEARDAL_TRACEIN();
 	(void) manager; /* avoid warning */
+
+	/* Every agent gets the signal, only release the removed one */
+	if (g_strcmp0(g_dbus_object_get_object_path(object),
+		      agent_data->objPath) != 0)
+		return;
 	on_NDEF_Release( NEARDAL_NDEFAGENT(object), NULL, user_data);
 }
 
+/* Out Of Band blob keys of handover requests, by preference order */
+static const gchar *neardal_oob_keys[] = {"EIR", "nokia.com:bt", "WSC", NULL};
+#define NEARDAL_OOB_KEY_EIR	0
+#define NEARDAL_OOB_KEY_WSC	2
+
+/* RequestOOB replies set by the client, serialized once, by key */
+G_LOCK_DEFINE_STATIC(oobCache);
+static GVariant *oobCache[G_N_ELEMENTS(neardal_oob_keys) - 1];
+
+static int neardal_agent_prv_oob_key(const gchar *key)
+{
+	int i;
+
+	for (i = 0; neardal_oob_keys[i] != NULL; i++)
+		if (!strcmp(key, neardal_oob_keys[i]))
+			return i;
+
+	return -1;
+}
+
+/*****************************************************************************
+ * neardal_agent_prv_oob_blob: Out Of Band blob of a handover request (first
+ * known key found). Return a new reference or NULL, '*key' is set to its key.
+ ****************************************************************************/
+static GVariant *neardal_agent_prv_oob_blob(GVariant *values, const gchar **key)
+{
+	GVariant		*blob;
+	guint			counter;
+
+	for (counter = 0; neardal_oob_keys[counter] != NULL; counter++) {
+		blob = g_variant_lookup_value(values, neardal_oob_keys[counter],
+					      G_VARIANT_TYPE_BYTESTRING);
+		if (blob != NULL) {
+			*key = neardal_oob_keys[counter];
+			return blob;
+		}
+	}
+	*key = NULL;
+
+	return NULL;
+}
+
+/*****************************************************************************
+ * neardal_agent_prv_oob_reply: RequestOOB result, a single entry dictionary
+ * holding the 'oob' byte array (consumed if floating)
+ ****************************************************************************/
+static GVariant *neardal_agent_prv_oob_reply(const gchar *key, GVariant *oob)
+{
+	GVariant *entry = g_variant_new_dict_entry(g_variant_new_string(key),
+						   g_variant_new_variant(oob));
+
+	return g_variant_new_array(G_VARIANT_TYPE("{sv}"), &entry, 1);
+}
+
+/*****************************************************************************
+ * neardal_agent_prv_oob_cached: Cached reply for a request with the 'key'
+ * blob or, if the request holds none, for the agent carrier. Return a new
+ * reference or NULL.
+ ****************************************************************************/
+static GVariant *neardal_agent_prv_oob_cached(const gchar *key,
+					      const gchar *carrier)
+{
+	GVariant	*reply;
+	int		i;
+
+	if (key != NULL)
+		i = neardal_agent_prv_oob_key(key);
+	else if (carrier != NULL && !strcmp(carrier, "wifi"))
+		i = NEARDAL_OOB_KEY_WSC;
+	else
+		i = NEARDAL_OOB_KEY_EIR;
+
+	G_LOCK(oobCache);
+	reply = oobCache[i] ? g_variant_ref(oobCache[i]) : NULL;
+	G_UNLOCK(oobCache);
+
+	return reply;
+}
+
+/*****************************************************************************
+ * neardal_agent_set_oob_cache: Set the Out Of Band data neardal answers
+ * RequestOOB calls with, for a blob key, without calling the agent
+ ****************************************************************************/
+errorCode_t neardal_agent_set_oob_cache(const char *blobKey,
+					const unsigned char *data,
+					unsigned int len)
+{
+	GVariant	*reply = NULL, *old;
+	int		i;
+
+	NEARDAL_ASSERT_RET(blobKey != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
+	if ((i = neardal_agent_prv_oob_key(blobKey)) < 0)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	if (data != NULL) {
+		reply = g_variant_ref_sink(neardal_agent_prv_oob_reply(
+				neardal_oob_keys[i],
+				g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,
+							  data, len, 1)));
+		/* Serialized now, sent as is by each reply */
+		g_variant_get_data(reply);
+	}
+
+	G_LOCK(oobCache);
+	old = oobCache[i];
+	oobCache[i] = reply;
+	G_UNLOCK(oobCache);
+
+	if (old != NULL)
+		g_variant_unref(old);
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_agent_invalidate_oob_cache: Forget the Out Of Band data set for a
+ * blob key (all keys if NULL), the agent is called again
+ ****************************************************************************/
+errorCode_t neardal_agent_invalidate_oob_cache(const char *blobKey)
+{
+	errorCode_t	err = NEARDAL_SUCCESS;
+	int		i;
+
+	if (blobKey != NULL)
+		return neardal_agent_set_oob_cache(blobKey, NULL, 0);
+
+	for (i = 0; neardal_oob_keys[i] != NULL; i++)
+		err = neardal_agent_set_oob_cache(neardal_oob_keys[i], NULL, 0);
+
+	return err;
+}
+
 static gboolean on_RequestOOB(neardalHandoverAgent	*handoverAgent
 			      , GDBusMethodInvocation	*invocation
 			      , GVariant		*values
@@ -144,86 +527,107 @@ static gboolean on_RequestOOB(neardalHandoverAgent	*handoverAgent
 	unsigned char  			*oobData	= NULL;
 	unsigned int			oobDataLen	= 0;
 	void				(*freeFunc)(void *) = NULL;
-	const gchar* 		blobKeys[] = {"EIR", "nokia.com:bt", "WSC", NULL};
-	gchar	   			*blob		= NULL;
-	gsize	   			blobLen		= 0;
-	gconstpointer			value;
+	const gchar			*key		= NULL;
+	GVariant			*blob;
+	GVariant			*oob		= NULL;
 	GVariant			*result;
-	errorCode_t			err;
-	guint 				counter;
-
-	(void) handoverAgent;       /* Avoid warning */
-	(void) invocation;      /* Avoid warning */
-	err = NEARDAL_ERROR_GENERAL_ERROR;
+	GBytes				*bytes, *oobBytes;
 
 	NEARDAL_TRACEIN();
-	NEARDAL_TRACEF("%s\n", g_variant_print(values, TRUE));
+	NEARDAL_PROBE2(agent_request, "RequestOOB",
+		       agent_data ? agent_data->objPath : "");
+	neardal_stats_msg(NEARDAL_MSG_AGENT_REQUEST);
+	NEARDAL_TRACEF("%s\n", neardal_trace_variant(values));
 
-	if (agent_data != NULL) {
-		NEARDAL_TRACEF("handoverAgent pid=%d, obj path is : %s\n"
-			      , agent_data->pid
-			      , agent_data->objPath);
-		if (agent_data->cb_oob_req_agent != NULL) {
-			GVariant	*tmpOut	 = NULL;
-
-			for(counter = 0; blobKeys[counter] != NULL; counter++) {
-				tmpOut = g_variant_lookup_value(values, blobKeys[counter],
-								G_VARIANT_TYPE_ARRAY);
-				if (tmpOut != NULL) {
-					value = g_variant_get_data(tmpOut);
-					blobLen = g_variant_get_size(tmpOut);
-
-					if (blobLen > 0) {
-						blob = g_try_malloc0(blobLen);
-						if (blob != NULL)
-							memcpy(blob, value
-							      , blobLen);
-					}
-					break;
-				}
-			}
+	if (agent_data == NULL)
+		goto exit;
 
-			(agent_data->cb_oob_req_agent)(
-							(unsigned char *) blob
-						       , blobLen
-						       , &oobData
-						       , &oobDataLen
-						       , &freeFunc
-						, agent_data->user_data);
-			if ((oobData != NULL) && (blobKeys[counter] != NULL)) {
-				GVariantBuilder	*dictBuilder		= NULL;
-
- 				dictBuilder = g_variant_builder_new(
-							G_VARIANT_TYPE_ARRAY);
-				err = neardal_tools_prv_add_dict_entry(
-								dictBuilder,
-								blobKeys[counter], oobData, oobDataLen
-					     				, -1);
-				result = g_variant_builder_end(dictBuilder);
-
-				NEARDAL_TRACE_LOG("Sending:\n%s\n",
-						  g_variant_print(result
-								  , TRUE));
-
-				neardal_handover_agent_complete_request_oob(
-								handoverAgent
-								, invocation
-								, result);
-				err = NEARDAL_SUCCESS;
-			}
+	NEARDAL_TRACEF("handoverAgent pid=%d, obj path is : %s\n"
+		      , agent_data->pid
+		      , agent_data->objPath);
+
+	blob = neardal_agent_prv_oob_blob(values, &key);
+	NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_AGENT_OOB_REQ, agent_data->objPath,
+			    blob ? (int64_t) g_variant_get_size(blob) : 0, 0);
+
+	/* Answered from the cache, the agent is not involved */
+	result = neardal_agent_prv_oob_cached(key, agent_data->carrierType);
+	if (result != NULL) {
+		NEARDAL_TRACE_LOG("Sending cached OOB data\n");
+		neardal_handover_agent_complete_request_oob(handoverAgent,
+							    invocation, result);
+		g_variant_unref(result);
+		if (blob != NULL)
+			g_variant_unref(blob);
+		return TRUE;
+	}
+
+	if (agent_data->cb_oob_req_async_agent != NULL) {
+		/* Replied by neardal_agent_complete_oob() */
+		bytes = blob ? g_variant_get_data_as_bytes(blob) :
+			       g_bytes_new_static(NULL, 0);
+		(agent_data->cb_oob_req_async_agent)(
+				neardal_agent_prv_defer(invocation, agent_data,
+							key),
+				bytes, agent_data->user_data);
+		g_bytes_unref(bytes);
+		if (blob != NULL)
+			g_variant_unref(blob);
+		return TRUE;
+	} else if (agent_data->cb_oob_req_bytes_agent != NULL) {
+		/* No copy, neither of the blob nor of the OOB data */
+		bytes = blob ? g_variant_get_data_as_bytes(blob) :
+			       g_bytes_new_static(NULL, 0);
+		oobBytes = (agent_data->cb_oob_req_bytes_agent)(bytes,
+							agent_data->user_data);
+		g_bytes_unref(bytes);
+		if (oobBytes != NULL) {
+			if (key != NULL)
+				oob = g_variant_new_from_bytes(
+						G_VARIANT_TYPE_BYTESTRING,
+						oobBytes, TRUE);
+			g_bytes_unref(oobBytes);
 		}
+	} else if (agent_data->cb_oob_req_agent != NULL) {
+		gchar *blobCopy = NULL;
+		gsize blobLen = blob ? g_variant_get_size(blob) : 0;
+
+		if (blobLen > 0) {
+			blobCopy = g_malloc(blobLen);
+			memcpy(blobCopy, g_variant_get_data(blob), blobLen);
+		}
+		(agent_data->cb_oob_req_agent)(
+						(unsigned char *) blobCopy
+					       , blobLen
+					       , &oobData
+					       , &oobDataLen
+					       , &freeFunc
+					, agent_data->user_data);
+		if (oobData != NULL && key != NULL)
+			oob = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,
+							oobData, oobDataLen, 1);
+		if (freeFunc != NULL && oobData != NULL)
+			(freeFunc)(oobData);
+		g_free(blobCopy);
 	}
 
-	if (freeFunc != NULL && oobData != NULL)
-		(freeFunc)(oobData);
 	if (blob != NULL)
-		g_free(blob);
+		g_variant_unref(blob);
 
-	if (err != NEARDAL_SUCCESS)
+exit:
+	if (oob == NULL) {
 		g_dbus_method_invocation_return_error(invocation,
-					G_DBUS_ERROR_FAILED,
-					G_DBUS_ERROR_FAILED,
-					"%s", neardal_error_get_text(err));
+				G_DBUS_ERROR_FAILED,
+				G_DBUS_ERROR_FAILED,
+				"%s", neardal_error_get_text(
+					NEARDAL_ERROR_GENERAL_ERROR));
+		return TRUE;
+	}
+
+	result = neardal_agent_prv_oob_reply(key, oob);
+	NEARDAL_TRACE_LOG("Sending:\n%s\n", neardal_trace_variant(result));
+	neardal_handover_agent_complete_request_oob(handoverAgent, invocation,
+						    result);
 
 	return TRUE;
 }
@@ -234,49 +638,55 @@ static gboolean on_PushOOB(neardalHandoverAgent	*handoverAgent
 			   , gpointer			user_data)
 {
 	neardal_handover_agent_t	*agent_data	= user_data;
-	gconstpointer			value;
-	const gchar* 		blobKeys[] = {"EIR", "nokia.com:bt", "WSC", NULL};
-	gchar	   			*blob		= NULL;
-	gsize	   			blobLen		= 0;
-	guint 				counter;
-
-	(void) handoverAgent;       /* Avoid warning */
-	(void) invocation;      /* Avoid warning */
+	const gchar			*key;
+	GVariant			*blob;
+	GBytes				*bytes;
 
 	NEARDAL_TRACEIN();
-	NEARDAL_TRACEF("%s\n", g_variant_print(values, TRUE));
+	NEARDAL_PROBE2(agent_request, "PushOOB",
+		       agent_data ? agent_data->objPath : "");
+	neardal_stats_msg(NEARDAL_MSG_AGENT_REQUEST);
+	NEARDAL_TRACEF("%s\n", neardal_trace_variant(values));
 
 	if (agent_data != NULL) {
 		NEARDAL_TRACEF("handoverAgent pid=%d, obj path is : %s\n"
 			      , agent_data->pid
 			      , agent_data->objPath);
-		if (agent_data->cb_oob_push_agent != NULL) {
-			GVariant	*tmpOut	 = NULL;
-
-			for(counter = 0; blobKeys[counter] != NULL; counter++) {
-				tmpOut = g_variant_lookup_value(values, blobKeys[counter],
-								G_VARIANT_TYPE_ARRAY);
-				if (tmpOut != NULL) {
-					value = g_variant_get_data(tmpOut);
-					blobLen = g_variant_get_size(tmpOut);
-
-					if (blobLen > 0) {
-						blob = g_try_malloc0(blobLen);
-						if (blob != NULL)
-							memcpy(blob, value
-							      , blobLen);
-					}
-					break;
-				}
+
+		blob = neardal_agent_prv_oob_blob(values, &key);
+		NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_AGENT_OOB_PUSH,
+				agent_data->objPath,
+				blob ? (int64_t) g_variant_get_size(blob) : 0,
+				0);
+
+		if (agent_data->cb_oob_push_bytes_agent != NULL) {
+			bytes = blob ? g_variant_get_data_as_bytes(blob) :
+				       g_bytes_new_static(NULL, 0);
+			(agent_data->cb_oob_push_bytes_agent)(bytes,
+							agent_data->user_data);
+			g_bytes_unref(bytes);
+		} else if (agent_data->cb_oob_push_agent != NULL) {
+			gchar *blobCopy = NULL;
+			gsize blobLen = blob ? g_variant_get_size(blob) : 0;
+
+			if (blobLen > 0) {
+				blobCopy = g_malloc(blobLen);
+				memcpy(blobCopy, g_variant_get_data(blob),
+				       blobLen);
 			}
- 			(agent_data->cb_oob_push_agent)(
-							(unsigned char *) blob
-						       , blobLen
-						, agent_data->user_data);
- 			if (invocation != NULL)
- 				neardal_handover_agent_complete_push_oob(handoverAgent, invocation);
+			(agent_data->cb_oob_push_agent)(
+						(unsigned char *) blobCopy
+					       , blobLen
+					, agent_data->user_data);
+			g_free(blobCopy);
 		}
+
+		if (blob != NULL)
+			g_variant_unref(blob);
 	}
+	if (invocation != NULL)
+		neardal_handover_agent_complete_push_oob(handoverAgent,
+							 invocation);
 
 	return TRUE;
 }
@@ -288,21 +698,33 @@ static gboolean on_Handover_Release( neardalHandoverAgent	*agent
 	neardal_handover_agent_t	*agent_data = user_data;
 	NEARDAL_TRACEIN();
 
-	if (invocation != NULL)
+	/* No invocation when the agent object is removed */
+	if (invocation != NULL) {
+		NEARDAL_PROBE2(agent_request, "Release",
+			       agent_data ? agent_data->objPath : "");
+		neardal_stats_msg(NEARDAL_MSG_AGENT_REQUEST);
 		neardal_handover_agent_complete_release(agent, invocation);
+	}
 	if (agent_data != NULL) {
 		NEARDAL_TRACEF("agent '%s'\n",agent_data->objPath);
+		NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_AGENT_RELEASE,
+				    agent_data->objPath, 0, 0);
+
+		neardalMgr.handoverAgentList = g_list_remove(
+				neardalMgr.handoverAgentList, agent_data);
+
+		neardal_agent_prv_abort(agent_data);
 
 		if (agent_data->cb_oob_release_agent)
 			(agent_data->cb_oob_release_agent)(
 							agent_data->user_data);
 
-		if (neardal_agent_prv_remove(agent_data->objPath) == TRUE)
+		if (neardal_agent_prv_unexport(agent_data,
+					       agent_data->objPath) == TRUE)
 			NEARDAL_TRACE("removed\n");
 		else
 			NEARDAL_TRACE("not removed!\n");
-		g_free(agent_data->objPath);
-		g_free(agent_data);
+		neardal_agent_prv_free_handover(agent_data);
 	}
 
 	return TRUE;
@@ -312,8 +734,15 @@ static void on_handover_object_removed( GDBusObjectManager *manager
 			      , GDBusObject        *object
 			      , gpointer            user_data)
 {
+	neardal_handover_agent_t	*agent_data = user_data;
+
 	NEARDAL_TRACEIN();
 	(void) manager; /* avoid warning */
+
+	/* Every agent gets the signal, only release the removed one */
+	if (g_strcmp0(g_dbus_object_get_object_path(object),
+		      agent_data->objPath) != 0)
+		return;
 	on_Handover_Release( NEARDAL_HANDOVER_AGENT(object), NULL, user_data);
 }
 
@@ -354,7 +783,7 @@ errorCode_t neardal_ndefagent_prv_manage(neardal_ndef_agent_t agentData)
 
 	NEARDAL_TRACEIN();
 
-	if (agentData.cb_ndef_agent != NULL) {
+	if (NEARDAL_NDEF_AGENT_SET(&agentData)) {
 		data = g_try_malloc0(sizeof(neardal_ndef_agent_t));
 		if (data == NULL)
 			return NEARDAL_ERROR_NO_MEMORY;
@@ -386,6 +815,9 @@ errorCode_t neardal_ndefagent_prv_manage(neardal_ndef_agent_t agentData)
 		g_dbus_object_manager_server_export(neardalMgr.agentMgr
 					, G_DBUS_OBJECT_SKELETON (objSkel));
 		g_object_unref (objSkel);
+
+		neardalMgr.ndefAgentList = g_list_append(
+					neardalMgr.ndefAgentList, data);
 	} else {
 		NEARDAL_TRACEF("Release agent '%s'\n", agentData.objPath);
 		if (neardal_agent_prv_remove(agentData.objPath) == TRUE)
@@ -411,8 +843,7 @@ errorCode_t neardal_handoveragent_prv_manage(
 
         NEARDAL_TRACEIN();
 
-        if (agentData.cb_oob_push_agent != NULL &&
-	    agentData.cb_oob_req_agent != NULL) {
+        if (NEARDAL_HANDOVER_AGENT_SET(&agentData)) {
                 data = g_try_malloc0(sizeof(neardal_handover_agent_t));
                 if (data == NULL)
                         return NEARDAL_ERROR_NO_MEMORY;
@@ -451,6 +882,9 @@ errorCode_t neardal_handoveragent_prv_manage(
                 g_dbus_object_manager_server_export(neardalMgr.agentMgr
                                         , G_DBUS_OBJECT_SKELETON (objSkel));
                 g_object_unref (objSkel);
+
+                neardalMgr.handoverAgentList = g_list_append(
+                                        neardalMgr.handoverAgentList, data);
         } else {
                 NEARDAL_TRACEF("Release agent '%s'\n", agentData.objPath);
                 if (neardal_agent_prv_remove(agentData.objPath) == TRUE)
@@ -479,6 +913,60 @@ errorCode_t neardal_handoveragent_prv_release(gchar *objPath)
 }
 
 
+/*****************************************************************************
+ * neardal_agent_prv_register_all: register again all the known agents with
+ * Neard (after a Neard restart)
+ ****************************************************************************/
+void neardal_agent_prv_register_all(void)
+{
+	GList				*node;
+	neardal_ndef_agent_t		*ndef;
+	neardal_handover_agent_t	*handover;
+	guint64				start;
+	gboolean			ok;
+
+	NEARDAL_TRACEIN();
+
+	for (node = neardalMgr.ndefAgentList; node != NULL;
+	     node = node->next) {
+		ndef = node->data;
+		NEARDAL_TRACEF("Register NDEF agent '%s'\n", ndef->objPath);
+		start = neardal_stats_call_begin(
+					NEARDAL_METHOD_REGISTER_NDEF_AGENT);
+		ok = org_neard_manager_call_register_ndefagent_sync(
+					neardalMgr.proxy, ndef->objPath,
+					ndef->tagType, NULL,
+					&neardalMgr.gerror);
+		neardal_stats_call(NEARDAL_METHOD_REGISTER_NDEF_AGENT, start,
+				   ok);
+		if (!ok) {
+			NEARDAL_TRACE_ERR("%s: %s\n", ndef->objPath,
+					  neardalMgr.gerror->message);
+			neardal_tools_prv_free_gerror(&neardalMgr.gerror);
+		}
+	}
+
+	for (node = neardalMgr.handoverAgentList; node != NULL;
+	     node = node->next) {
+		handover = node->data;
+		NEARDAL_TRACEF("Register handover agent '%s'\n",
+			       handover->objPath);
+		start = neardal_stats_call_begin(
+				NEARDAL_METHOD_REGISTER_HANDOVER_AGENT);
+		ok = org_neard_manager_call_register_handover_agent_sync(
+					neardalMgr.proxy, handover->objPath,
+					handover->carrierType, NULL,
+					&neardalMgr.gerror);
+		neardal_stats_call(NEARDAL_METHOD_REGISTER_HANDOVER_AGENT,
+				   start, ok);
+		if (!ok) {
+			NEARDAL_TRACE_ERR("%s: %s\n", handover->objPath,
+					  neardalMgr.gerror->message);
+			neardal_tools_prv_free_gerror(&neardalMgr.gerror);
+		}
+	}
+}
+
 /*****************************************************************************
  * neardal_agent_acquire_dbus_name: acquire dbus name for management of neard
  *  agent feature
@@ -530,9 +1018,38 @@ exit:
  ****************************************************************************/
 void neardal_agent_stop_owning_dbus_name(void)
 {
+	GList				*node;
+	neardal_ndef_agent_t		*ndef;
+	neardal_handover_agent_t	*handover;
+
 	NEARDAL_TRACEIN();
 	if (neardalMgr.OwnerId > 0)
 		g_bus_unown_name (neardalMgr.OwnerId);
 	neardalMgr.OwnerId = 0;
 
+	neardal_agent_prv_abort(NULL);
+
+	/* Agents are dropped without Release, Neard forgets them with us */
+	if (neardalMgr.agentMgr != NULL) {
+		for (node = neardalMgr.ndefAgentList; node != NULL;
+		     node = node->next) {
+			ndef = node->data;
+			neardal_agent_prv_unexport(ndef, ndef->objPath);
+		}
+		for (node = neardalMgr.handoverAgentList; node != NULL;
+		     node = node->next) {
+			handover = node->data;
+			neardal_agent_prv_unexport(handover,
+						   handover->objPath);
+		}
+		g_object_unref(neardalMgr.agentMgr);
+		neardalMgr.agentMgr = NULL;
+	}
+
+	g_list_free_full(neardalMgr.ndefAgentList,
+			 neardal_agent_prv_free_ndef);
+	neardalMgr.ndefAgentList = NULL;
+	g_list_free_full(neardalMgr.handoverAgentList,
+			 neardal_agent_prv_free_handover);
+	neardalMgr.handoverAgentList = NULL;
 }
@@ -39,6 +39,14 @@ typedef struct {
 							and records object path
 							*/
 
+	ndef_agent_bytes_cb	cb_ndef_bytes_agent;	/* same, without copy
+							(used instead of
+							cb_ndef_agent if set)
+							*/
+	ndef_agent_async_cb	cb_ndef_async_agent;	/* same, acknowledged
+							later (used first if
+							set) */
+
 	ndef_agent_free_cb	cb_ndef_release_agent;	/* client callback gets
 							called when Neard
 							unregisters the agent.
@@ -67,6 +75,16 @@ typedef struct {
 							data to agent to start
 							handover */
 
+	oob_req_bytes_agent_cb	cb_oob_req_bytes_agent;	/* same, without copy
+							(used instead of
+							cb_oob_req_agent and
+							cb_oob_push_agent if
+							set) */
+	oob_push_bytes_agent_cb	cb_oob_push_bytes_agent;
+	oob_req_async_agent_cb	cb_oob_req_async_agent;	/* replied later with
+							neardal_agent_complete_oob()
+							(used first if set) */
+
 	oob_agent_free_cb	cb_oob_release_agent;	/* client callback gets
 							called when Neard
 							unregisters the agent.
@@ -81,6 +99,20 @@ typedef struct {
 	gpointer		user_data;
 } neardal_handover_agent_t;
 
+/* NDEF agent with a callback set (registered) */
+#define NEARDAL_NDEF_AGENT_SET(_agent)					\
+	((_agent)->cb_ndef_agent != NULL ||				\
+	 (_agent)->cb_ndef_bytes_agent != NULL ||			\
+	 (_agent)->cb_ndef_async_agent != NULL)
+
+/* Handover agent with its callbacks set (registered) */
+#define NEARDAL_HANDOVER_AGENT_SET(_agent)				\
+	(((_agent)->cb_oob_push_agent != NULL &&			\
+	  (_agent)->cb_oob_req_agent != NULL) ||			\
+	 ((_agent)->cb_oob_push_bytes_agent != NULL &&			\
+	  ((_agent)->cb_oob_req_bytes_agent != NULL ||			\
+	   (_agent)->cb_oob_req_async_agent != NULL)))
+
 /*****************************************************************************
  * neardal_agent_acquire_dbus_name: acquire dbus name for management of neard
  *  agent feature
@@ -106,4 +138,10 @@ errorCode_t neardal_ndefagent_prv_manage(neardal_ndef_agent_t agentData);
 errorCode_t neardal_handoveragent_prv_manage(
 					neardal_handover_agent_t agentData);
 
+/*****************************************************************************
+ * neardal_agent_prv_register_all: register again all the known agents with
+ * Neard (after a Neard restart)
+ ****************************************************************************/
+void neardal_agent_prv_register_all(void);
+
 #endif /* NEARDAL_AGENT_H */
@@ -0,0 +1,296 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "neardal.h"
+#include "neardal_prv.h"
+
+/* Messages larger than the D-Bus limit are a corrupted capture */
+#define CAPTURE_MSG_MAX		(128 * 1024 * 1024)
+
+/* GetManagedObjects calls of neardal awaiting their reply */
+#define CAPTURE_CALLS_MAX	4
+
+/*
+ * Messages are written from the connection filter (GDBus worker thread),
+ * under lock. Only the ones sent by Neard are kept: its signals and its
+ * replies to the GetManagedObjects calls of neardal, other services on the
+ * connection (e.g. BlueZ) answer the same method.
+ */
+int			neardal_capture_on;
+static FILE		*captureFile;
+static guint64		captureStart;
+static gchar		*neardOwner;	/* unique name of Neard */
+static guint32		calls[CAPTURE_CALLS_MAX];	/* call serials */
+static guint		callsNext;
+G_LOCK_DEFINE_STATIC(capture);
+
+/*****************************************************************************
+ * neardal_capture_prv_owner: Set the unique name of Neard, NULL while it is
+ * not running
+ ****************************************************************************/
+void neardal_capture_prv_owner(const gchar *owner)
+{
+	G_LOCK(capture);
+	if (g_strcmp0(owner, neardOwner) != 0) {
+		g_free(neardOwner);
+		neardOwner = g_strdup(owner);
+		memset(calls, 0, sizeof(calls));
+	}
+	G_UNLOCK(capture);
+}
+
+/*****************************************************************************
+ * neardal_capture_prv_call: Remember (outgoing) or check and forget
+ * (incoming) the serial of a GetManagedObjects call to Neard. Called under
+ * lock.
+ ****************************************************************************/
+static gboolean neardal_capture_prv_call(GDBusMessage *msg,
+					 gboolean incoming)
+{
+	guint32	serial;
+	guint	i;
+
+	if (incoming == FALSE) {
+		if (g_strcmp0(g_dbus_message_get_destination(msg),
+			      NEARD_DBUS_SERVICE) != 0 ||
+		    g_strcmp0(g_dbus_message_get_interface(msg),
+			      "org.freedesktop.DBus.ObjectManager") != 0 ||
+		    g_strcmp0(g_dbus_message_get_member(msg),
+			      "GetManagedObjects") != 0)
+			return FALSE;
+		calls[callsNext++ % CAPTURE_CALLS_MAX] =
+					g_dbus_message_get_serial(msg);
+		return TRUE;
+	}
+
+	serial = g_dbus_message_get_reply_serial(msg);
+	for (i = 0; serial != 0 && i < CAPTURE_CALLS_MAX; i++)
+		if (calls[i] == serial) {
+			calls[i] = 0;
+			return TRUE;
+		}
+	return FALSE;
+}
+
+/*****************************************************************************
+ * neardal_capture_prv_message: Append a message from Neard: a signal, or the
+ * reply to a GetManagedObjects call of neardal (outgoing 'msg' is only
+ * checked for such a call)
+ ****************************************************************************/
+void neardal_capture_prv_message(GDBusMessage *msg, gboolean incoming)
+{
+	guchar			*blob;
+	gsize			size;
+	guint64			ts;
+	guint32			len;
+	GDBusMessageType	type = g_dbus_message_get_message_type(msg);
+	gboolean		keep = FALSE;
+
+	if (incoming == FALSE && type != G_DBUS_MESSAGE_TYPE_METHOD_CALL)
+		return;
+	if (incoming == TRUE && type != G_DBUS_MESSAGE_TYPE_SIGNAL &&
+	    type != G_DBUS_MESSAGE_TYPE_METHOD_RETURN)
+		return;
+
+	G_LOCK(capture);
+	if (incoming == FALSE)
+		neardal_capture_prv_call(msg, FALSE);
+	else if (neardOwner != NULL &&
+		 g_strcmp0(g_dbus_message_get_sender(msg), neardOwner) == 0)
+		keep = type == G_DBUS_MESSAGE_TYPE_SIGNAL ||
+		       neardal_capture_prv_call(msg, TRUE);
+	G_UNLOCK(capture);
+	if (keep == FALSE)
+		return;
+
+	blob = g_dbus_message_to_blob(msg, &size, G_DBUS_CAPABILITY_FLAGS_NONE,
+				      NULL);
+	if (blob == NULL)
+		return;
+
+	G_LOCK(capture);
+	if (captureFile != NULL) {
+		ts = GUINT64_TO_LE(neardal_stats_now() - captureStart);
+		len = GUINT32_TO_LE(size);
+		fwrite(&ts, sizeof(ts), 1, captureFile);
+		fwrite(&len, sizeof(len), 1, captureFile);
+		fwrite(blob, size, 1, captureFile);
+	}
+	G_UNLOCK(capture);
+	g_free(blob);
+}
+
+errorCode_t neardal_capture_start(const char *path)
+{
+	FILE *fp;
+
+	if (path == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	neardal_capture_stop();
+
+	fp = fopen(path, "wb");
+	if (fp == NULL) {
+		NEARDAL_TRACE_ERR("Can't create '%s'\n", path);
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+	}
+	fwrite(NEARDAL_CAPTURE_MAGIC, strlen(NEARDAL_CAPTURE_MAGIC), 1, fp);
+
+	G_LOCK(capture);
+	captureFile = fp;
+	captureStart = neardal_stats_now();
+	__atomic_store_n(&neardal_capture_on, 1, __ATOMIC_RELAXED);
+	G_UNLOCK(capture);
+
+	return NEARDAL_SUCCESS;
+}
+
+void neardal_capture_stop(void)
+{
+	__atomic_store_n(&neardal_capture_on, 0, __ATOMIC_RELAXED);
+
+	G_LOCK(capture);
+	if (captureFile != NULL && fclose(captureFile) != 0)
+		NEARDAL_TRACE_ERR("Capture not fully written\n");
+	captureFile = NULL;
+	G_UNLOCK(capture);
+}
+
+/*****************************************************************************
+ * neardal_replay_prv_read: Read the next capture entry, NULL at the end of
+ * the file. '*ec' is set if the entry is truncated or invalid.
+ ****************************************************************************/
+static GDBusMessage *neardal_replay_prv_read(FILE *fp, guint64 *ts,
+					     errorCode_t *ec)
+{
+	GDBusMessage	*msg;
+	GError		*gerror	= NULL;
+	guchar		*blob;
+	guint32		len;
+
+	if (fread(ts, sizeof(*ts), 1, fp) != 1)
+		return NULL;
+	if (fread(&len, sizeof(len), 1, fp) != 1)
+		goto error;
+	*ts = GUINT64_FROM_LE(*ts);
+	len = GUINT32_FROM_LE(len);
+	if (len == 0 || len > CAPTURE_MSG_MAX)
+		goto error;
+
+	blob = g_malloc(len);
+	if (fread(blob, len, 1, fp) != 1) {
+		g_free(blob);
+		goto error;
+	}
+	msg = g_dbus_message_new_from_blob(blob, len,
+					   G_DBUS_CAPABILITY_FLAGS_NONE,
+					   &gerror);
+	g_free(blob);
+	if (msg == NULL) {
+		NEARDAL_TRACE_ERR("Invalid message: %s\n", gerror->message);
+		g_error_free(gerror);
+		goto error;
+	}
+
+	return msg;
+
+error:
+	*ec = NEARDAL_ERROR_GENERAL_ERROR;
+	return NULL;
+}
+
+errorCode_t neardal_replay_file(const char *path, int realtime,
+				unsigned int *nbMessages)
+{
+	errorCode_t	err	= NEARDAL_SUCCESS;
+	GDBusMessage	*msg;
+	FILE		*fp;
+	char		magic[sizeof(NEARDAL_CAPTURE_MAGIC) - 1];
+	guint64		ts, start, now;
+	unsigned int	nb	= 0;
+
+	NEARDAL_ASSERT_RET(path != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
+
+	fp = fopen(path, "rb");
+	if (fp == NULL) {
+		NEARDAL_TRACE_ERR("Can't open '%s'\n", path);
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+	}
+	if (fread(magic, sizeof(magic), 1, fp) != 1 ||
+	    memcmp(magic, NEARDAL_CAPTURE_MAGIC, sizeof(magic)) != 0) {
+		NEARDAL_TRACE_ERR("'%s' is not a neardal capture\n", path);
+		fclose(fp);
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+	}
+
+	/* Start from an empty registry, detached from D-Bus */
+	neardal_destroy();
+	memset(&neardalMgr.conn, 0,
+	       sizeof(neardalCtx) - offsetof(neardalCtx, conn));
+	neardalMgr.replay = TRUE;
+	neardalMgr.rcdWanted = TRUE;
+	g_datalist_init(&(neardalMgr.dbus_data));
+
+	start = neardal_stats_now();
+	while ((msg = neardal_replay_prv_read(fp, &ts, &err)) != NULL) {
+		now = neardal_stats_now();
+		if (realtime && start + ts > now)
+			g_usleep((start + ts - now) / 1000);
+		if (neardal_mgr_prv_replay(msg) == TRUE)
+			nb++;
+		g_object_unref(msg);
+	}
+	fclose(fp);
+
+	if (err != NEARDAL_SUCCESS)
+		NEARDAL_TRACE_ERR("'%s' truncated after %u messages\n", path,
+				  nb);
+	if (nbMessages != NULL)
+		*nbMessages = nb;
+
+	return err;
+}
+
+/*****************************************************************************
+ * neardal_capture_prv_init: Apply the NEARDAL_CAPTURE environment variable
+ * when the library is loaded
+ ****************************************************************************/
+static void __attribute__((constructor)) neardal_capture_prv_init(void)
+{
+	const char *s = getenv("NEARDAL_CAPTURE");
+
+	if (s != NULL && *s != '\0' &&
+	    neardal_capture_start(s) != NEARDAL_SUCCESS)
+		fprintf(stderr, "neardal: invalid NEARDAL_CAPTURE '%s'\n", s);
+}
+
+/*****************************************************************************
+ * neardal_capture_prv_exit: Flush the capture at exit
+ ****************************************************************************/
+static void __attribute__((destructor)) neardal_capture_prv_exit(void)
+{
+	neardal_capture_stop();
+}
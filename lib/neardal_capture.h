@@ -0,0 +1,89 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+/*!
+ * @file neardal_capture.h
+ *
+ * @brief Defines NEARDAL capture and replay of the Neard messages, to
+ * reproduce an events sequence without Neard
+ *
+ ******************************************************************************/
+
+#ifndef NEARDAL_CAPTURE_H
+#define NEARDAL_CAPTURE_H
+
+#include "neardal_errors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/*! @brief NEARDAL capture
+ * @addtogroup NEARDAL_CAPTURE Capture
+ * @{
+ * A capture holds the signals sent by Neard and its replies to the
+ * GetManagedObjects calls of neardal, messages of other services are left
+ * out. File format, integers little endian:
+ * - header: "NDLCAP01" (8 bytes)
+ * - one entry per message: time since the capture start (ns, 8 bytes),
+ *   message size (4 bytes), message in D-Bus wire format
+*/
+
+/*! @brief Capture file header */
+#define NEARDAL_CAPTURE_MAGIC	"NDLCAP01"
+
+/*! \fn errorCode_t neardal_capture_start(const char *path)
+ * @brief Start capturing to a file (truncated), stopping the capture in
+ * progress if any.
+ * A capture may also be started when the library is loaded with the
+ * NEARDAL_CAPTURE=<file> environment variable.
+ * @param path file name
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_capture_start(const char *path);
+
+/*! \fn void neardal_capture_stop(void)
+ * @brief Stop capturing and close the file. Done at exit if still
+ * capturing.
+ **/
+void neardal_capture_stop(void);
+
+/*! \fn errorCode_t neardal_replay_file(const char *path, int realtime,
+ *					unsigned int *nbMessages)
+ * @brief Feed a capture to neardal as if received from Neard.
+ * The Neard connection is closed first (callbacks and listeners are kept),
+ * then the messages are dispatched to the same handlers as live ones,
+ * client callbacks included. The resulting objects stay available to the
+ * neardal_get_*() functions until neardal_destroy(). Records are cached
+ * as if a client asked for them. Neard methods can't be called meanwhile.
+ * @param path capture file name
+ * @param realtime 0: as fast as possible, else with the captured timing
+ * @param nbMessages optional, messages dispatched
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_replay_file(const char *path, int realtime,
+				unsigned int *nbMessages);
+
+/* @}*/
+
+#ifdef __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif /* NEARDAL_CAPTURE_H */
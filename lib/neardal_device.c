@@ -18,6 +18,8 @@
  *
  */
 
+#define NEARDAL_LOG_CATEGORY	NEARDAL_LOG_CAT_DEVICE
+
 #include <stdio.h>
 #include <glib.h>
 
@@ -43,22 +45,18 @@ void neardal_dev_notify_dev_found(DevProp *devProp)
 
 	NEARDAL_ASSERT(devProp != NULL);
 
-	if (devProp->notified == FALSE && neardalMgr.cb.dev_found != NULL) {
-		(neardalMgr.cb.dev_found)(devProp->name,
-					   neardalMgr.cb.dev_found_ud);
-		devProp->notified = TRUE;
-	}
+	if (devProp->notified == FALSE)
+		devProp->notified = neardal_listener_prv_notify_dev(
+					NEARDAL_EVENT_DEV_FOUND, devProp);
 
 	len = 0;
-	if (neardalMgr.cb.rcd_found != NULL)
-		while (len < g_list_length(devProp->rcdList)) {
-			rcdProp = g_list_nth_data(devProp->rcdList, len++);
-			if (rcdProp->notified == FALSE) {
-				(neardalMgr.cb.rcd_found)(rcdProp->name,
-						neardalMgr.cb.rcd_found_ud);
-				rcdProp->notified = TRUE;
-			}
-		}
+	while (len < g_list_length(devProp->rcdList)) {
+		rcdProp = g_list_nth_data(devProp->rcdList, len++);
+		if (rcdProp->notified == FALSE)
+			rcdProp->notified = neardal_listener_prv_notify_record(
+				rcdProp->name,
+				neardal_data_search(rcdProp->name));
+	}
 }
 
 errorCode_t neardal_dev_push(neardal_record *record)
@@ -66,13 +64,21 @@ errorCode_t neardal_dev_push(neardal_record *record)
 	GError		*gerror	= NULL;
 	errorCode_t	err;
 	GVariant	*in;
+	guint64		start;
 
 	neardal_prv_construct(&err);
 	if (err != NEARDAL_SUCCESS)
 		goto exit;
 
+	/* Replayed capture: no Neard to push to */
+	if (neardalMgr.conn == NULL) {
+		err = NEARDAL_ERROR_DBUS_CANNOT_INVOKE_METHOD;
+		goto exit;
+	}
+
 	in = neardal_record_to_g_variant(record);
 
+	start = neardal_stats_call_begin(NEARDAL_METHOD_DEV_PUSH);
 	g_dbus_connection_call_sync(neardalMgr.conn,
 					"org.neard",
                                         record->name,
@@ -84,12 +90,15 @@ errorCode_t neardal_dev_push(neardal_record *record)
                                         3000, /* 3 secs */
                                         NULL,
                                         &gerror);
+	neardal_stats_call(NEARDAL_METHOD_DEV_PUSH, start, gerror == NULL);
+	NEARDAL_TIMELINE_SPAN("Push", record->name, start);
 	if (gerror) {
 		NEARDAL_TRACE_ERR("Can't push record: %s\n", gerror->message);
 		g_error_free(gerror);
 		err = NEARDAL_ERROR_DBUS_CANNOT_INVOKE_METHOD;
 	}
 exit:
+	NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_DEV_PUSH, record->name, err, 0);
 	return err;
 }
 
@@ -115,6 +124,7 @@ errorCode_t neardal_dev_prv_add(gchar *devName, void *parent)
 	devProp->parent	= adpProp;
 
 	adpProp->devList = g_list_prepend(adpProp->devList, devProp);
+	NEARDAL_PROBE2(registry_add, "Device", devProp->name);
 
 	NEARDAL_TRACEF("NEARDAL LIB devList contains %d elements\n",
 		      g_list_length(adpProp->devList));
@@ -144,6 +154,7 @@ void neardal_dev_prv_remove(DevProp *devProp)
 
 	NEARDAL_TRACEF("Removing dev:%s\n", devProp->name);
 
+	NEARDAL_PROBE2(registry_remove, "Device", devProp->name);
 	adpProp = devProp->parent;
 	adpProp->devList = g_list_remove(adpProp->devList,
 					 (gconstpointer) devProp);
@@ -0,0 +1,408 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include "neardal.h"
+#include "neardal_prv.h"
+
+/* Event attributes carried by an event */
+#define EVENT_HAS_TAG		(1 << 0)
+#define EVENT_HAS_RECORD	(1 << 1)
+
+/* NEARDAL event, as seen by the dispatcher */
+typedef struct {
+	neardal_event	kind;
+	const gchar	*name;		/* object path given to callbacks */
+	guint		attrs;		/* EVENT_HAS_xxx */
+	GQuark		adapter;
+	GQuark		tagType;
+	GQuark		rcdType;
+	char		*propName;	/* 'adapter property changed' only */
+	void		*value;
+} NeardalEvent;
+
+/*****************************************************************************
+ * neardal_listener_prv_quark: quark of a filter string, 0 for any
+ ****************************************************************************/
+static GQuark neardal_listener_prv_quark(const char *str)
+{
+	if (str == NULL || *str == '\0')
+		return 0;
+	return g_quark_from_string(str);
+}
+
+/*****************************************************************************
+ * neardal_listener_prv_mask: events a set of callbacks can receive
+ ****************************************************************************/
+static guint neardal_listener_prv_mask(const neardal_listener_cb *cb)
+{
+	guint mask = 0;
+
+	if (cb->adp_added != NULL)
+		mask |= NEARDAL_EVENT_MASK(NEARDAL_EVENT_ADAPTER_ADDED);
+	if (cb->adp_removed != NULL)
+		mask |= NEARDAL_EVENT_MASK(NEARDAL_EVENT_ADAPTER_REMOVED);
+	if (cb->adp_prop_changed != NULL)
+		mask |= NEARDAL_EVENT_MASK(
+				NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED);
+	if (cb->tag_found != NULL)
+		mask |= NEARDAL_EVENT_MASK(NEARDAL_EVENT_TAG_FOUND);
+	if (cb->tag_lost != NULL)
+		mask |= NEARDAL_EVENT_MASK(NEARDAL_EVENT_TAG_LOST);
+	if (cb->dev_found != NULL)
+		mask |= NEARDAL_EVENT_MASK(NEARDAL_EVENT_DEV_FOUND);
+	if (cb->dev_lost != NULL)
+		mask |= NEARDAL_EVENT_MASK(NEARDAL_EVENT_DEV_LOST);
+	if (cb->rcd_found != NULL)
+		mask |= NEARDAL_EVENT_MASK(NEARDAL_EVENT_RECORD_FOUND);
+
+	return mask;
+}
+
+/*****************************************************************************
+ * neardal_listener_prv_legacy: invoke the callback set with
+ * neardal_set_cb_xxx(), return TRUE if there is one
+ ****************************************************************************/
+static gboolean neardal_listener_prv_legacy(const NeardalEvent *ev)
+{
+	neardalCb *cb = &neardalMgr.cb;
+
+	switch (ev->kind) {
+	case NEARDAL_EVENT_ADAPTER_ADDED:
+		if (cb->adp_added == NULL)
+			return FALSE;
+		(cb->adp_added)(ev->name, cb->adp_added_ud);
+		break;
+	case NEARDAL_EVENT_ADAPTER_REMOVED:
+		if (cb->adp_removed == NULL)
+			return FALSE;
+		(cb->adp_removed)(ev->name, cb->adp_removed_ud);
+		break;
+	case NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED:
+		if (cb->adp_prop_changed == NULL)
+			return FALSE;
+		(cb->adp_prop_changed)((char *) ev->name, ev->propName,
+				       ev->value, cb->adp_prop_changed_ud);
+		break;
+	case NEARDAL_EVENT_TAG_FOUND:
+		if (cb->tag_found == NULL)
+			return FALSE;
+		(cb->tag_found)(ev->name, cb->tag_found_ud);
+		break;
+	case NEARDAL_EVENT_TAG_LOST:
+		if (cb->tag_lost == NULL)
+			return FALSE;
+		(cb->tag_lost)(ev->name, cb->tag_lost_ud);
+		break;
+	case NEARDAL_EVENT_DEV_FOUND:
+		if (cb->dev_found == NULL)
+			return FALSE;
+		(cb->dev_found)(ev->name, cb->dev_found_ud);
+		break;
+	case NEARDAL_EVENT_DEV_LOST:
+		if (cb->dev_lost == NULL)
+			return FALSE;
+		(cb->dev_lost)(ev->name, cb->dev_lost_ud);
+		break;
+	case NEARDAL_EVENT_RECORD_FOUND:
+		if (cb->rcd_found == NULL)
+			return FALSE;
+		(cb->rcd_found)(ev->name, cb->rcd_found_ud);
+		break;
+	default:
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*****************************************************************************
+ * neardal_listener_prv_match: evaluate the precompiled listener filter
+ ****************************************************************************/
+static gboolean neardal_listener_prv_match(const NeardalListener *l,
+					   const NeardalEvent *ev)
+{
+	if (l->removed == TRUE)
+		return FALSE;
+	if (!(l->events & NEARDAL_EVENT_MASK(ev->kind)))
+		return FALSE;
+	if (l->adapter != 0 && l->adapter != ev->adapter)
+		return FALSE;
+	if (l->tagType != 0 && (ev->attrs & EVENT_HAS_TAG) &&
+	    l->tagType != ev->tagType)
+		return FALSE;
+	if (l->rcdType != 0 && (ev->attrs & EVENT_HAS_RECORD) &&
+	    l->rcdType != ev->rcdType)
+		return FALSE;
+	return TRUE;
+}
+
+/*****************************************************************************
+ * neardal_listener_prv_call: invoke a listener callback
+ ****************************************************************************/
+static void neardal_listener_prv_call(const NeardalListener *l,
+				      const NeardalEvent *ev)
+{
+	const neardal_listener_cb *cb = &l->cb;
+
+	switch (ev->kind) {
+	case NEARDAL_EVENT_ADAPTER_ADDED:
+		(cb->adp_added)(ev->name, l->user_data);
+		break;
+	case NEARDAL_EVENT_ADAPTER_REMOVED:
+		(cb->adp_removed)(ev->name, l->user_data);
+		break;
+	case NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED:
+		(cb->adp_prop_changed)((char *) ev->name, ev->propName,
+				       ev->value, l->user_data);
+		break;
+	case NEARDAL_EVENT_TAG_FOUND:
+		(cb->tag_found)(ev->name, l->user_data);
+		break;
+	case NEARDAL_EVENT_TAG_LOST:
+		(cb->tag_lost)(ev->name, l->user_data);
+		break;
+	case NEARDAL_EVENT_DEV_FOUND:
+		(cb->dev_found)(ev->name, l->user_data);
+		break;
+	case NEARDAL_EVENT_DEV_LOST:
+		(cb->dev_lost)(ev->name, l->user_data);
+		break;
+	case NEARDAL_EVENT_RECORD_FOUND:
+		(cb->rcd_found)(ev->name, l->user_data);
+		break;
+	default:
+		break;
+	}
+}
+
+/*****************************************************************************
+ * neardal_listener_prv_purge: free the listeners removed while dispatching
+ ****************************************************************************/
+static void neardal_listener_prv_purge(void)
+{
+	GList		*node, *next;
+	NeardalListener	*l;
+
+	for (node = neardalMgr.listeners; node != NULL; node = next) {
+		next = node->next;
+		l = node->data;
+		if (l->removed == FALSE)
+			continue;
+		neardalMgr.listeners = g_list_delete_link(neardalMgr.listeners,
+							  node);
+		g_free(l);
+	}
+}
+
+/*****************************************************************************
+ * neardal_listener_prv_dispatch: deliver an event to the client callback and
+ * to the matching listeners
+ ****************************************************************************/
+static gboolean neardal_listener_prv_dispatch(const NeardalEvent *ev)
+{
+	gboolean		delivered;
+	guint			calls;
+	GList			*node;
+	const NeardalListener	*l;
+	neardal_event_info	info, *prevInfo;
+
+	NEARDAL_PROBE2(dispatch_start, ev->kind, ev->name);
+	prevInfo = neardal_stats_event_begin(&info, ev->kind);
+
+	delivered = neardal_listener_prv_legacy(ev);
+	calls = delivered ? 1 : 0;
+
+	neardalMgr.listenerDepth++;
+	for (node = neardalMgr.listeners; node != NULL; node = node->next) {
+		if (neardal_listener_prv_match(node->data, ev) == FALSE)
+			continue;
+		l = node->data;
+		NEARDAL_PROBE3(callback_entry, ev->kind, ev->name, l->id);
+		neardal_listener_prv_call(l, ev);
+		NEARDAL_PROBE3(callback_return, ev->kind, ev->name, l->id);
+		delivered = TRUE;
+		calls++;
+	}
+	if (--neardalMgr.listenerDepth == 0)
+		neardal_listener_prv_purge();
+
+	if (calls > 0)
+		NEARDAL_TIMELINE_CALLBACKS(ev->kind, ev->name,
+					   info.dispatched);
+	neardal_stats_event_end(&info, prevInfo, ev->name, calls);
+	NEARDAL_PROBE3(dispatch_done, ev->kind, ev->name, calls);
+
+	NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_DISPATCH, ev->name, ev->kind,
+			    delivered);
+
+	return delivered;
+}
+
+gboolean neardal_listener_prv_notify_adapter(neardal_event kind,
+					     const gchar *adpName)
+{
+	NeardalEvent ev = { .kind = kind, .name = adpName };
+
+	if (neardalMgr.listeners != NULL)
+		ev.adapter = g_quark_try_string(adpName);
+
+	return neardal_listener_prv_dispatch(&ev);
+}
+
+gboolean neardal_listener_prv_notify_adapter_prop(const gchar *adpName,
+						  char *propName,
+						  void *value)
+{
+	NeardalEvent ev = { .kind = NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED,
+			    .name = adpName, .propName = propName,
+			    .value = value };
+
+	if (neardalMgr.listeners != NULL)
+		ev.adapter = g_quark_try_string(adpName);
+
+	return neardal_listener_prv_dispatch(&ev);
+}
+
+gboolean neardal_listener_prv_notify_tag(neardal_event kind,
+					 TagProp *tagProp)
+{
+	NeardalEvent ev = { .kind = kind, .name = tagProp->name,
+			    .attrs = EVENT_HAS_TAG };
+
+	if (neardalMgr.listeners != NULL) {
+		ev.adapter = g_quark_try_string(
+					((AdpProp *) tagProp->parent)->name);
+		ev.tagType = g_quark_try_string(tagProp->type);
+	}
+
+	return neardal_listener_prv_dispatch(&ev);
+}
+
+gboolean neardal_listener_prv_notify_dev(neardal_event kind,
+					 DevProp *devProp)
+{
+	NeardalEvent ev = { .kind = kind, .name = devProp->name };
+
+	if (neardalMgr.listeners != NULL)
+		ev.adapter = g_quark_try_string(
+					((AdpProp *) devProp->parent)->name);
+
+	return neardal_listener_prv_dispatch(&ev);
+}
+
+gboolean neardal_listener_prv_notify_record(const gchar *rcdName,
+					    GVariant *record)
+{
+	NeardalEvent	ev = { .kind = NEARDAL_EVENT_RECORD_FOUND,
+			       .name = rcdName, .attrs = EVENT_HAS_RECORD };
+	AdpProp		*adpProp = NULL;
+	TagProp		*tagProp = NULL;
+	const gchar	*type = NULL;
+	gchar		*tagName;
+
+	if (neardalMgr.listeners == NULL)
+		return neardal_listener_prv_dispatch(&ev);
+
+	if (record != NULL && g_variant_lookup(record, "Type", "&s", &type))
+		ev.rcdType = g_quark_try_string(type);
+
+	if (neardal_mgr_prv_get_adapter((gchar *) rcdName, &adpProp)
+			== NEARDAL_SUCCESS) {
+		ev.adapter = g_quark_try_string(adpProp->name);
+		tagName = neardal_dirname(rcdName);
+		if (tagName != NULL && neardal_adp_prv_get_tag(adpProp,
+				tagName, &tagProp) == NEARDAL_SUCCESS) {
+			ev.attrs |= EVENT_HAS_TAG;
+			ev.tagType = g_quark_try_string(tagProp->type);
+		}
+		g_free(tagName);
+	}
+
+	return neardal_listener_prv_dispatch(&ev);
+}
+
+/*****************************************************************************
+ * neardal_add_listener: add a client listener
+ ****************************************************************************/
+unsigned int neardal_add_listener(const neardal_listener_filter *filter,
+				  const neardal_listener_cb *cb,
+				  void *user_data)
+{
+	NeardalListener	*l;
+
+	NEARDAL_TRACEIN();
+	NEARDAL_ASSERT_RET(cb != NULL, 0);
+
+	l = g_try_malloc0(sizeof(NeardalListener));
+	if (l == NULL)
+		return 0;
+
+	l->cb		= *cb;
+	l->user_data	= user_data;
+	l->events	= neardal_listener_prv_mask(cb);
+	if (filter != NULL) {
+		if (filter->events != 0)
+			l->events &= filter->events;
+		l->adapter = neardal_listener_prv_quark(filter->adpName);
+		l->tagType = neardal_listener_prv_quark(filter->tagType);
+		l->rcdType = neardal_listener_prv_quark(filter->rcdType);
+	}
+	l->id = ++neardalMgr.listenerLastId;
+	neardalMgr.listeners = g_list_append(neardalMgr.listeners, l);
+
+	NEARDAL_TRACEF("Listener %u added (events=0x%x)\n", l->id, l->events);
+
+	if (neardalMgr.proxy == NULL)
+		neardal_prv_construct(NULL);
+
+	if (l->events & NEARDAL_EVENT_MASK(NEARDAL_EVENT_RECORD_FOUND))
+		neardal_mgr_prv_want_records();
+
+	return l->id;
+}
+
+/*****************************************************************************
+ * neardal_remove_listener: remove a client listener
+ ****************************************************************************/
+errorCode_t neardal_remove_listener(unsigned int id)
+{
+	GList		*node;
+	NeardalListener	*l;
+
+	NEARDAL_TRACEIN();
+
+	for (node = neardalMgr.listeners; node != NULL; node = node->next) {
+		l = node->data;
+		if (l->id != id || l->removed == TRUE)
+			continue;
+
+		/* Freed once dispatching is over */
+		l->removed = TRUE;
+		if (neardalMgr.listenerDepth == 0)
+			neardal_listener_prv_purge();
+		return NEARDAL_SUCCESS;
+	}
+
+	return NEARDAL_ERROR_INVALID_PARAMETER;
+}
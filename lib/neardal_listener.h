@@ -0,0 +1,54 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef NEARDAL_LISTENER_H
+#define NEARDAL_LISTENER_H
+
+#include "neardal_adapter.h"
+
+/* NEARDAL client listener, filter precompiled to quarks (0 = any) */
+typedef struct {
+	guint			id;
+	GQuark			adapter;	/* adapter path */
+	GQuark			tagType;	/* tag type */
+	GQuark			rcdType;	/* record type */
+	guint			events;		/* subscribed event kinds */
+	neardal_listener_cb	cb;
+	void			*user_data;
+	gboolean		removed;	/* removed while dispatching */
+} NeardalListener;
+
+/*****************************************************************************
+ * neardal_listener_prv_notify_xxx: invoke the client callback then the
+ * matching listeners. Return TRUE if the event was delivered to the client.
+ ****************************************************************************/
+gboolean neardal_listener_prv_notify_adapter(neardal_event kind,
+					     const gchar *adpName);
+gboolean neardal_listener_prv_notify_adapter_prop(const gchar *adpName,
+						  char *propName,
+						  void *value);
+gboolean neardal_listener_prv_notify_tag(neardal_event kind,
+					 TagProp *tagProp);
+gboolean neardal_listener_prv_notify_dev(neardal_event kind,
+					 DevProp *devProp);
+gboolean neardal_listener_prv_notify_record(const gchar *rcdName,
+					    GVariant *record);
+
+#endif /* NEARDAL_LISTENER_H */
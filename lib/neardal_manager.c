@@ -18,6 +18,8 @@
  *
  */
 
+#define NEARDAL_LOG_CATEGORY	NEARDAL_LOG_CAT_MANAGER
+
 #include <stdio.h>
 #include <string.h>
 #include <glib.h>
@@ -34,6 +36,23 @@ void neardal_adp_prv_cb_tag_found(OrgNeardTag *proxy,
 void neardal_adp_prv_cb_tag_lost(OrgNeardTag *proxy,
 			const gchar *arg_unnamed_arg0, void *user_data);
 
+/*****************************************************************************
+ * neardal_mgr_prv_in_scope: check if a Neard object belongs to the adapter
+ * opened with neardal_open_adapter() (always TRUE without one)
+ ****************************************************************************/
+static gboolean neardal_mgr_prv_in_scope(const gchar *path)
+{
+	gsize len;
+
+	if (neardalMgr.adpScope == NULL)
+		return TRUE;
+
+	/* The adapter itself or its children, not its ancestors */
+	len = strlen(neardalMgr.adpScope);
+	return !strncmp(path, neardalMgr.adpScope, len) &&
+	       (path[len] == '\0' || path[len] == '/');
+}
+
 TagProp *neardal_mgr_tag_search(const gchar *tag)
 {
 	char *adapter = NULL;
@@ -77,7 +96,7 @@ static void neardal_mgr_tag_add(const gchar *path, GVariant *tag)
 	char *adapter = NULL;
 	AdpProp *adpProp = NULL;
 
-	NEARDAL_TRACEF("Tag: %s\n", g_variant_print(tag, TRUE));
+	NEARDAL_TRACEF("Tag: %s\n", neardal_trace_variant(tag));
 
 	if (!g_variant_lookup(tag, "Adapter", "o", &adapter) ||
 			neardal_mgr_prv_get_adapter(adapter, &adpProp) !=
@@ -114,16 +133,29 @@ static void neardal_mgr_interfaces_added(ObjectManager *om,
 					const gchar *path, GVariant *interfaces)
 {
 	GVariant *v = NULL;
+	guint64 start = NEARDAL_TIMELINE_NOW();
 
 	NEARDAL_TRACEF("path=%s\n", path);
-	NEARDAL_TRACEF("interfaces=%s\n", g_variant_print(interfaces, TRUE));
+	NEARDAL_TRACEF("interfaces=%s\n", neardal_trace_variant(interfaces));
+	NEARDAL_PROBE2(signal_received, "InterfacesAdded", path);
+	neardal_stats_msg(NEARDAL_MSG_INTERFACES_ADDED);
+	neardal_stats_msg_begin("InterfacesAdded", NEARD_MGR_PATH);
+
+	if (neardal_mgr_prv_in_scope(path) == FALSE)
+		goto exit;
 
 	if (g_variant_lookup(interfaces, "org.neard.Record", "*",
 				(void *) &v)) {
 		GVariant *record;
+		/* Nobody asked for records yet, hydrated on first demand */
+		if (neardalMgr.rcdWanted == FALSE) {
+			g_variant_unref(v);
+			goto exit;
+		}
 		if ((record = neardal_data_insert(path, "Record", v)))
 			neardal_record_add(record);
-		return;
+		g_variant_unref(v);
+		goto exit;
 	}
 
 	if (g_variant_lookup(interfaces, "org.neard.Device", "*",
@@ -131,16 +163,20 @@ static void neardal_mgr_interfaces_added(ObjectManager *om,
 		AdpProp *adp = neardal_adapter_find_by_child(path);
 		if (adp)
 			neardal_adp_prv_cb_dev_found(NULL, path, adp);
-		return;
+		goto exit;
 	}
 
 	if (g_variant_lookup(interfaces, "org.neard.Tag", "*", (void *) &v)) {
 		neardal_mgr_tag_add(path, v);
-		return;
+		goto exit;
 	}
 
 	NEARDAL_TRACE_ERR("Unsupported interface change: path=%s, "
-		"interface=%s\n", path, g_variant_print(interfaces, TRUE));
+		"interface=%s\n", path, neardal_trace_variant(interfaces));
+
+exit:
+	NEARDAL_TIMELINE_SIGNAL("InterfacesAdded", path, start);
+	neardal_stats_msg_end();
 }
 
 static void neardal_mgr_tag_remove(const gchar *tag)
@@ -154,7 +190,7 @@ static void neardal_mgr_tag_remove(const gchar *tag)
 		return;
 	}
 
-	NEARDAL_TRACEF("Tag's objects: %s\n", g_variant_print(v, TRUE));
+	NEARDAL_TRACEF("Tag's objects: %s\n", neardal_trace_variant(v));
 
 	if (!g_variant_lookup(v, "Adapter", "o", &adapter) ||
 			neardal_mgr_prv_get_adapter(adapter, &adpProp)
@@ -176,11 +212,18 @@ static void neardal_mgr_interfaces_removed(ObjectManager *om,
 {
 	char *s = g_strjoinv("' '", (gchar **)interfaces);
 	int i = 0;
+	guint64 start = NEARDAL_TIMELINE_NOW();
 
 	NEARDAL_TRACEF("path=%s\n", path);
 	NEARDAL_TRACEF("interfaces='%s'\n", s);
 
 	g_free(s);
+	NEARDAL_PROBE2(signal_received, "InterfacesRemoved", path);
+	neardal_stats_msg(NEARDAL_MSG_INTERFACES_REMOVED);
+	neardal_stats_msg_begin("InterfacesRemoved", NEARD_MGR_PATH);
+
+	if (neardal_mgr_prv_in_scope(path) == FALSE)
+		goto exit;
 
 	while ((s = (char *) interfaces[i++])) {
 		if (strcmp(s, "org.neard.Record") == 0) {
@@ -212,6 +255,10 @@ static void neardal_mgr_interfaces_removed(ObjectManager *om,
 		NEARDAL_TRACE_ERR("Unsupported interface change: "
 					"path=%s, data=%s\n", path, s);
 	}
+
+exit:
+	NEARDAL_TIMELINE_SIGNAL("InterfacesRemoved", path, start);
+	neardal_stats_msg_end();
 }
 
 /*****************************************************************************
@@ -231,6 +278,7 @@ static void neardal_mgr_prv_cb_property_changed(OrgNeardManager *proxy,
 	NEARDAL_ASSERT(arg_unnamed_arg0 != NULL);
 
 	NEARDAL_TRACEF("arg_unnamed_arg0='%s'\n", arg_unnamed_arg0);
+	neardal_stats_msg(NEARDAL_MSG_PROPERTY_CHANGED);
 	/* Adapters List ignored... */
 }
 
@@ -249,8 +297,13 @@ static void neardal_mgr_prv_cb_adapter_added(OrgNeardManager *proxy,
 	(void) user_data; /* remove warning */
 
 	NEARDAL_ASSERT(arg_unnamed_arg0 != NULL);
-	
+
+	if (neardal_mgr_prv_in_scope(arg_unnamed_arg0) == FALSE)
+		return;
+
+	neardal_stats_msg_begin("AdapterAdded", NEARD_MGR_PATH);
 	err = neardal_adp_add((char *) arg_unnamed_arg0);
+	neardal_stats_msg_end();
 	if (err != NEARDAL_SUCCESS)
 		return;
 
@@ -266,7 +319,7 @@ static void neardal_mgr_prv_cb_adapter_removed(OrgNeardManager *proxy,
 					       const gchar *arg_unnamed_arg0,
 					       void *user_data)
 {
-	GList	*node	= NULL;
+	AdpProp	*adpProp	= NULL;
 
 	NEARDAL_TRACEIN();
 	(void) proxy; /* remove warning */
@@ -274,19 +327,23 @@ static void neardal_mgr_prv_cb_adapter_removed(OrgNeardManager *proxy,
 
 	NEARDAL_ASSERT(arg_unnamed_arg0 != NULL);
 
-	node = g_list_first(neardalMgr.prop.adpList);
-	if (node == NULL) {
+	if (neardal_mgr_prv_in_scope(arg_unnamed_arg0) == FALSE)
+		return;
+
+	if (neardal_mgr_prv_get_adapter((gchar *) arg_unnamed_arg0, &adpProp)
+			!= NEARDAL_SUCCESS) {
 		NEARDAL_TRACE_ERR("NFC adapter not found! (%s)\n",
 				  arg_unnamed_arg0);
 		return;
 	}
 
 	/* Invoke client cb 'adapter removed' */
-	if (neardalMgr.cb.adp_removed != NULL)
-		(neardalMgr.cb.adp_removed)((char *) arg_unnamed_arg0,
-					 neardalMgr.cb.adp_removed_ud);
+	neardal_stats_msg_begin("AdapterRemoved", NEARD_MGR_PATH);
+	neardal_listener_prv_notify_adapter(NEARDAL_EVENT_ADAPTER_REMOVED,
+					    arg_unnamed_arg0);
+	neardal_stats_msg_end();
 
-	neardal_adp_remove(((AdpProp *)node->data));
+	neardal_adp_remove(adpProp);
 
 	NEARDAL_TRACEF("NEARDAL LIB adapterList contains %d elements\n",
 		      g_list_length(neardalMgr.prop.adpList));
@@ -305,7 +362,8 @@ static void neardal_mgr_adapters_parse(GVariant *v, char ***adps, gsize *nadps)
 
 	while (g_variant_iter_loop(&iter, "{oa{sa{sv}}}", &s, &iter2, NULL)) {
 		while (g_variant_iter_loop(iter2, "{s*}", &t, NULL)) {
-			if(!strcmp(t, "org.neard.Adapter"))
+			if (!strcmp(t, "org.neard.Adapter") &&
+				neardal_mgr_prv_in_scope(s))
 			{
 				NEARDAL_TRACEF("Found adapter: %s\n", s);
 				(*adps)[(*nadps)++] = s;
@@ -331,13 +389,18 @@ static errorCode_t neardal_mgr_prv_get_all_adapters(gchar ***adpArray,
 						    gsize *len)
 {
 	errorCode_t	err		= NEARDAL_ERROR_NO_ADAPTER;
+	guint64		start;
+	gboolean	ok;
 
 	NEARDAL_ASSERT_RET(adpArray != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
 
-	if (object_manager_call_get_managed_objects_sync(neardalMgr.dbus_om,
-			&neardalMgr.dbus_objs, NULL, &neardalMgr.gerror)) {
+	start = neardal_stats_call_begin(NEARDAL_METHOD_GET_MANAGED_OBJECTS);
+	ok = object_manager_call_get_managed_objects_sync(neardalMgr.dbus_om,
+			&neardalMgr.dbus_objs, NULL, &neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_GET_MANAGED_OBJECTS, start, ok);
+	if (ok) {
 		NEARDAL_TRACEF("Reading:\n%s\n",
-				g_variant_print(neardalMgr.dbus_objs, TRUE));
+				neardal_trace_variant(neardalMgr.dbus_objs));
 		NEARDAL_TRACEF("Parsing neard adapters...\n");
 
 		neardal_mgr_adapters_parse(neardalMgr.dbus_objs, adpArray, len);
@@ -412,6 +475,487 @@ errorCode_t neardal_mgr_prv_get_adapter_from_proxy(OrgNeardAdapter *adpProxy,
 	return err;
 }
 
+/*****************************************************************************
+ * neardal_mgr_prv_cache_records: cache the records of the managed objects
+ * 'objs' not known yet (no client callback invoked for them)
+ ****************************************************************************/
+static void neardal_mgr_prv_cache_records(GVariant *objs)
+{
+	GVariant	*props;
+	GVariantIter	iter;
+	const gchar	*path;
+
+	g_variant_iter_init(&iter, objs);
+	while (g_variant_iter_next(&iter, "{&o@a{sa{sv}}}", &path, &props)) {
+		GVariant *v;
+
+		if (neardal_mgr_prv_in_scope(path) == TRUE &&
+			neardal_data_search(path) == NULL &&
+			g_variant_lookup(props, "org.neard.Record", "@a{sv}",
+					&v)) {
+			neardal_data_insert(path, "Record", v);
+			g_variant_unref(v);
+		}
+		g_variant_unref(props);
+	}
+}
+
+/*****************************************************************************
+ * neardal_mgr_prv_want_records: records are only cached once a client
+ * callback or query needs them. On first demand, read the records already
+ * published by Neard. The demand outlives neardal_destroy(), the registry
+ * rebuilt by neardal_mgr_create() caches the records again.
+ ****************************************************************************/
+void neardal_mgr_prv_want_records(void)
+{
+	GVariant	*objs	= NULL;
+	guint64		start;
+	gboolean	ok;
+
+	if (neardalMgr.rcdWanted == TRUE)
+		return;
+
+	NEARDAL_TRACEIN();
+	neardalMgr.rcdWanted = TRUE;
+	if (neardalMgr.dbus_om == NULL)
+		return;
+
+	start = neardal_stats_call_begin(NEARDAL_METHOD_GET_MANAGED_OBJECTS);
+	ok = object_manager_call_get_managed_objects_sync(neardalMgr.dbus_om,
+			&objs, NULL, &neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_GET_MANAGED_OBJECTS, start, ok);
+	if (!ok) {
+		NEARDAL_TRACE_ERR("%d:%s\n", neardalMgr.gerror->code,
+				 neardalMgr.gerror->message);
+		neardal_tools_prv_free_gerror(&neardalMgr.gerror);
+		return;
+	}
+
+	neardal_mgr_prv_cache_records(objs);
+	g_variant_unref(objs);
+}
+
+/*****************************************************************************
+ * neardal_mgr_prv_resync_remove: drop objects which disappeared while Neard
+ * was away ('present' maps object paths to their interfaces)
+ ****************************************************************************/
+static void neardal_mgr_prv_resync_remove(GHashTable *present)
+{
+	GVariant	**data = NULL;
+	GVariant	*ifaces;
+	guint		len, i;
+	GList		*adpNode, *node, *next;
+	AdpProp		*adpProp;
+	gchar		*name;
+
+	/* Records */
+	len = neardal_data_to_arrayv((void ***) &data);
+	for (i = 0; i < len; i++) {
+		const char *type = neardal_g_variant_get(data[i], "NeardalType",
+							"&s");
+
+		if (type == NULL || strcmp(type, "Record") != 0)
+			continue;
+		name = neardal_g_variant_get(data[i], "Name", "&s");
+		ifaces = g_hash_table_lookup(present, name);
+		if (ifaces != NULL && g_variant_lookup(ifaces,
+				"org.neard.Record", "@a{sv}", NULL))
+			continue;
+		neardal_record_remove(data[i]);
+		neardal_data_remove(data[i]);
+	}
+	g_free(data);
+
+	adpNode = neardalMgr.prop.adpList;
+	while (adpNode != NULL) {
+		adpProp = adpNode->data;
+		adpNode = adpNode->next;
+
+		/* Tags */
+		for (node = adpProp->tagList; node != NULL; node = next) {
+			next = node->next;
+			name = ((TagProp *) node->data)->name;
+			ifaces = g_hash_table_lookup(present, name);
+			if (ifaces != NULL && g_variant_lookup(ifaces,
+					"org.neard.Tag", "@a{sv}", NULL))
+				continue;
+			name = g_strdup(name);
+			neardal_adp_prv_cb_tag_lost(NULL, name, adpProp);
+			g_datalist_remove_data(&(neardalMgr.dbus_data), name);
+			g_free(name);
+		}
+
+		/* Devices */
+		for (node = adpProp->devList; node != NULL; node = next) {
+			next = node->next;
+			name = ((DevProp *) node->data)->name;
+			ifaces = g_hash_table_lookup(present, name);
+			if (ifaces != NULL && g_variant_lookup(ifaces,
+					"org.neard.Device", "@a{sv}", NULL))
+				continue;
+			name = g_strdup(name);
+			neardal_adp_prv_cb_dev_lost(NULL, name, adpProp);
+			g_free(name);
+		}
+
+		/* Adapter itself */
+		ifaces = g_hash_table_lookup(present, adpProp->name);
+		if (ifaces != NULL && g_variant_lookup(ifaces,
+				"org.neard.Adapter", "@a{sv}", NULL))
+			continue;
+		neardal_listener_prv_notify_adapter(
+				NEARDAL_EVENT_ADAPTER_REMOVED, adpProp->name);
+		neardal_adp_remove(adpProp);
+	}
+}
+
+/*****************************************************************************
+ * neardal_mgr_prv_resync_add: add objects which appeared while Neard was
+ * away, refresh the already known ones. Adapters are handled first, then
+ * tags and devices, then records.
+ ****************************************************************************/
+static void neardal_mgr_prv_resync_add(GHashTable *present)
+{
+	static const char	*passes[] = { "org.neard.Adapter",
+					      "org.neard.Tag",
+					      "org.neard.Device",
+					      "org.neard.Record", NULL };
+	GHashTableIter		iter;
+	gpointer		key, value;
+	GVariant		*props, *record;
+	AdpProp			*adpProp;
+	TagProp			*tagProp;
+	DevProp			*devProp;
+	gchar			*path;
+	int			pass;
+
+	for (pass = 0; passes[pass] != NULL; pass++) {
+		g_hash_table_iter_init(&iter, present);
+		while (g_hash_table_iter_next(&iter, &key, &value)) {
+			path = key;
+			if (!g_variant_lookup(value, passes[pass], "@a{sv}",
+						&props))
+				continue;
+
+			adpProp = NULL;
+			neardal_mgr_prv_get_adapter(path, &adpProp);
+
+			switch (pass) {
+			case 0:
+				if (adpProp == NULL)
+					neardal_adp_add(path);
+				else
+					neardal_adp_prv_resync(adpProp, props);
+				break;
+			case 1:
+				if (adpProp != NULL &&
+					neardal_adp_prv_get_tag(adpProp, path,
+						&tagProp) == NEARDAL_SUCCESS)
+					g_datalist_set_data_full(
+						&(neardalMgr.dbus_data), path,
+						g_variant_ref(props),
+					(GDestroyNotify) g_variant_unref);
+				else
+					neardal_mgr_tag_add(path, props);
+				break;
+			case 2:
+				if (adpProp != NULL &&
+					neardal_adp_prv_get_dev(adpProp, path,
+						&devProp) != NEARDAL_SUCCESS)
+					neardal_adp_prv_cb_dev_found(NULL, path,
+								adpProp);
+				break;
+			case 3:
+				if (neardalMgr.rcdWanted == TRUE &&
+					neardal_data_search(path) == NULL &&
+					(record = neardal_data_insert(path,
+							"Record", props)))
+					neardal_record_add(record);
+				break;
+			}
+			g_variant_unref(props);
+		}
+	}
+}
+
+/*****************************************************************************
+ * neardal_mgr_prv_resync_objects: compare the managed objects 'objs' with
+ * the known ones, only real changes are notified to the client. 'objs' is
+ * kept as the adapters properties snapshot.
+ ****************************************************************************/
+static void neardal_mgr_prv_resync_objects(GVariant *objs)
+{
+	GVariant	*ifaces;
+	GHashTable	*present;
+	GVariantIter	iter;
+	const gchar	*path;
+
+	present = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+					(GDestroyNotify) g_variant_unref);
+	g_variant_iter_init(&iter, objs);
+	while (g_variant_iter_next(&iter, "{&o@a{sa{sv}}}", &path, &ifaces)) {
+		if (neardal_mgr_prv_in_scope(path) == FALSE) {
+			g_variant_unref(ifaces);
+			continue;
+		}
+		g_hash_table_insert(present, (gpointer) path, ifaces);
+	}
+
+	neardal_mgr_prv_resync_remove(present);
+
+	/* Adapters properties are read from the managed objects snapshot */
+	if (neardalMgr.dbus_objs != NULL)
+		g_variant_unref(neardalMgr.dbus_objs);
+	neardalMgr.dbus_objs = objs;
+
+	neardal_mgr_prv_resync_add(present);
+	g_hash_table_destroy(present);
+}
+
+/*****************************************************************************
+ * neardal_mgr_prv_resync: Neard (re)appeared on the bus. Read its managed
+ * objects again and compare them with the known ones. Agents are registered
+ * again.
+ ****************************************************************************/
+static errorCode_t neardal_mgr_prv_resync(void)
+{
+	GVariant	*objs	= NULL;
+	guint64		start;
+	gboolean	ok;
+
+	NEARDAL_TRACEIN();
+
+	start = neardal_stats_call_begin(NEARDAL_METHOD_GET_MANAGED_OBJECTS);
+	ok = object_manager_call_get_managed_objects_sync(neardalMgr.dbus_om,
+			&objs, NULL, &neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_GET_MANAGED_OBJECTS, start, ok);
+	if (!ok) {
+		NEARDAL_TRACE_ERR("%d:%s\n", neardalMgr.gerror->code,
+				 neardalMgr.gerror->message);
+		neardal_tools_prv_free_gerror(&neardalMgr.gerror);
+		return NEARDAL_ERROR_DBUS_CANNOT_INVOKE_METHOD;
+	}
+
+	neardal_mgr_prv_resync_objects(objs);
+	neardal_agent_prv_register_all();
+
+	NEARDAL_TRACEF("NEARDAL LIB adapterList contains %d elements\n",
+		      g_list_length(neardalMgr.prop.adpList));
+
+	return NEARDAL_SUCCESS;
+}
+
+static void neardal_mgr_prv_neard_appeared(GDBusConnection *conn,
+					   const gchar *name,
+					   const gchar *owner,
+					   gpointer user_data)
+{
+	(void) conn; /* remove warning */
+	(void) user_data; /* remove warning */
+
+	NEARDAL_TRACE_LOG("%s appeared (%s)\n", name, owner);
+	neardal_capture_prv_owner(owner);
+
+	/* First notification after a successful construct: nothing to do */
+	if (neardalMgr.neardSynced == TRUE)
+		return;
+
+	if (neardal_mgr_prv_resync() == NEARDAL_SUCCESS)
+		neardalMgr.neardSynced = TRUE;
+}
+
+static void neardal_mgr_prv_neard_vanished(GDBusConnection *conn,
+					   const gchar *name,
+					   gpointer user_data)
+{
+	(void) conn; /* remove warning */
+	(void) user_data; /* remove warning */
+
+	NEARDAL_TRACE_LOG("%s vanished\n", name);
+	neardal_capture_prv_owner(NULL);
+
+	/* Keep the known objects, they are compared on return of Neard */
+	neardalMgr.neardSynced = FALSE;
+}
+
+/*****************************************************************************
+ * neardal_mgr_prv_cb_scope_signal: ObjectManager signals received through the
+ * adapter scoped match rules
+ ****************************************************************************/
+static void neardal_mgr_prv_cb_scope_signal(GDBusConnection *conn,
+					    const gchar *sender,
+					    const gchar *objPath,
+					    const gchar *interface,
+					    const gchar *signal,
+					    GVariant *params,
+					    gpointer user_data)
+{
+	const gchar	*path;
+	GVariant	*ifaces;
+	const gchar	**names;
+
+	(void) conn; /* remove warning */
+	(void) sender; /* remove warning */
+	(void) objPath; /* remove warning */
+	(void) interface; /* remove warning */
+	(void) user_data; /* remove warning */
+
+	if (!strcmp(signal, "InterfacesAdded")) {
+		g_variant_get(params, "(&o@a{sa{sv}})", &path, &ifaces);
+		neardal_mgr_interfaces_added(NULL, path, ifaces);
+		g_variant_unref(ifaces);
+	} else if (!strcmp(signal, "InterfacesRemoved")) {
+		g_variant_get(params, "(&o^a&s)", &path, &names);
+		neardal_mgr_interfaces_removed(NULL, path, names);
+		g_free(names);
+	} else if (!strcmp(signal, "AdapterAdded")) {
+		g_variant_get(params, "(&o)", &path);
+		neardal_mgr_prv_cb_adapter_added(NULL, path, NULL);
+	} else if (!strcmp(signal, "AdapterRemoved")) {
+		g_variant_get(params, "(&o)", &path);
+		neardal_mgr_prv_cb_adapter_removed(NULL, path, NULL);
+	}
+}
+
+/*****************************************************************************
+ * neardal_mgr_prv_scope_subscribe: install match rules so that the bus daemon
+ * only forwards the ObjectManager signals of the opened adapter children
+ * ('arg0path') and the Manager signals of the adapter itself ('arg0')
+ ****************************************************************************/
+static void neardal_mgr_prv_scope_subscribe(void)
+{
+	static const struct {
+		const gchar	*iface;
+		const gchar	*signal;
+		gboolean	children;	/* arg0path "<adapter>/" */
+	} sigs[] = {
+		{ "org.freedesktop.DBus.ObjectManager", "InterfacesAdded",
+		  TRUE },
+		{ "org.freedesktop.DBus.ObjectManager", "InterfacesRemoved",
+		  TRUE },
+		{ "org.neard.Manager", "AdapterAdded", FALSE },
+		{ "org.neard.Manager", "AdapterRemoved", FALSE }
+	};
+	gchar			*arg0path;
+	guint			i;
+
+	G_STATIC_ASSERT(G_N_ELEMENTS(sigs) ==
+			G_N_ELEMENTS(neardalMgr.scopeSigIds));
+
+	arg0path = g_strconcat(neardalMgr.adpScope, "/", NULL);
+	for (i = 0; i < G_N_ELEMENTS(sigs); i++) {
+		NEARDAL_TRACEF("Subscribe '%s' (%s='%s')\n", sigs[i].signal,
+			       sigs[i].children ? "arg0path" : "arg0",
+			       sigs[i].children ? arg0path :
+						  neardalMgr.adpScope);
+		neardalMgr.scopeSigIds[i] = g_dbus_connection_signal_subscribe(
+					neardalMgr.conn, NEARD_DBUS_SERVICE,
+					sigs[i].iface, sigs[i].signal,
+					NEARD_MGR_PATH,
+					sigs[i].children ? arg0path :
+							   neardalMgr.adpScope,
+					sigs[i].children ?
+					G_DBUS_SIGNAL_FLAGS_MATCH_ARG0_PATH :
+					G_DBUS_SIGNAL_FLAGS_NONE,
+					neardal_mgr_prv_cb_scope_signal,
+					NULL, NULL);
+	}
+	g_free(arg0path);
+}
+
+/*****************************************************************************
+ * neardal_mgr_prv_replay: hand a captured Neard message to the handler the
+ * live signal (or GetManagedObjects reply) reaches. Return FALSE if the
+ * message is not one neardal handles.
+ ****************************************************************************/
+gboolean neardal_mgr_prv_replay(GDBusMessage *msg)
+{
+	GVariant	*body	= g_dbus_message_get_body(msg);
+	const gchar	*iface	= g_dbus_message_get_interface(msg);
+	const gchar	*member	= g_dbus_message_get_member(msg);
+	const gchar	*objPath = g_dbus_message_get_path(msg);
+	const gchar	*path, *name, **names;
+	GVariant	*v;
+	AdpProp		*adpProp = NULL;
+
+	if (body == NULL)
+		return FALSE;
+
+	if (g_dbus_message_get_message_type(msg) ==
+			G_DBUS_MESSAGE_TYPE_METHOD_RETURN) {
+		if (!g_variant_is_of_type(body,
+				G_VARIANT_TYPE("(a{oa{sa{sv}}})")))
+			return FALSE;
+		neardal_mgr_prv_resync_objects(g_variant_get_child_value(body,
+									0));
+		return TRUE;
+	}
+
+	if (iface == NULL || member == NULL || objPath == NULL)
+		return FALSE;
+
+	if (!strcmp(iface, "org.freedesktop.DBus.ObjectManager")) {
+		if (!strcmp(member, "InterfacesAdded") &&
+		    g_variant_is_of_type(body,
+				G_VARIANT_TYPE("(oa{sa{sv}})"))) {
+			g_variant_get(body, "(&o@a{sa{sv}})", &path, &v);
+			neardal_mgr_interfaces_added(NULL, path, v);
+			g_variant_unref(v);
+			return TRUE;
+		}
+		if (!strcmp(member, "InterfacesRemoved") &&
+		    g_variant_is_of_type(body, G_VARIANT_TYPE("(oas)"))) {
+			g_variant_get(body, "(&o^a&s)", &path, &names);
+			neardal_mgr_interfaces_removed(NULL, path, names);
+			g_free(names);
+			return TRUE;
+		}
+		return FALSE;
+	}
+
+	if (!strcmp(iface, "org.neard.Manager")) {
+		if (!g_variant_is_of_type(body, G_VARIANT_TYPE("(o)")))
+			return FALSE;
+		g_variant_get(body, "(&o)", &path);
+		if (!strcmp(member, "AdapterAdded"))
+			neardal_mgr_prv_cb_adapter_added(NULL, path, NULL);
+		else if (!strcmp(member, "AdapterRemoved"))
+			neardal_mgr_prv_cb_adapter_removed(NULL, path, NULL);
+		else
+			return FALSE;
+		return TRUE;
+	}
+
+	/* Adapter signals */
+	if (neardal_mgr_prv_get_adapter((gchar *) objPath, &adpProp)
+			!= NEARDAL_SUCCESS || strcmp(adpProp->name, objPath))
+		return FALSE;
+
+	if (!strcmp(iface, "org.freedesktop.DBus.Properties") &&
+	    !strcmp(member, "PropertiesChanged") &&
+	    g_variant_is_of_type(body, G_VARIANT_TYPE("(sa{sv}as)"))) {
+		g_variant_get(body, "(&s@a{sv}@as)", &name, &v, NULL);
+		if (strcmp(name, "org.neard.Adapter") == 0)
+			neardal_adp_prv_properties_changed(adpProp, v);
+		g_variant_unref(v);
+		return TRUE;
+	}
+
+	if (!strcmp(iface, "org.neard.Adapter") &&
+	    g_variant_is_of_type(body, G_VARIANT_TYPE("(o)"))) {
+		g_variant_get(body, "(&o)", &path);
+		if (!strcmp(member, "TagFound"))
+			neardal_adp_prv_cb_tag_found(NULL, path, adpProp);
+		else if (!strcmp(member, "TagLost"))
+			neardal_adp_prv_cb_tag_lost(NULL, path, adpProp);
+		else
+			return FALSE;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
 /*****************************************************************************
  * neardal_mgr_create: Get Neard Manager Properties = NFC Adapters list.
  * Create a DBus proxy for the first one NFC adapter if present
@@ -424,6 +968,9 @@ errorCode_t neardal_mgr_create(void)
 	gsize		adpArrayLen;
 	char		*adpName;
 	guint		len;
+	GDBusProxyFlags	proxyFlags;
+	guint64		start;
+	gchar		*owner;
 
 	NEARDAL_TRACEIN();
 	if (neardalMgr.proxy != NULL) {
@@ -440,12 +987,28 @@ errorCode_t neardal_mgr_create(void)
 		neardalMgr.proxy = NULL;
 	}
 
+	/* Time stamp Neard signals on arrival, for event queueing latency.
+	 * Installed first so a capture gets the initial objects too */
+	if (neardalMgr.filterId == 0)
+		neardalMgr.filterId = g_dbus_connection_add_filter(
+					neardalMgr.conn, neardal_stats_filter,
+					NULL, NULL);
+
+	/* Adapter scoped: no global match rules, AdapterAdded/Removed too
+	 * come through neardal_mgr_prv_scope_subscribe() */
+	proxyFlags = G_DBUS_PROXY_FLAGS_NONE;
+	if (neardalMgr.adpScope != NULL)
+		proxyFlags = G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS;
+
+	start = neardal_stats_call_begin(NEARDAL_METHOD_NEW_PROXY);
 	neardalMgr.proxy = org_neard_manager_proxy_new_sync(neardalMgr.conn,
-					G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+							proxyFlags,
 							NEARD_DBUS_SERVICE,
 							NEARD_MGR_PATH,
 							NULL, /* GCancellable */
 							&neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_NEW_PROXY, start,
+			   neardalMgr.gerror == NULL);
 
 	if (neardalMgr.gerror != NULL) {
 		NEARDAL_TRACE_ERR(
@@ -456,6 +1019,12 @@ errorCode_t neardal_mgr_create(void)
 		return NEARDAL_ERROR_DBUS_CANNOT_CREATE_PROXY;
 	}
 
+	/* Neard messages are captured by sender, before the name watcher
+	 * reports it */
+	owner = g_dbus_proxy_get_name_owner(G_DBUS_PROXY(neardalMgr.proxy));
+	neardal_capture_prv_owner(owner);
+	g_free(owner);
+
 	g_datalist_init(&(neardalMgr.dbus_data));
 
 	if (neardalMgr.dbus_om != NULL) {
@@ -469,9 +1038,13 @@ errorCode_t neardal_mgr_create(void)
 
 	neardalMgr.gerror = NULL;
 
-	neardalMgr.dbus_om = object_manager_proxy_new_sync(neardalMgr.conn, 0,
+	start = neardal_stats_call_begin(NEARDAL_METHOD_NEW_PROXY);
+	neardalMgr.dbus_om = object_manager_proxy_new_sync(neardalMgr.conn,
+				proxyFlags,
 				NEARD_DBUS_SERVICE, NEARD_MGR_PATH, NULL,
 				&neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_NEW_PROXY, start,
+			   neardalMgr.gerror == NULL);
 	if (neardalMgr.gerror) {
 		NEARDAL_TRACE_ERR("Error creating ObjectManager proxy: %s\n",
 					neardalMgr.gerror->message);
@@ -492,6 +1065,10 @@ errorCode_t neardal_mgr_create(void)
 		g_strfreev(adpArray);
 	}
 
+	/* Records a client asked for before the registry was (re)built */
+	if (neardalMgr.rcdWanted == TRUE && neardalMgr.dbus_objs != NULL)
+		neardal_mgr_prv_cache_records(neardalMgr.dbus_objs);
+
 	/* Register for manager signals 'PropertyChanged(String,Variant)' */
 	NEARDAL_TRACEF("Register Neard-Manager Signal 'PropertyChanged'\n");
 	g_signal_connect(neardalMgr.proxy,
@@ -519,6 +1096,20 @@ errorCode_t neardal_mgr_create(void)
 	g_signal_connect(neardalMgr.dbus_om, "interfaces-removed",
 		G_CALLBACK(neardal_mgr_interfaces_removed), NULL);
 
+	if (neardalMgr.adpScope != NULL && neardalMgr.scopeSigIds[0] == 0)
+		neardal_mgr_prv_scope_subscribe();
+
+	/* Watch Neard restarts to resync the known objects */
+	neardalMgr.neardSynced = (err == NEARDAL_SUCCESS ||
+				  err == NEARDAL_ERROR_NO_ADAPTER);
+	if (neardalMgr.neardWatchId == 0)
+		neardalMgr.neardWatchId = g_bus_watch_name_on_connection(
+					neardalMgr.conn, NEARD_DBUS_SERVICE,
+					G_BUS_NAME_WATCHER_FLAGS_NONE,
+					neardal_mgr_prv_neard_appeared,
+					neardal_mgr_prv_neard_vanished,
+					NULL, NULL);
+
 	return err;
 }
 
@@ -529,8 +1120,27 @@ void neardal_mgr_destroy(void)
 {
 	GList	*node;
 	GList	**tmpList;
+	guint	len;
 
 	NEARDAL_TRACEIN();
+	if (neardalMgr.neardWatchId > 0)
+		g_bus_unwatch_name(neardalMgr.neardWatchId);
+	neardalMgr.neardWatchId = 0;
+	neardalMgr.neardSynced = FALSE;
+	neardal_capture_prv_owner(NULL);
+
+	if (neardalMgr.filterId > 0)
+		g_dbus_connection_remove_filter(neardalMgr.conn,
+						neardalMgr.filterId);
+	neardalMgr.filterId = 0;
+
+	for (len = 0; len < G_N_ELEMENTS(neardalMgr.scopeSigIds); len++) {
+		if (neardalMgr.scopeSigIds[len] > 0)
+			g_dbus_connection_signal_unsubscribe(neardalMgr.conn,
+						neardalMgr.scopeSigIds[len]);
+		neardalMgr.scopeSigIds[len] = 0;
+	}
+
 	/* Remove all adapters */
 	tmpList = &neardalMgr.prop.adpList;
 	while (g_list_length((*tmpList))) {
@@ -539,6 +1149,14 @@ void neardal_mgr_destroy(void)
 	}
 	neardalMgr.prop.adpList = (*tmpList);
 
+	g_datalist_clear(&(neardalMgr.dbus_data));
+	neardalMgr.dbus_data = NULL;
+
+	if (neardalMgr.dbus_objs != NULL)
+		g_variant_unref(neardalMgr.dbus_objs);
+	neardalMgr.dbus_objs = NULL;
+
+	/* Replayed capture: no proxies */
 	if (neardalMgr.proxy == NULL)
 		return;
 
@@ -560,12 +1178,6 @@ void neardal_mgr_destroy(void)
 	g_signal_handlers_disconnect_by_func(neardalMgr.dbus_om,
 		NEARDAL_G_CALLBACK(neardal_mgr_interfaces_removed), NULL);
 
-	g_datalist_clear(&(neardalMgr.dbus_data));
-	neardalMgr.dbus_data = NULL;
-
-	g_variant_unref(neardalMgr.dbus_objs);
-	neardalMgr.dbus_objs = NULL;
-
 	g_object_unref(neardalMgr.dbus_om);
 	neardalMgr.dbus_om = NULL;
 }
@@ -53,6 +53,18 @@ errorCode_t neardal_mgr_prv_get_adapter_from_proxy(OrgNeardAdapter *adpProxy,
  ****************************************************************************/
 errorCode_t neardal_mgr_create(void);
 
+/*****************************************************************************
+ * neardal_mgr_prv_want_records: start caching records, reading the ones
+ * already published by Neard on first call
+ ****************************************************************************/
+void neardal_mgr_prv_want_records(void);
+
+/*****************************************************************************
+ * neardal_mgr_prv_replay: dispatch a captured Neard message (signal or
+ * GetManagedObjects reply) as if received, FALSE if not handled
+ ****************************************************************************/
+gboolean neardal_mgr_prv_replay(GDBusMessage *msg);
+
 TagProp *neardal_mgr_tag_search(const gchar *tag);
 TagProp *neardal_mgr_tag_search_by_record(const gchar *record);
 
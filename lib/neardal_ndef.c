@@ -0,0 +1,371 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <string.h>
+
+#include "neardal_ndef.h"
+
+#define NDEF_TLV_NULL		0x00
+#define NDEF_TLV_MESSAGE	0x03
+#define NDEF_TLV_TERMINATOR	0xFE
+
+/*****************************************************************************
+ * neardal_ndef_prv_header: Read one record header at 'pos' and check that
+ * type, id and payload fit in the buffer. 'next' is set to the offset of the
+ * following record.
+ ****************************************************************************/
+static errorCode_t neardal_ndef_prv_header(const unsigned char *buf,
+					   unsigned int len, unsigned int pos,
+					   neardal_ndef_record *rcd,
+					   unsigned int *next)
+{
+	const unsigned char	*p	= buf + pos;
+	unsigned int		left	= len - pos;
+	unsigned int		hdrLen;
+	unsigned int		idLen	= 0;
+	unsigned int		payloadLen;
+
+	if (pos >= len || left < 3)
+		return NEARDAL_ERROR_INVALID_RECORD;
+
+	if (p[0] & NEARDAL_NDEF_SR) {
+		payloadLen = p[2];
+		hdrLen = 3;
+	} else {
+		if (left < 6)
+			return NEARDAL_ERROR_INVALID_RECORD;
+		payloadLen = ((unsigned int) p[2] << 24) | (p[3] << 16) |
+			     (p[4] << 8) | p[5];
+		hdrLen = 6;
+	}
+	if (p[0] & NEARDAL_NDEF_IL) {
+		if (left < hdrLen + 1)
+			return NEARDAL_ERROR_INVALID_RECORD;
+		idLen = p[hdrLen++];
+	}
+
+	/* Each length checked against what is left: no overflow possible */
+	left -= hdrLen;
+	if (p[1] > left)
+		return NEARDAL_ERROR_INVALID_RECORD;
+	left -= p[1];
+	if (idLen > left)
+		return NEARDAL_ERROR_INVALID_RECORD;
+	left -= idLen;
+	if (payloadLen > left)
+		return NEARDAL_ERROR_INVALID_RECORD;
+
+	rcd->flags	= p[0];
+	rcd->tnf	= p[0] & NEARDAL_NDEF_TNF_MASK;
+	rcd->typeLen	= p[1];
+	rcd->type	= p + hdrLen;
+	rcd->idLen	= idLen;
+	rcd->id		= idLen ? rcd->type + rcd->typeLen : NULL;
+	rcd->payloadLen	= payloadLen;
+	rcd->payload	= rcd->type + rcd->typeLen + idLen;
+	*next = pos + hdrLen + rcd->typeLen + idLen + payloadLen;
+
+	switch (rcd->tnf) {
+	case NEARDAL_NDEF_TNF_EMPTY:
+		if (rcd->typeLen || idLen || payloadLen)
+			return NEARDAL_ERROR_INVALID_RECORD;
+		break;
+	case NEARDAL_NDEF_TNF_UNKNOWN:
+	case NEARDAL_NDEF_TNF_UNCHANGED:
+		if (rcd->typeLen)
+			return NEARDAL_ERROR_INVALID_RECORD;
+		break;
+	case NEARDAL_NDEF_TNF_WELL_KNOWN:
+	case NEARDAL_NDEF_TNF_MIME:
+	case NEARDAL_NDEF_TNF_URI:
+	case NEARDAL_NDEF_TNF_EXTERNAL:
+		if (rcd->typeLen == 0)
+			return NEARDAL_ERROR_INVALID_RECORD;
+		break;
+	default:	/* Reserved */
+		return NEARDAL_ERROR_INVALID_RECORD;
+	}
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_ndef_prv_record: Read the record (all its chunks) at the current
+ * position of a message and check its place in the message (MB/ME)
+ ****************************************************************************/
+static errorCode_t neardal_ndef_prv_record(const unsigned char *buf,
+					   unsigned int len,
+					   unsigned int *pos,
+					   neardal_ndef_record *rcd)
+{
+	neardal_ndef_record	chunk;
+	unsigned int		next;
+	unsigned char		last;
+	errorCode_t		err;
+
+	err = neardal_ndef_prv_header(buf, len, *pos, rcd, &next);
+	if (err != NEARDAL_SUCCESS)
+		return err;
+
+	/* MB on first record only, unchanged TNF only for chunks */
+	if (!(rcd->flags & NEARDAL_NDEF_MB) != (*pos != 0) ||
+	    rcd->tnf == NEARDAL_NDEF_TNF_UNCHANGED)
+		return NEARDAL_ERROR_INVALID_RECORD;
+
+	rcd->raw	= buf + *pos;
+	rcd->chunks	= 1;
+	rcd->totalLen	= rcd->payloadLen;
+	last		= rcd->flags;
+
+	while (last & NEARDAL_NDEF_CF) {
+		if (last & NEARDAL_NDEF_ME)
+			return NEARDAL_ERROR_INVALID_RECORD;
+
+		err = neardal_ndef_prv_header(buf, len, next, &chunk, &next);
+		if (err != NEARDAL_SUCCESS)
+			return err;
+		if (chunk.tnf != NEARDAL_NDEF_TNF_UNCHANGED ||
+		    (chunk.flags & (NEARDAL_NDEF_MB | NEARDAL_NDEF_IL)))
+			return NEARDAL_ERROR_INVALID_RECORD;
+		if (rcd->totalLen + chunk.payloadLen < rcd->totalLen)
+			return NEARDAL_ERROR_INVALID_RECORD;
+
+		rcd->totalLen += chunk.payloadLen;
+		rcd->chunks++;
+		last = chunk.flags;
+	}
+
+	rcd->flags	= (rcd->flags & ~NEARDAL_NDEF_ME) |
+			  (last & NEARDAL_NDEF_ME);
+	rcd->rawLen	= next - *pos;
+	*pos		= next;
+
+	/* ME must be on the last record of the message, and only there */
+	if (!(last & NEARDAL_NDEF_ME) != (next != len))
+		return NEARDAL_ERROR_INVALID_RECORD;
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_ndef_find_message: Find the NDEF message TLV in tag memory
+ ****************************************************************************/
+errorCode_t neardal_ndef_find_message(const unsigned char *tlv,
+				      unsigned int len,
+				      const unsigned char **msg,
+				      unsigned int *msgLen)
+{
+	unsigned int	pos = 0;
+	unsigned int	vlen;
+	unsigned char	type;
+
+	if (tlv == NULL || msg == NULL || msgLen == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	while (pos < len) {
+		type = tlv[pos++];
+		if (type == NDEF_TLV_NULL)
+			continue;
+		if (type == NDEF_TLV_TERMINATOR || pos >= len)
+			break;
+
+		/* 1 byte length, or 0xFF followed by a 2 bytes length */
+		vlen = tlv[pos++];
+		if (vlen == 0xFF) {
+			if (len - pos < 2)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			vlen = (tlv[pos] << 8) | tlv[pos + 1];
+			pos += 2;
+		}
+		if (vlen > len - pos)
+			return NEARDAL_ERROR_INVALID_RECORD;
+
+		if (type == NDEF_TLV_MESSAGE) {
+			*msg = tlv + pos;
+			*msgLen = vlen;
+			return NEARDAL_SUCCESS;
+		}
+		pos += vlen;
+	}
+
+	return NEARDAL_ERROR_NO_RECORD;
+}
+
+/*****************************************************************************
+ * neardal_ndef_iter_init: Initialize an iterator over a NDEF message
+ ****************************************************************************/
+errorCode_t neardal_ndef_iter_init(neardal_ndef_iter *iter,
+				   const unsigned char *msg, unsigned int len,
+				   int flags)
+{
+	if (iter == NULL || (msg == NULL && len > 0))
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	iter->flags		= flags;
+	iter->depth		= 0;
+	iter->stack[0].buf	= msg;
+	iter->stack[0].len	= len;
+	iter->stack[0].pos	= 0;
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_ndef_iter_next: Get next record of a NDEF message
+ ****************************************************************************/
+errorCode_t neardal_ndef_iter_next(neardal_ndef_iter *iter,
+				   neardal_ndef_record *rcd)
+{
+	errorCode_t	err;
+	unsigned int	*pos;
+
+	if (iter == NULL || rcd == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	/* Back to the enclosing message at the end of a nested one */
+	while (iter->stack[iter->depth].pos == iter->stack[iter->depth].len) {
+		if (iter->depth == 0)
+			return NEARDAL_ERROR_NO_RECORD;
+		iter->depth--;
+	}
+
+	pos = &iter->stack[iter->depth].pos;
+	err = neardal_ndef_prv_record(iter->stack[iter->depth].buf,
+				      iter->stack[iter->depth].len, pos, rcd);
+	if (err != NEARDAL_SUCCESS) {
+		/* Stop iterating a malformed message */
+		iter->depth = 0;
+		iter->stack[0].pos = iter->stack[0].len;
+		return err;
+	}
+	rcd->depth = iter->depth;
+
+	/* Smart Poster: its payload is a NDEF message */
+	if ((iter->flags & NEARDAL_NDEF_NESTED) &&
+	    rcd->tnf == NEARDAL_NDEF_TNF_WELL_KNOWN && rcd->typeLen == 2 &&
+	    rcd->type[0] == 'S' && rcd->type[1] == 'p' &&
+	    rcd->chunks == 1 && rcd->payloadLen > 0) {
+		if (iter->depth == NEARDAL_NDEF_MAX_DEPTH) {
+			iter->depth = 0;
+			iter->stack[0].pos = iter->stack[0].len;
+			return NEARDAL_ERROR_INVALID_RECORD;
+		}
+		iter->depth++;
+		iter->stack[iter->depth].buf = rcd->payload;
+		iter->stack[iter->depth].len = rcd->payloadLen;
+		iter->stack[iter->depth].pos = 0;
+	}
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_ndef_parse: Parse a whole NDEF message into records views
+ ****************************************************************************/
+errorCode_t neardal_ndef_parse(const unsigned char *msg, unsigned int len,
+			       neardal_ndef_record *rcds, unsigned int maxRcds,
+			       unsigned int *nbRcds)
+{
+	neardal_ndef_iter	iter;
+	neardal_ndef_record	rcd;
+	errorCode_t		err;
+	unsigned int		count = 0;
+
+	if (nbRcds == NULL || (rcds == NULL && maxRcds > 0))
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	err = neardal_ndef_iter_init(&iter, msg, len, NEARDAL_NDEF_NESTED);
+	while (err == NEARDAL_SUCCESS) {
+		err = neardal_ndef_iter_next(&iter, count < maxRcds ?
+					     &rcds[count] : &rcd);
+		if (err == NEARDAL_SUCCESS)
+			count++;
+	}
+	*nbRcds = count;
+
+	if (err == NEARDAL_ERROR_NO_RECORD && count > 0)
+		err = NEARDAL_SUCCESS;
+
+	return err;
+}
+
+/*****************************************************************************
+ * neardal_ndef_chunk: Get the payload of one chunk of a record
+ ****************************************************************************/
+errorCode_t neardal_ndef_chunk(const neardal_ndef_record *rcd,
+			       unsigned int index,
+			       const unsigned char **data, unsigned int *len)
+{
+	neardal_ndef_record	chunk;
+	unsigned int		pos = 0;
+	unsigned int		i;
+	errorCode_t		err;
+
+	if (rcd == NULL || data == NULL || len == NULL ||
+	    index >= rcd->chunks)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	for (i = 0; i <= index; i++) {
+		err = neardal_ndef_prv_header(rcd->raw, rcd->rawLen, pos,
+					      &chunk, &pos);
+		if (err != NEARDAL_SUCCESS)
+			return err;
+	}
+	*data = chunk.payload;
+	*len = chunk.payloadLen;
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_ndef_copy_payload: Copy the payload of a record, chunks
+ * reassembled
+ ****************************************************************************/
+unsigned int neardal_ndef_copy_payload(const neardal_ndef_record *rcd,
+				       unsigned char *out,
+				       unsigned int outLen)
+{
+	neardal_ndef_record	chunk;
+	unsigned int		pos = 0;
+	unsigned int		copied = 0;
+	unsigned int		i, n;
+
+	if (rcd == NULL || out == NULL)
+		return 0;
+
+	if (rcd->chunks == 1) {
+		n = rcd->payloadLen < outLen ? rcd->payloadLen : outLen;
+		memcpy(out, rcd->payload, n);
+		return n;
+	}
+
+	for (i = 0; i < rcd->chunks && copied < outLen; i++) {
+		if (neardal_ndef_prv_header(rcd->raw, rcd->rawLen, pos,
+					    &chunk, &pos) != NEARDAL_SUCCESS)
+			break;
+		n = chunk.payloadLen;
+		if (n > outLen - copied)
+			n = outLen - copied;
+		memcpy(out + copied, chunk.payload, n);
+		copied += n;
+	}
+
+	return copied;
+}
@@ -0,0 +1,202 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+/*!
+ * @file neardal_ndef.h
+ *
+ * @brief Defines NEARDAL raw NDEF parser (NFC Forum NDEF 1.0)
+ *
+ ******************************************************************************/
+
+#ifndef NEARDAL_NDEF_H
+#define NEARDAL_NDEF_H
+
+#include "neardal_errors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/*! @brief NEARDAL NDEF parser
+ * @addtogroup NEARDAL_NDEF NDEF
+ * @{
+*/
+
+/*! @brief NDEF record header flags */
+#define NEARDAL_NDEF_MB			0x80	/*!< Message Begin */
+#define NEARDAL_NDEF_ME			0x40	/*!< Message End */
+#define NEARDAL_NDEF_CF			0x20	/*!< Chunk Flag */
+#define NEARDAL_NDEF_SR			0x10	/*!< Short Record */
+#define NEARDAL_NDEF_IL			0x08	/*!< ID Length present */
+#define NEARDAL_NDEF_TNF_MASK		0x07
+
+/*! @brief Type Name Format values */
+#define NEARDAL_NDEF_TNF_EMPTY		0x00
+#define NEARDAL_NDEF_TNF_WELL_KNOWN	0x01
+#define NEARDAL_NDEF_TNF_MIME		0x02
+#define NEARDAL_NDEF_TNF_URI		0x03
+#define NEARDAL_NDEF_TNF_EXTERNAL	0x04
+#define NEARDAL_NDEF_TNF_UNKNOWN	0x05
+#define NEARDAL_NDEF_TNF_UNCHANGED	0x06
+
+/*! @brief Maximum Smart Poster nesting level followed by the iterator */
+#define NEARDAL_NDEF_MAX_DEPTH		4
+
+/*! @brief Iterator flag: descend into Smart Poster payloads */
+#define NEARDAL_NDEF_NESTED		0x01
+
+/*!
+ * @brief View of one NDEF record. All pointers point into the parsed buffer
+ * (nothing is allocated). A chunked record is seen as one record: 'payload'
+ * is the first chunk, use @link neardal_ndef_chunk @endlink or
+ * @link neardal_ndef_copy_payload @endlink to get the others.
+ **/
+typedef struct {
+/*! @brief Header flags of the (first chunk) record */
+	unsigned char		flags;
+/*! @brief Type Name Format */
+	unsigned char		tnf;
+/*! @brief Nesting level (0 for the top level message) */
+	unsigned short		depth;
+/*! @brief Record type */
+	const unsigned char	*type;
+	unsigned int		typeLen;
+/*! @brief Record identifier (NULL if none) */
+	const unsigned char	*id;
+	unsigned int		idLen;
+/*! @brief Payload of the first chunk */
+	const unsigned char	*payload;
+	unsigned int		payloadLen;
+/*! @brief Number of chunks (1 for a non chunked record) */
+	unsigned int		chunks;
+/*! @brief Payload length, all chunks included */
+	unsigned int		totalLen;
+/*! @brief Whole record, all chunks included */
+	const unsigned char	*raw;
+	unsigned int		rawLen;
+} neardal_ndef_record;
+
+/*!
+ * @brief NDEF message iterator (caller allocated, see
+ * @link neardal_ndef_iter_init @endlink)
+ **/
+typedef struct {
+	int			flags;
+	unsigned int		depth;
+	struct {
+		const unsigned char	*buf;
+		unsigned int		len;
+		unsigned int		pos;
+	} stack[NEARDAL_NDEF_MAX_DEPTH + 1];
+} neardal_ndef_iter;
+
+/*! \fn errorCode_t neardal_ndef_find_message(const unsigned char *tlv,
+ * unsigned int len, const unsigned char **msg, unsigned int *msgLen)
+ * @brief Find the NDEF message in a tag memory area (TLV blocks, type 0x03)
+ *
+ * @param tlv TLV blocks
+ * @param len TLV blocks length
+ * @param msg NDEF message found (points into tlv)
+ * @param msgLen NDEF message length
+ * @return errorCode_t error code (NEARDAL_ERROR_NO_RECORD if no message)
+ **/
+errorCode_t neardal_ndef_find_message(const unsigned char *tlv,
+				      unsigned int len,
+				      const unsigned char **msg,
+				      unsigned int *msgLen);
+
+/*! \fn errorCode_t neardal_ndef_iter_init(neardal_ndef_iter *iter,
+ * const unsigned char *msg, unsigned int len, int flags)
+ * @brief Initialize an iterator over a NDEF message
+ *
+ * @param iter iterator
+ * @param msg NDEF message (must stay valid while iterating)
+ * @param len NDEF message length
+ * @param flags 0 or NEARDAL_NDEF_NESTED
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_ndef_iter_init(neardal_ndef_iter *iter,
+				   const unsigned char *msg, unsigned int len,
+				   int flags);
+
+/*! \fn errorCode_t neardal_ndef_iter_next(neardal_ndef_iter *iter,
+ * neardal_ndef_record *rcd)
+ * @brief Get next record. With NEARDAL_NDEF_NESTED, the records of a Smart
+ * Poster follow the Smart Poster record itself (depth + 1).
+ *
+ * @param iter iterator
+ * @param rcd record view
+ * @return NEARDAL_SUCCESS, NEARDAL_ERROR_NO_RECORD at end of message or
+ * NEARDAL_ERROR_INVALID_RECORD on a malformed message
+ **/
+errorCode_t neardal_ndef_iter_next(neardal_ndef_iter *iter,
+				   neardal_ndef_record *rcd);
+
+/*! \fn errorCode_t neardal_ndef_parse(const unsigned char *msg,
+ * unsigned int len, neardal_ndef_record *rcds, unsigned int maxRcds,
+ * unsigned int *nbRcds)
+ * @brief Parse a whole NDEF message (Smart Posters included) into an array
+ * of record views
+ *
+ * @param msg NDEF message
+ * @param len NDEF message length
+ * @param rcds array of records views (caller allocated)
+ * @param maxRcds size of rcds
+ * @param nbRcds number of records in the message (may be > maxRcds, only
+ * maxRcds views are filled then)
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_ndef_parse(const unsigned char *msg, unsigned int len,
+			       neardal_ndef_record *rcds, unsigned int maxRcds,
+			       unsigned int *nbRcds);
+
+/*! \fn errorCode_t neardal_ndef_chunk(const neardal_ndef_record *rcd,
+ * unsigned int index, const unsigned char **data, unsigned int *len)
+ * @brief Get the payload of one chunk of a record
+ *
+ * @param rcd record view
+ * @param index chunk index (< rcd->chunks)
+ * @param data chunk payload (points into the parsed buffer)
+ * @param len chunk payload length
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_ndef_chunk(const neardal_ndef_record *rcd,
+			       unsigned int index,
+			       const unsigned char **data, unsigned int *len);
+
+/*! \fn unsigned int neardal_ndef_copy_payload(const neardal_ndef_record *rcd,
+ * unsigned char *out, unsigned int outLen)
+ * @brief Copy the payload of a record, chunks reassembled
+ *
+ * @param rcd record view
+ * @param out destination buffer
+ * @param outLen destination buffer length
+ * @return number of bytes copied (at most rcd->totalLen)
+ **/
+unsigned int neardal_ndef_copy_payload(const neardal_ndef_record *rcd,
+				       unsigned char *out,
+				       unsigned int outLen);
+
+/* @}*/
+
+#ifdef __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif /* NEARDAL_NDEF_H */
@@ -0,0 +1,262 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <string.h>
+
+#include "neardal_oob.h"
+
+/* OOB data length and device address precede the EIR data structures */
+#define EIR_HEADER_LEN		8
+#define BDADDR_LEN		6
+
+#define WSC_SSID_MAX_LEN	32
+#define WSC_KEY_MAX_LEN		64
+
+void neardal_oob_iter_init(neardal_oob_iter *iter, const unsigned char *buf,
+			   unsigned int len)
+{
+	iter->buf = buf;
+	iter->len = buf ? len : 0;
+	iter->pos = 0;
+}
+
+/*****************************************************************************
+ * neardal_oob_eir_next: One EIR data structure: length (type included), type,
+ * data. A null length ends the significant part.
+ ****************************************************************************/
+errorCode_t neardal_oob_eir_next(neardal_oob_iter *iter, unsigned char *type,
+				 const unsigned char **data, unsigned int *len)
+{
+	unsigned int	left, fieldLen;
+
+	if (iter == NULL || type == NULL || data == NULL || len == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	if (iter->pos >= iter->len)
+		return NEARDAL_ERROR_NO_RECORD;
+	left = iter->len - iter->pos;
+	fieldLen = iter->buf[iter->pos];
+	if (fieldLen == 0) {
+		iter->pos = iter->len;
+		return NEARDAL_ERROR_NO_RECORD;
+	}
+	if (fieldLen > left - 1)
+		return NEARDAL_ERROR_INVALID_RECORD;
+
+	*type = iter->buf[iter->pos + 1];
+	*data = iter->buf + iter->pos + 2;
+	*len = fieldLen - 1;
+	iter->pos += 1 + fieldLen;
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_oob_wsc_next: One WSC attribute: type, length (big endian, 16 bits
+ * each), value
+ ****************************************************************************/
+errorCode_t neardal_oob_wsc_next(neardal_oob_iter *iter, unsigned short *type,
+				 const unsigned char **data, unsigned int *len)
+{
+	const unsigned char	*p;
+	unsigned int		left, attrLen;
+
+	if (iter == NULL || type == NULL || data == NULL || len == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	if (iter->pos >= iter->len)
+		return NEARDAL_ERROR_NO_RECORD;
+	left = iter->len - iter->pos;
+	if (left < 4)
+		return NEARDAL_ERROR_INVALID_RECORD;
+	p = iter->buf + iter->pos;
+	attrLen = (p[2] << 8) | p[3];
+	if (attrLen > left - 4)
+		return NEARDAL_ERROR_INVALID_RECORD;
+
+	*type = (p[0] << 8) | p[1];
+	*data = p + 4;
+	*len = attrLen;
+	iter->pos += 4 + attrLen;
+
+	return NEARDAL_SUCCESS;
+}
+
+errorCode_t neardal_oob_parse_eir(const unsigned char *blob, unsigned int len,
+				  neardal_oob_eir *eir)
+{
+	neardal_oob_iter	iter;
+	const unsigned char	*data;
+	unsigned int		oobLen, dataLen;
+	unsigned char		type;
+	errorCode_t		err;
+
+	if (blob == NULL || eir == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	memset(eir, 0, sizeof(*eir));
+	if (len < EIR_HEADER_LEN)
+		return NEARDAL_ERROR_INVALID_RECORD;
+	/* OOB data length, header included, bytes after it are ignored */
+	oobLen = blob[0] | (blob[1] << 8);
+	if (oobLen < EIR_HEADER_LEN || oobLen > len)
+		return NEARDAL_ERROR_INVALID_RECORD;
+
+	eir->address = blob + 2;
+	eir->eir = blob + EIR_HEADER_LEN;
+	eir->eirLen = oobLen - EIR_HEADER_LEN;
+
+	neardal_oob_iter_init(&iter, eir->eir, eir->eirLen);
+	while ((err = neardal_oob_eir_next(&iter, &type, &data, &dataLen))
+			== NEARDAL_SUCCESS) {
+		switch (type) {
+		case NEARDAL_EIR_CLASS_OF_DEVICE:
+			if (dataLen != 3)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			eir->classOfDevice = data;
+			break;
+		case NEARDAL_EIR_SP_HASH:
+			if (dataLen != 16)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			eir->hash = data;
+			break;
+		case NEARDAL_EIR_SP_RANDOMIZER:
+			if (dataLen != 16)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			eir->randomizer = data;
+			break;
+		case NEARDAL_EIR_NAME_SHORT:
+		case NEARDAL_EIR_NAME_COMPLETE:
+			eir->name = data;
+			eir->nameLen = dataLen;
+			eir->nameComplete = (type == NEARDAL_EIR_NAME_COMPLETE);
+			break;
+		case NEARDAL_EIR_UUID16_SOME:
+		case NEARDAL_EIR_UUID16_ALL:
+			if (dataLen % 2)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			eir->uuid16 = data;
+			eir->uuid16Len = dataLen;
+			break;
+		case NEARDAL_EIR_UUID32_SOME:
+		case NEARDAL_EIR_UUID32_ALL:
+			if (dataLen % 4)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			eir->uuid32 = data;
+			eir->uuid32Len = dataLen;
+			break;
+		case NEARDAL_EIR_UUID128_SOME:
+		case NEARDAL_EIR_UUID128_ALL:
+			if (dataLen % 16)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			eir->uuid128 = data;
+			eir->uuid128Len = dataLen;
+			break;
+		}
+	}
+
+	return err == NEARDAL_ERROR_NO_RECORD ? NEARDAL_SUCCESS : err;
+}
+
+/*****************************************************************************
+ * neardal_oob_prv_wsc_attrs: Take the known attributes of one level of a WSC
+ * blob. 'credential' is set to the first credential found, if any.
+ ****************************************************************************/
+static errorCode_t neardal_oob_prv_wsc_attrs(const unsigned char *buf,
+					     unsigned int len,
+					     neardal_oob_wsc *wsc,
+					     neardal_oob_iter *credential)
+{
+	neardal_oob_iter	iter;
+	const unsigned char	*data;
+	unsigned int		dataLen;
+	unsigned short		type;
+	errorCode_t		err;
+
+	neardal_oob_iter_init(&iter, buf, len);
+	while ((err = neardal_oob_wsc_next(&iter, &type, &data, &dataLen))
+			== NEARDAL_SUCCESS) {
+		switch (type) {
+		case NEARDAL_WSC_VERSION:
+			if (dataLen != 1)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			wsc->version = data[0];
+			break;
+		case NEARDAL_WSC_SSID:
+			if (dataLen > WSC_SSID_MAX_LEN)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			wsc->ssid = data;
+			wsc->ssidLen = dataLen;
+			break;
+		case NEARDAL_WSC_NETWORK_KEY:
+			if (dataLen > WSC_KEY_MAX_LEN)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			wsc->networkKey = data;
+			wsc->networkKeyLen = dataLen;
+			break;
+		case NEARDAL_WSC_AUTH_TYPE:
+			if (dataLen != 2)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			wsc->authType = (data[0] << 8) | data[1];
+			break;
+		case NEARDAL_WSC_ENCR_TYPE:
+			if (dataLen != 2)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			wsc->encrType = (data[0] << 8) | data[1];
+			break;
+		case NEARDAL_WSC_MAC_ADDRESS:
+			if (dataLen != BDADDR_LEN)
+				return NEARDAL_ERROR_INVALID_RECORD;
+			wsc->macAddress = data;
+			break;
+		case NEARDAL_WSC_CREDENTIAL:
+			if (credential != NULL && credential->buf == NULL)
+				neardal_oob_iter_init(credential, data,
+						      dataLen);
+			break;
+		}
+	}
+
+	return err == NEARDAL_ERROR_NO_RECORD ? NEARDAL_SUCCESS : err;
+}
+
+errorCode_t neardal_oob_parse_wsc(const unsigned char *blob, unsigned int len,
+				  neardal_oob_wsc *wsc)
+{
+	neardal_oob_iter	credential;
+	errorCode_t		err;
+
+	if (blob == NULL || wsc == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	memset(wsc, 0, sizeof(*wsc));
+	neardal_oob_iter_init(&credential, NULL, 0);
+
+	err = neardal_oob_prv_wsc_attrs(blob, len, wsc, &credential);
+	if (err != NEARDAL_SUCCESS || credential.buf == NULL)
+		return err;
+
+	/* Credential attributes take precedence over top level ones */
+	wsc->credential = credential.buf;
+	wsc->credentialLen = credential.len;
+
+	return neardal_oob_prv_wsc_attrs(credential.buf, credential.len, wsc,
+					 NULL);
+}
@@ -0,0 +1,186 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+/*!
+ * @file neardal_oob.h
+ *
+ * @brief Defines NEARDAL handover Out Of Band data parsers (Bluetooth EIR,
+ * WiFi Simple Config)
+ *
+ ******************************************************************************/
+
+#ifndef NEARDAL_OOB_H
+#define NEARDAL_OOB_H
+
+#include "neardal_errors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/*! @brief NEARDAL OOB parsers
+ * @addtogroup NEARDAL_OOB OOB
+ * @{
+*/
+
+/*! @brief Bluetooth EIR data types */
+#define NEARDAL_EIR_UUID16_SOME		0x02
+#define NEARDAL_EIR_UUID16_ALL		0x03
+#define NEARDAL_EIR_UUID32_SOME		0x04
+#define NEARDAL_EIR_UUID32_ALL		0x05
+#define NEARDAL_EIR_UUID128_SOME	0x06
+#define NEARDAL_EIR_UUID128_ALL		0x07
+#define NEARDAL_EIR_NAME_SHORT		0x08
+#define NEARDAL_EIR_NAME_COMPLETE	0x09
+#define NEARDAL_EIR_CLASS_OF_DEVICE	0x0D
+#define NEARDAL_EIR_SP_HASH		0x0E
+#define NEARDAL_EIR_SP_RANDOMIZER	0x0F
+
+/*! @brief WiFi Simple Config attribute types */
+#define NEARDAL_WSC_AUTH_TYPE		0x1003
+#define NEARDAL_WSC_CREDENTIAL		0x100E
+#define NEARDAL_WSC_ENCR_TYPE		0x100F
+#define NEARDAL_WSC_MAC_ADDRESS		0x1020
+#define NEARDAL_WSC_NETWORK_INDEX	0x1026
+#define NEARDAL_WSC_NETWORK_KEY		0x1027
+#define NEARDAL_WSC_SSID		0x1045
+#define NEARDAL_WSC_VENDOR_EXT		0x1049
+#define NEARDAL_WSC_VERSION		0x104A
+
+/*!
+ * @brief Bluetooth OOB data (EIR blob), all pointers point into the parsed
+ * blob. Absent fields are NULL (lengths 0).
+ **/
+typedef struct {
+/*! @brief Bluetooth device address, 6 bytes, least significant byte first */
+	const unsigned char	*address;
+/*! @brief Class of device, 3 bytes */
+	const unsigned char	*classOfDevice;
+/*! @brief Simple Pairing hash C and randomizer R, 16 bytes each */
+	const unsigned char	*hash;
+	const unsigned char	*randomizer;
+/*! @brief Local name (not NUL terminated) */
+	const unsigned char	*name;
+	unsigned int		nameLen;
+/*! @brief 1 if name is the complete local name, 0 if shortened */
+	int			nameComplete;
+/*! @brief Service class UUID lists (little endian values, 2, 4 or 16 bytes
+ * each) */
+	const unsigned char	*uuid16;
+	unsigned int		uuid16Len;
+	const unsigned char	*uuid32;
+	unsigned int		uuid32Len;
+	const unsigned char	*uuid128;
+	unsigned int		uuid128Len;
+/*! @brief EIR data structures, see @link neardal_oob_eir_next @endlink */
+	const unsigned char	*eir;
+	unsigned int		eirLen;
+} neardal_oob_eir;
+
+/*!
+ * @brief WiFi OOB data (WSC blob), all pointers point into the parsed blob.
+ * Attributes are taken from the (first) credential, or from the top level if
+ * the blob holds none. Absent fields are NULL (lengths 0).
+ **/
+typedef struct {
+/*! @brief WSC version (0 if absent) */
+	unsigned char		version;
+/*! @brief Network name (not NUL terminated, at most 32 bytes) */
+	const unsigned char	*ssid;
+	unsigned int		ssidLen;
+/*! @brief Network key (not NUL terminated, at most 64 bytes) */
+	const unsigned char	*networkKey;
+	unsigned int		networkKeyLen;
+/*! @brief Authentication and encryption types (0 if absent) */
+	unsigned short		authType;
+	unsigned short		encrType;
+/*! @brief Access point MAC address, 6 bytes */
+	const unsigned char	*macAddress;
+/*! @brief Credential attributes, see @link neardal_oob_wsc_next @endlink */
+	const unsigned char	*credential;
+	unsigned int		credentialLen;
+} neardal_oob_wsc;
+
+/*! @brief Iterator over EIR data structures or WSC attributes */
+typedef struct {
+	const unsigned char	*buf;
+	unsigned int		len;
+	unsigned int		pos;
+} neardal_oob_iter;
+
+/*! \fn errorCode_t neardal_oob_parse_eir(const unsigned char *blob,
+ * unsigned int len, neardal_oob_eir *eir)
+ * @brief Parse a Bluetooth OOB blob (OOB data length, device address, EIR
+ * data structures), nothing is copied
+ *
+ * @param blob OOB blob (e.g. "EIR" handover agent data)
+ * @param len blob length
+ * @param eir parsed fields
+ * @return errorCode_t error code (NEARDAL_ERROR_INVALID_RECORD if malformed)
+ **/
+errorCode_t neardal_oob_parse_eir(const unsigned char *blob, unsigned int len,
+				  neardal_oob_eir *eir);
+
+/*! \fn errorCode_t neardal_oob_parse_wsc(const unsigned char *blob,
+ * unsigned int len, neardal_oob_wsc *wsc)
+ * @brief Parse a WiFi Simple Config blob (16 bits type/length attributes),
+ * nothing is copied
+ *
+ * @param blob WSC blob (e.g. "WSC" handover agent data)
+ * @param len blob length
+ * @param wsc parsed fields
+ * @return errorCode_t error code (NEARDAL_ERROR_INVALID_RECORD if malformed)
+ **/
+errorCode_t neardal_oob_parse_wsc(const unsigned char *blob, unsigned int len,
+				  neardal_oob_wsc *wsc);
+
+/*! \fn void neardal_oob_iter_init(neardal_oob_iter *iter,
+ * const unsigned char *buf, unsigned int len)
+ * @brief Initialize an iterator (e.g. over eir->eir or wsc->credential)
+ **/
+void neardal_oob_iter_init(neardal_oob_iter *iter, const unsigned char *buf,
+			   unsigned int len);
+
+/*! \fn errorCode_t neardal_oob_eir_next(neardal_oob_iter *iter,
+ * unsigned char *type, const unsigned char **data, unsigned int *len)
+ * @brief Get next EIR data structure
+ *
+ * @return NEARDAL_SUCCESS, NEARDAL_ERROR_NO_RECORD at end or
+ * NEARDAL_ERROR_INVALID_RECORD if malformed
+ **/
+errorCode_t neardal_oob_eir_next(neardal_oob_iter *iter, unsigned char *type,
+				 const unsigned char **data, unsigned int *len);
+
+/*! \fn errorCode_t neardal_oob_wsc_next(neardal_oob_iter *iter,
+ * unsigned short *type, const unsigned char **data, unsigned int *len)
+ * @brief Get next WSC attribute
+ *
+ * @return NEARDAL_SUCCESS, NEARDAL_ERROR_NO_RECORD at end or
+ * NEARDAL_ERROR_INVALID_RECORD if malformed
+ **/
+errorCode_t neardal_oob_wsc_next(neardal_oob_iter *iter, unsigned short *type,
+				 const unsigned char **data, unsigned int *len);
+
+/* @}*/
+
+#ifdef __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif /* NEARDAL_OOB_H */
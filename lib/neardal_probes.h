@@ -0,0 +1,60 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * USDT static probes (provider 'neardal'), compiled in with --enable-usdt.
+ * A probe is a NOP until a tracer (bpftrace, perf, systemtap) attaches to
+ * it, but its arguments are computed anyway: keep them cheap.
+ *
+ * signal_received(member, path)	Neard signal handled, object path
+ * registry_add(type, path)		object added to the registry
+ * registry_remove(type, path)		object removed from the registry
+ * dispatch_start(kind, path)		event delivery, legacy callback first
+ * callback_entry(kind, path, id)	listener callback invoked
+ * callback_return(kind, path, id)	listener callback returned
+ * dispatch_done(kind, path, calls)	event delivered to 'calls' callbacks
+ * method_start(name)			D-Bus method call (or proxy creation)
+ * method_done(name, ns, ok)		D-Bus method call returned
+ * agent_request(method, path)		agent method called by Neard
+ *
+ * e.g. bpftrace -e 'usdt:/usr/lib/libneardal.so:neardal:method_done
+ *	{ @[str(arg0)] = hist(arg1); }'
+ */
+
+#ifndef NEARDAL_PROBES_H
+#define NEARDAL_PROBES_H
+
+#ifdef NEARDAL_USDT
+
+#include <sys/sdt.h>
+
+#define NEARDAL_PROBE1(name, a)		DTRACE_PROBE1(neardal, name, a)
+#define NEARDAL_PROBE2(name, a, b)	DTRACE_PROBE2(neardal, name, a, b)
+#define NEARDAL_PROBE3(name, a, b, c)	DTRACE_PROBE3(neardal, name, a, b, c)
+
+#else
+
+#define NEARDAL_PROBE1(name, a)		do { } while (0)
+#define NEARDAL_PROBE2(name, a, b)	do { } while (0)
+#define NEARDAL_PROBE3(name, a, b, c)	do { } while (0)
+
+#endif /* NEARDAL_USDT */
+
+#endif /* NEARDAL_PROBES_H */
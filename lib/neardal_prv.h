@@ -25,9 +25,13 @@
 
 #include "neardal_agent_mgr.h"
 #include "neardal_manager.h"
+#include "neardal_listener.h"
+#include "neardal_record_cache.h"
 #include "neardal_tools.h"
 #include "neardal_traces_prv.h"
 #include "neardal.h"
+#include "neardal_stats.h"
+#include "neardal_probes.h"
 #include "dbus-object-manager.h"
 
 
@@ -78,9 +82,18 @@ typedef struct {
 							'tag record found'*/
 } neardalCb;
 
-/* NEARDAL context */
+/* NEARDAL context (members before 'conn' survive neardal_destroy()) */
 typedef struct {
 	neardalCb	cb;			/* Neardal Callbacks */
+	GList		*listeners;		/* Client listeners
+						(NeardalListener*) */
+	guint		listenerLastId;		/* Last listener id given */
+	guint		listenerDepth;		/* Dispatch nesting level */
+	gchar		*adpScope;		/* Adapter opened with
+						neardal_open_adapter() */
+	gboolean	rcdWanted;		/* Records cached (callback or
+						query seen) ? */
+
 	GDBusConnection	*conn;			/* DBus connection */
 	OrgNeardManager	*proxy;			/* Neard Mgr dbus proxy */
 	ObjectManager	*dbus_om;
@@ -91,6 +104,17 @@ typedef struct {
 	guint		OwnerId;		/* dbus Id server side */
 						/* (for neard agent Mgnt) */
 	GDBusObjectManagerServer *agentMgr;	/* Object 'agent' Manager */
+	GList		*ndefAgentList;		/* Registered NDEF agents
+						(neardal_ndef_agent_t*) */
+	GList		*handoverAgentList;	/* Registered handover agents
+						(neardal_handover_agent_t*) */
+	guint		scopeSigIds[4];		/* Adapter scoped signals */
+	guint		neardWatchId;		/* Neard name watcher */
+	guint		filterId;		/* Signals arrival filter */
+	gboolean	neardSynced;		/* Registry in sync with Neard
+						objects ? */
+	gboolean	replay;			/* Registry fed by
+						neardal_replay_file() ? */
 
 	errorCode_t	ec;		/* Lastest NEARDAL error */
 	GError		*gerror;	/* Lastest GError if available */
@@ -98,7 +122,7 @@ typedef struct {
 
 extern neardalCtx neardalMgr;
 
-/* DBUS TYPE */
+/* DBUS TYPE, NEARDAL_BUS=session to override */
 #define NEARDAL_DBUS_TYPE				G_BUS_TYPE_SYSTEM
 
 /* The well-known name to own */
@@ -112,4 +136,9 @@ extern neardalCtx neardalMgr;
 */
 void neardal_prv_construct(errorCode_t *ec);
 
+/* Capture of the Neard messages in progress (see neardal_capture.h) */
+extern int neardal_capture_on;
+void neardal_capture_prv_owner(const gchar *owner);
+void neardal_capture_prv_message(GDBusMessage *msg, gboolean incoming);
+
 #endif /* NEARDAL_PRV_H */
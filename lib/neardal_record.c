@@ -18,6 +18,9 @@
  *
  */
 
+#define NEARDAL_LOG_CATEGORY	NEARDAL_LOG_CAT_RECORD
+
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,67 +30,282 @@
 #include "neardal.h"
 #include "neardal_prv.h"
 
+/*
+ * Properties unknown to neardal (a{sv}) of the records it decoded, kept out
+ * of the public structure: record -> GVariant
+ */
+static GHashTable	*rcdExtras;
+G_LOCK_DEFINE_STATIC(rcdExtras);
+
+static GVariant *neardal_record_prv_get_extras(const neardal_record *r)
+{
+	GVariant *extras = NULL;
+
+	G_LOCK(rcdExtras);
+	if (rcdExtras != NULL)
+		extras = g_hash_table_lookup(rcdExtras, r);
+	if (extras != NULL)
+		g_variant_ref(extras);
+	G_UNLOCK(rcdExtras);
+
+	return extras;
+}
+
 void neardal_record_free(neardal_record *r)
 {
 	g_return_if_fail(r);
+	G_LOCK(rcdExtras);
+	if (rcdExtras != NULL)
+		g_hash_table_remove(rcdExtras, r);
+	G_UNLOCK(rcdExtras);
 	neardal_g_strfreev((void **) r, &r->uriObjSize);
-	memset(r, 0, sizeof(*r));
 }
 
 void neardal_free_record(neardal_record *record) \
 	__attribute__ ((alias("neardal_record_free")));
 
+/* Record properties beyond the neardal_record_field string fields */
+enum {
+	NEARDAL_RECORD_SIZE = NEARDAL_RECORD_FIELD_COUNT,
+	/* neardal registry entry, not a record property */
+	NEARDAL_RECORD_NEARDAL_TYPE,
+	NEARDAL_RECORD_UNKNOWN
+};
+
+/* String fields of neardal_record, in structure order, with their D-Bus key */
+static const struct {
+	const char	*key;
+	size_t		offset;
+} neardal_record_fields[] = {
+	[NEARDAL_RECORD_FIELD_ACTION] =
+		{ "Action",		offsetof(neardal_record, action) },
+	[NEARDAL_RECORD_FIELD_CARRIER] =
+		{ "Carrier",		offsetof(neardal_record, carrier) },
+	[NEARDAL_RECORD_FIELD_ENCODING] =
+		{ "Encoding",		offsetof(neardal_record, encoding) },
+	[NEARDAL_RECORD_FIELD_LANGUAGE] =
+		{ "Language",		offsetof(neardal_record, language) },
+	[NEARDAL_RECORD_FIELD_MIME] =
+		{ "MIME",		offsetof(neardal_record, mime) },
+	[NEARDAL_RECORD_FIELD_NAME] =
+		{ "Name",		offsetof(neardal_record, name) },
+	[NEARDAL_RECORD_FIELD_REPRESENTATION] =
+		{ "Representation",	offsetof(neardal_record,
+							representation) },
+	[NEARDAL_RECORD_FIELD_TYPE] =
+		{ "Type",		offsetof(neardal_record, type) },
+	[NEARDAL_RECORD_FIELD_SSID] =
+		{ "SSID",		offsetof(neardal_record, ssid) },
+	[NEARDAL_RECORD_FIELD_PASSPHRASE] =
+		{ "Passphrase",		offsetof(neardal_record, passphrase) },
+	[NEARDAL_RECORD_FIELD_ENCRYPTION] =
+		{ "Encryption",		offsetof(neardal_record, encryption) },
+	[NEARDAL_RECORD_FIELD_AUTHENTICATION] =
+		{ "Authentication",	offsetof(neardal_record,
+							authentication) },
+	[NEARDAL_RECORD_FIELD_URI] =
+		{ "URI",		offsetof(neardal_record, uri) },
+};
+
+/* Dictionary keys, built once (last one is "Size") and never freed */
+static GVariant *neardal_record_keys[NEARDAL_RECORD_FIELD_COUNT + 1];
+
+static void neardal_record_prv_init_keys(void)
+{
+	static gsize	init;
+	gsize		i;
+
+	if (g_once_init_enter(&init)) {
+		for (i = 0; i < NEARDAL_RECORD_FIELD_COUNT; i++)
+			neardal_record_keys[i] = g_variant_ref_sink(
+				g_variant_new_string(
+					neardal_record_fields[i].key));
+		neardal_record_keys[i] = g_variant_ref_sink(
+					g_variant_new_string("Size"));
+		g_once_init_leave(&init, 1);
+	}
+}
+
+/*****************************************************************************
+ * neardal_record_to_g_variant: Build the a{sv} dictionary of a record (Write,
+ * Push). Entries are built from typed values and precomputed keys, no
+ * GVariant text format is parsed.
+ ****************************************************************************/
 GVariant *neardal_record_to_g_variant(neardal_record *in)
 {
-	GVariantBuilder b;
-	GVariant *out;
+	GVariant	*entries[NEARDAL_RECORD_FIELD_COUNT + 1];
+	GVariantBuilder	b;
+	GVariantIter	iter;
+	GVariant	*v, *extras;
+	const char	*value;
+	gsize		i, n = 0;
 
-	g_variant_builder_init(&b, G_VARIANT_TYPE_ARRAY);
+	neardal_record_prv_init_keys();
 
-	NEARDAL_G_VARIANT_IN(&b, "{'Action', <%s>}", in->action);
-	NEARDAL_G_VARIANT_IN(&b, "{'Carrier', <%s>}", in->carrier);
-	NEARDAL_G_VARIANT_IN(&b, "{'Encoding', <%s>}", in->encoding);
-	NEARDAL_G_VARIANT_IN(&b, "{'Language', <%s>}", in->language);
-	NEARDAL_G_VARIANT_IN(&b, "{'MIME', <%s>}", in->mime);
-	NEARDAL_G_VARIANT_IN(&b, "{'Name', <%s>}", in->name);
-	NEARDAL_G_VARIANT_IN(&b, "{'Representation', <%s>}",
-				in->representation);
-	NEARDAL_G_VARIANT_IN(&b, "{'Size', <%u>}", in->uriObjSize);
-	NEARDAL_G_VARIANT_IN(&b, "{'Type', <%s>}", in->type);
+	for (i = 0; i < NEARDAL_RECORD_FIELD_COUNT; i++) {
+		value = G_STRUCT_MEMBER(const char *, in,
+					neardal_record_fields[i].offset);
+		if (value == NULL)
+			continue;
+		entries[n++] = g_variant_new_dict_entry(neardal_record_keys[i],
+				g_variant_new_variant(
+					g_variant_new_string(value)));
+	}
+	if (in->uriObjSize)
+		entries[n++] = g_variant_new_dict_entry(neardal_record_keys[i],
+				g_variant_new_variant(
+					g_variant_new_uint32(in->uriObjSize)));
 
-	NEARDAL_G_VARIANT_IN(&b, "{'SSID', <%s>}", in->ssid);
-	NEARDAL_G_VARIANT_IN(&b, "{'Passphrase', <%s>}", in->passphrase);
-	NEARDAL_G_VARIANT_IN(&b, "{'Authentication', <%s>}",
-			     in->authentication);
-	NEARDAL_G_VARIANT_IN(&b, "{'Encryption', <%s>}", in->encryption);
+	extras = neardal_record_prv_get_extras(in);
+	if (extras == NULL)
+		return g_variant_new_array(G_VARIANT_TYPE("{sv}"), entries, n);
 
-	NEARDAL_G_VARIANT_IN(&b, "{'URI', <%s>}", in->uri);
+	/* Unknown properties read with the record go back untouched */
+	g_variant_builder_init(&b, G_VARIANT_TYPE_VARDICT);
+	for (i = 0; i < n; i++)
+		g_variant_builder_add_value(&b, entries[i]);
+	g_variant_iter_init(&iter, extras);
+	while ((v = g_variant_iter_next_value(&iter)) != NULL) {
+		g_variant_builder_add_value(&b, v);
+		g_variant_unref(v);
+	}
+	g_variant_unref(extras);
 
-	out = g_variant_builder_end(&b);
+	return g_variant_builder_end(&b);
+}
 
-	return out;
+/*****************************************************************************
+ * neardal_record_prv_key: Map a dictionary key to a record property, with a
+ * switch on the key length and first characters (no string hashing). The
+ * candidate is then confirmed by one comparison.
+ ****************************************************************************/
+static int neardal_record_prv_key(const char *key)
+{
+	int id = NEARDAL_RECORD_UNKNOWN;
+
+	switch (strlen(key)) {
+	case 3:
+		if (key[0] == 'U')
+			id = NEARDAL_RECORD_FIELD_URI;
+		break;
+	case 4:
+		switch (key[0]) {
+		case 'M':
+			id = NEARDAL_RECORD_FIELD_MIME;
+			break;
+		case 'N':
+			id = NEARDAL_RECORD_FIELD_NAME;
+			break;
+		case 'T':
+			id = NEARDAL_RECORD_FIELD_TYPE;
+			break;
+		case 'S':
+			if (key[1] == 'S')
+				id = NEARDAL_RECORD_FIELD_SSID;
+			else if (!strcmp(key, "Size"))
+				return NEARDAL_RECORD_SIZE;
+			break;
+		}
+		break;
+	case 6:
+		if (key[0] == 'A')
+			id = NEARDAL_RECORD_FIELD_ACTION;
+		break;
+	case 7:
+		if (key[0] == 'C')
+			id = NEARDAL_RECORD_FIELD_CARRIER;
+		break;
+	case 8:
+		if (key[0] == 'E')
+			id = NEARDAL_RECORD_FIELD_ENCODING;
+		else if (key[0] == 'L')
+			id = NEARDAL_RECORD_FIELD_LANGUAGE;
+		break;
+	case 10:
+		if (key[0] == 'P')
+			id = NEARDAL_RECORD_FIELD_PASSPHRASE;
+		else if (key[0] == 'E')
+			id = NEARDAL_RECORD_FIELD_ENCRYPTION;
+		break;
+	case 11:
+		if (!strcmp(key, "NeardalType"))
+			return NEARDAL_RECORD_NEARDAL_TYPE;
+		break;
+	case 14:
+		if (key[0] == 'R')
+			id = NEARDAL_RECORD_FIELD_REPRESENTATION;
+		else if (key[0] == 'A')
+			id = NEARDAL_RECORD_FIELD_AUTHENTICATION;
+		break;
+	}
+
+	if (id != NEARDAL_RECORD_UNKNOWN &&
+			strcmp(key, neardal_record_fields[id].key))
+		id = NEARDAL_RECORD_UNKNOWN;
+
+	return id;
 }
 
-neardal_record *neardal_g_variant_to_record(GVariant *in)
+/*****************************************************************************
+ * neardal_record_prv_decode: Decode a record dictionary in one pass over its
+ * entries into a zeroed record. Entries neardal does not know about are kept
+ * aside (see rcdExtras) until the record is freed.
+ ****************************************************************************/
+void neardal_record_prv_decode(GVariant *in, neardal_record *out)
 {
-	neardal_record *out = g_new0(neardal_record, 1);
+	GVariantBuilder	extras;
+	gboolean	hasExtras = FALSE;
+	GVariantIter	iter;
+	const char	*key;
+	GVariant	*value;
+	char		**field;
+	int		id;
 
-	NEARDAL_G_VARIANT_OUT(in, "Action", "s", &out->action);
-	NEARDAL_G_VARIANT_OUT(in, "Carrier", "s", &out->carrier);
-	NEARDAL_G_VARIANT_OUT(in, "Encoding", "s", &out->encoding);
-	NEARDAL_G_VARIANT_OUT(in, "Language", "s", &out->language);
-	NEARDAL_G_VARIANT_OUT(in, "MIME", "s", &out->mime);
-	NEARDAL_G_VARIANT_OUT(in, "Name", "s", &out->name);
-	NEARDAL_G_VARIANT_OUT(in, "Representation", "s", &out->representation);
-	NEARDAL_G_VARIANT_OUT(in, "Size", "u", &out->uriObjSize);
-	NEARDAL_G_VARIANT_OUT(in, "Type", "s", &out->type);
+	g_variant_iter_init(&iter, in);
+	while (g_variant_iter_next(&iter, "{&sv}", &key, &value)) {
+		id = neardal_record_prv_key(key);
 
-	NEARDAL_G_VARIANT_OUT(in, "SSID", "s", &out->ssid);
-	NEARDAL_G_VARIANT_OUT(in, "Passphrase", "s", &out->passphrase);
-	NEARDAL_G_VARIANT_OUT(in, "Authentication", "s", &out->authentication);
-	NEARDAL_G_VARIANT_OUT(in, "Encryption", "s", &out->encryption);
+		if (id < NEARDAL_RECORD_SIZE &&
+			g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)) {
+			/* Duplicate key: the last one wins */
+			field = &G_STRUCT_MEMBER(char *, out,
+					neardal_record_fields[id].offset);
+			g_free(*field);
+			*field = g_variant_dup_string(value, NULL);
+			NEARDAL_TRACEF("%s = '%s'\n", key, *field);
+		} else if (id == NEARDAL_RECORD_SIZE &&
+			g_variant_is_of_type(value, G_VARIANT_TYPE_UINT32)) {
+			out->uriObjSize = g_variant_get_uint32(value);
+			NEARDAL_TRACEF("%s = '%u'\n", key, out->uriObjSize);
+		} else if (id != NEARDAL_RECORD_NEARDAL_TYPE) {
+			if (hasExtras == FALSE) {
+				g_variant_builder_init(&extras,
+						       G_VARIANT_TYPE_VARDICT);
+				hasExtras = TRUE;
+			}
+			g_variant_builder_add(&extras, "{sv}", key, value);
+		}
+		g_variant_unref(value);
+	}
+
+	if (hasExtras == FALSE)
+		return;
+
+	G_LOCK(rcdExtras);
+	if (rcdExtras == NULL)
+		rcdExtras = g_hash_table_new_full(g_direct_hash,
+					g_direct_equal, NULL,
+					(GDestroyNotify) g_variant_unref);
+	g_hash_table_insert(rcdExtras, out,
+			    g_variant_ref_sink(g_variant_builder_end(&extras)));
+	G_UNLOCK(rcdExtras);
+}
+
+neardal_record *neardal_g_variant_to_record(GVariant *in)
+{
+	neardal_record *out = g_new0(neardal_record, 1);
 
-	NEARDAL_G_VARIANT_OUT(in, "URI", "s", &out->uri);
+	neardal_record_prv_decode(in, out);
 
 	return out;
 }
@@ -96,16 +314,119 @@ void neardal_record_add(GVariant *record)
 {
 	NEARDAL_TRACEIN();
 
-	neardal_g_variant_dump(record);
+	if (NEARDAL_LOG_ENABLED(NEARDAL_LOG_DEBUG))
+		neardal_g_variant_dump(record);
 
-	if (neardalMgr.cb.rcd_found != NULL)
-		neardalMgr.cb.rcd_found(neardal_g_variant_get(record, "Name", "&s"),
-					neardalMgr.cb.rcd_found_ud);
+	neardal_listener_prv_notify_record(
+			neardal_g_variant_get(record, "Name", "&s"), record);
 }
 
 void neardal_record_remove(GVariant *record)
 {
 	NEARDAL_TRACEIN();
 
-	neardal_g_variant_dump(record);
+	if (NEARDAL_LOG_ENABLED(NEARDAL_LOG_DEBUG))
+		neardal_g_variant_dump(record);
+}
+
+/*****************************************************************************
+ * Compact records: a header of 16 bits offsets (0 for an unset field, from the
+ * start of the block) followed by the NUL terminated strings.
+ ****************************************************************************/
+struct neardal_compact_record {
+	guint16	size;
+	guint16	offset[NEARDAL_RECORD_FIELD_COUNT];
+	guint32	uriObjSize;
+	char	strings[];
+};
+
+neardal_compact_record *neardal_record_compact(const neardal_record *record)
+{
+	neardal_compact_record	*c;
+	const char		*value;
+	gsize			len[NEARDAL_RECORD_FIELD_COUNT];
+	gsize			i, size = sizeof(*c);
+
+	g_return_val_if_fail(record != NULL, NULL);
+
+	for (i = 0; i < NEARDAL_RECORD_FIELD_COUNT; i++) {
+		value = G_STRUCT_MEMBER(const char *, record,
+					neardal_record_fields[i].offset);
+		len[i] = value ? strlen(value) + 1 : 0;
+		size += len[i];
+	}
+	if (size > G_MAXUINT16) {
+		NEARDAL_TRACE_ERR("Record too large (%zu bytes)\n", size);
+		return NULL;
+	}
+
+	c = g_malloc(size);
+	c->size = size;
+	c->uriObjSize = record->uriObjSize;
+	size = sizeof(*c);
+	for (i = 0; i < NEARDAL_RECORD_FIELD_COUNT; i++) {
+		if (len[i] == 0) {
+			c->offset[i] = 0;
+			continue;
+		}
+		memcpy((char *) c + size, G_STRUCT_MEMBER(const char *, record,
+				neardal_record_fields[i].offset), len[i]);
+		c->offset[i] = size;
+		size += len[i];
+	}
+
+	return c;
+}
+
+neardal_record *neardal_compact_record_expand(
+				const neardal_compact_record *compact)
+{
+	neardal_record	*out;
+	gsize		i;
+
+	g_return_val_if_fail(compact != NULL, NULL);
+
+	out = g_new0(neardal_record, 1);
+	for (i = 0; i < NEARDAL_RECORD_FIELD_COUNT; i++)
+		if (compact->offset[i])
+			G_STRUCT_MEMBER(char *, out,
+					neardal_record_fields[i].offset) =
+				g_strdup((const char *) compact +
+					 compact->offset[i]);
+	out->uriObjSize = compact->uriObjSize;
+
+	return out;
+}
+
+const char *neardal_compact_record_get(const neardal_compact_record *compact,
+				       neardal_record_field field)
+{
+	g_return_val_if_fail(compact != NULL, NULL);
+	g_return_val_if_fail((unsigned) field < NEARDAL_RECORD_FIELD_COUNT,
+			     NULL);
+
+	if (compact->offset[field] == 0)
+		return NULL;
+
+	return (const char *) compact + compact->offset[field];
+}
+
+unsigned int neardal_compact_record_uri_size(
+				const neardal_compact_record *compact)
+{
+	g_return_val_if_fail(compact != NULL, 0);
+
+	return compact->uriObjSize;
+}
+
+unsigned int neardal_compact_record_size(const neardal_compact_record *compact)
+{
+	g_return_val_if_fail(compact != NULL, 0);
+
+	return compact->size;
+}
+
+void neardal_compact_record_free(neardal_compact_record *compact)
+{
+	g_free(compact);
 }
@@ -31,5 +31,6 @@ typedef struct {
 void neardal_record_add(GVariant *record);
 void neardal_record_remove(GVariant *record);
 void neardal_record_free(neardal_record *record);
+void neardal_record_prv_decode(GVariant *in, neardal_record *out);
 
 #endif /* NEARDAL_RECORD_H */
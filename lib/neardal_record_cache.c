@@ -0,0 +1,205 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define NEARDAL_LOG_CATEGORY	NEARDAL_LOG_CAT_RECORD
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include "neardal.h"
+#include "neardal_prv.h"
+
+/* FNV-1a, 64 bits */
+#define FNV_OFFSET	14695981039346656037ULL
+#define FNV_PRIME	1099511628211ULL
+
+/* Initial size of the serialized content buffer, fits common records */
+#define CONTENT_PREALLOC	512
+
+/* Decoded record shared by all the records of same content */
+typedef struct {
+	neardal_record	rcd;		/* first, handed out to the client */
+	guint64		hash;
+	guint8		*content;	/* serialized properties, Name aside */
+	gsize		contentLen;
+	guint		refs;		/* references held by the client */
+	gboolean	cached;		/* still in the cache table */
+	GList		lru;		/* link in the LRU queue */
+} RcdCacheEntry;
+
+static struct {
+	guint		size;		/* maximum entries, 0 = disabled */
+	GHashTable	*entries;	/* hash -> RcdCacheEntry */
+	GQueue		lru;		/* most recently used first */
+	guint64		hits;
+	guint64		misses;
+} rcdCache;
+
+static void neardal_record_cache_prv_free(RcdCacheEntry *entry)
+{
+	g_free(entry->content);
+	/* Releases the whole entry, the record is its first member */
+	neardal_record_free(&entry->rcd);
+}
+
+/*****************************************************************************
+ * neardal_record_cache_prv_drop: Remove an entry from the cache. It is freed
+ * now if the client holds no reference on it, on last release otherwise.
+ ****************************************************************************/
+static void neardal_record_cache_prv_drop(RcdCacheEntry *entry)
+{
+	g_hash_table_remove(rcdCache.entries, &entry->hash);
+	g_queue_unlink(&rcdCache.lru, &entry->lru);
+	entry->cached = FALSE;
+	if (entry->refs == 0)
+		neardal_record_cache_prv_free(entry);
+}
+
+/*****************************************************************************
+ * neardal_record_cache_prv_trim: Evict least recently used entries above
+ * the cache size
+ ****************************************************************************/
+static void neardal_record_cache_prv_trim(void)
+{
+	while (rcdCache.lru.length > rcdCache.size)
+		neardal_record_cache_prv_drop(rcdCache.lru.tail->data);
+}
+
+/*****************************************************************************
+ * neardal_record_cache_prv_content: Hash the serialized properties of a
+ * record, registry entries ('Name', 'NeardalType') aside: the same content
+ * read from another tag has another name. The serialized bytes are gathered
+ * in 'buf' to confirm a match.
+ ****************************************************************************/
+static guint64 neardal_record_cache_prv_content(GVariant *data,
+						GByteArray *buf)
+{
+	guint64		hash = FNV_OFFSET;
+	GVariantIter	iter;
+	GVariant	*entry, *key;
+	const guint8	*p;
+	gsize		i, len;
+
+	g_variant_iter_init(&iter, data);
+	while ((entry = g_variant_iter_next_value(&iter)) != NULL) {
+		key = g_variant_get_child_value(entry, 0);
+		if (strcmp(g_variant_get_string(key, NULL), "Name") &&
+			strcmp(g_variant_get_string(key, NULL),
+							"NeardalType")) {
+			p = g_variant_get_data(entry);
+			len = g_variant_get_size(entry);
+			for (i = 0; i < len; i++)
+				hash = (hash ^ p[i]) * FNV_PRIME;
+			g_byte_array_append(buf, p, len);
+		}
+		g_variant_unref(key);
+		g_variant_unref(entry);
+	}
+
+	return hash;
+}
+
+const neardal_record *neardal_record_cache_prv_get(GVariant *data)
+{
+	RcdCacheEntry	*entry, *cached = NULL;
+	GByteArray	*content;
+	guint64		hash;
+
+	NEARDAL_ASSERT_RET(data != NULL, NULL);
+
+	content = g_byte_array_sized_new(CONTENT_PREALLOC);
+	hash = neardal_record_cache_prv_content(data, content);
+
+	if (rcdCache.entries != NULL)
+		cached = g_hash_table_lookup(rcdCache.entries, &hash);
+	if (cached != NULL && cached->contentLen == content->len &&
+		!memcmp(cached->content, content->data, content->len)) {
+		rcdCache.hits++;
+		g_byte_array_free(content, TRUE);
+		g_queue_unlink(&rcdCache.lru, &cached->lru);
+		g_queue_push_head_link(&rcdCache.lru, &cached->lru);
+		cached->refs++;
+		return &cached->rcd;
+	}
+	rcdCache.misses++;
+
+	entry = g_new0(RcdCacheEntry, 1);
+	neardal_record_prv_decode(data, &entry->rcd);
+	/* Shared by records of any name */
+	g_free(entry->rcd.name);
+	entry->rcd.name = NULL;
+	entry->hash = hash;
+	entry->contentLen = content->len;
+	entry->content = g_byte_array_free(content, FALSE);
+	entry->lru.data = entry;
+	entry->refs = 1;
+
+	if (rcdCache.size == 0)
+		return &entry->rcd;
+
+	if (rcdCache.entries == NULL)
+		rcdCache.entries = g_hash_table_new(g_int64_hash,
+						    g_int64_equal);
+	/* Hash collision with another content: the newest wins */
+	if (cached != NULL)
+		neardal_record_cache_prv_drop(cached);
+
+	g_hash_table_insert(rcdCache.entries, &entry->hash, entry);
+	g_queue_push_head_link(&rcdCache.lru, &entry->lru);
+	entry->cached = TRUE;
+	neardal_record_cache_prv_trim();
+
+	return &entry->rcd;
+}
+
+/*****************************************************************************
+ * neardal_record_cache_set_size: Set the number of distinct record contents
+ * kept decoded. 0 disables the cache.
+ ****************************************************************************/
+errorCode_t neardal_record_cache_set_size(unsigned int size)
+{
+	rcdCache.size = size;
+	neardal_record_cache_prv_trim();
+	if (size == 0 && rcdCache.entries != NULL) {
+		g_hash_table_destroy(rcdCache.entries);
+		rcdCache.entries = NULL;
+	}
+	NEARDAL_TRACEF("Record cache size = %u (hits=%" G_GUINT64_FORMAT
+		       ", misses=%" G_GUINT64_FORMAT ")\n", size,
+		       rcdCache.hits, rcdCache.misses);
+
+	return NEARDAL_SUCCESS;
+}
+
+/*****************************************************************************
+ * neardal_release_record_shared: Release a record got with
+ * neardal_get_record_properties_shared()
+ ****************************************************************************/
+void neardal_release_record_shared(const neardal_record *record)
+{
+	RcdCacheEntry *entry = (RcdCacheEntry *) record;
+
+	g_return_if_fail(record != NULL);
+	g_return_if_fail(entry->refs > 0);
+
+	if (--entry->refs == 0 && entry->cached == FALSE)
+		neardal_record_cache_prv_free(entry);
+}
@@ -0,0 +1,31 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef NEARDAL_RECORD_CACHE_H
+#define NEARDAL_RECORD_CACHE_H
+
+/*****************************************************************************
+ * neardal_record_cache_prv_get: decoded record for the properties of a
+ * record (registry entry), shared with the records of same content. Release
+ * with neardal_release_record_shared().
+ ****************************************************************************/
+const neardal_record *neardal_record_cache_prv_get(GVariant *data);
+
+#endif /* NEARDAL_RECORD_CACHE_H */
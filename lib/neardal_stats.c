@@ -0,0 +1,474 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <glib.h>
+
+#include "neardal.h"
+#include "neardal_prv.h"
+
+#define HIST_SUB		(1U << NEARDAL_HIST_SUB_BITS)
+
+/* Method statistics are only made of counters */
+#define NB_METHOD_COUNTERS	(NEARDAL_METHOD_COUNT * \
+				 sizeof(neardal_method_stats) / sizeof(guint64))
+
+/* Event latency histograms are only made of counters too */
+#define NB_LATENCY_COUNTERS	(NEARDAL_EVENT_COUNT * \
+				 sizeof(neardal_histogram) / sizeof(guint64))
+
+/* Adapter path length handled without allocation */
+#define ADP_PATH_LEN		64
+
+/* Signals received and not handled yet, the oldest are dropped beyond */
+#define ARRIVALS_MAX		256
+
+static const char * const neardal_method_names[NEARDAL_METHOD_COUNT] = {
+	[NEARDAL_METHOD_START_POLL_LOOP]		= "StartPollLoop",
+	[NEARDAL_METHOD_STOP_POLL_LOOP]			= "StopPollLoop",
+	[NEARDAL_METHOD_SET_PROPERTY]			= "Set",
+	[NEARDAL_METHOD_TAG_WRITE]			= "Write",
+	[NEARDAL_METHOD_DEV_PUSH]			= "Push",
+	[NEARDAL_METHOD_GET_MANAGED_OBJECTS]		= "GetManagedObjects",
+	[NEARDAL_METHOD_REGISTER_NDEF_AGENT]		= "RegisterNDEFAgent",
+	[NEARDAL_METHOD_UNREGISTER_NDEF_AGENT]		= "UnregisterNDEFAgent",
+	[NEARDAL_METHOD_REGISTER_HANDOVER_AGENT]	=
+						"RegisterHandoverAgent",
+	[NEARDAL_METHOD_UNREGISTER_HANDOVER_AGENT]	=
+						"UnregisterHandoverAgent",
+	[NEARDAL_METHOD_NEW_PROXY]			= "NewProxy"
+};
+
+/*
+ * Counters are updated with relaxed atomics, only the adapters table (one
+ * entry per adapter, events by kind) is under lock
+ */
+static neardal_method_stats	methods[NEARDAL_METHOD_COUNT];
+static guint64			messages[NEARDAL_MSG_COUNT];
+static guint64			events[NEARDAL_EVENT_COUNT];
+static guint64			callbacks[NEARDAL_EVENT_COUNT];
+static neardal_histogram	eventLatency[NEARDAL_EVENT_COUNT];
+static GHashTable		*adapters;
+G_LOCK_DEFINE_STATIC(adapters);
+
+/*
+ * Arrival times of the Neard signals, filled by the GDBus worker thread and
+ * consumed in order by the handlers (main context). Member and path are
+ * kept as string hashes: object paths are not bounded, quarks would leak.
+ */
+typedef struct {
+	guint64	ts;
+	guint	member;
+	guint	path;
+} MsgArrival;
+
+static MsgArrival		arrivals[ARRIVALS_MAX];
+static guint			arrivalsHead;	/* Oldest */
+static guint			arrivalsLen;
+G_LOCK_DEFINE_STATIC(arrivals);
+
+/* Main context only: signal being handled, event being delivered */
+static guint64			msgReceived;
+static neardal_event_info	*curEventInfo;
+
+guint64 neardal_stats_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (guint64) ts.tv_sec * G_GUINT64_CONSTANT(1000000000) +
+	       ts.tv_nsec;
+}
+
+/*****************************************************************************
+ * neardal_stats_prv_bucket: histogram bucket of a value
+ ****************************************************************************/
+static unsigned int neardal_stats_prv_bucket(guint64 v)
+{
+	unsigned int e, b;
+
+	if (v < HIST_SUB)
+		return v;
+	e = 63 - __builtin_clzll(v);
+	b = ((e - NEARDAL_HIST_SUB_BITS + 1) << NEARDAL_HIST_SUB_BITS) +
+	    ((v >> (e - NEARDAL_HIST_SUB_BITS)) & (HIST_SUB - 1));
+
+	return MIN(b, NEARDAL_HIST_BUCKETS - 1);
+}
+
+/*****************************************************************************
+ * neardal_stats_prv_bucket_low: smallest value of a histogram bucket
+ ****************************************************************************/
+static guint64 neardal_stats_prv_bucket_low(unsigned int b)
+{
+	unsigned int e;
+
+	if (b < HIST_SUB)
+		return b;
+	e = (b >> NEARDAL_HIST_SUB_BITS) + NEARDAL_HIST_SUB_BITS - 1;
+
+	return (guint64) (HIST_SUB + (b & (HIST_SUB - 1))) <<
+	       (e - NEARDAL_HIST_SUB_BITS);
+}
+
+/*****************************************************************************
+ * neardal_stats_prv_hist_add: add a value to a histogram
+ ****************************************************************************/
+static void neardal_stats_prv_hist_add(neardal_histogram *hist, guint64 v)
+{
+	guint64 cur;
+
+	__atomic_fetch_add(&hist->buckets[neardal_stats_prv_bucket(v)], 1,
+			   __ATOMIC_RELAXED);
+	__atomic_fetch_add(&hist->sum, v, __ATOMIC_RELAXED);
+
+	cur = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+	while (v > cur && !__atomic_compare_exchange_n(&hist->max, &cur, v,
+			TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+	/* min is 0 until the first value */
+	cur = __atomic_load_n(&hist->min, __ATOMIC_RELAXED);
+	while ((cur == 0 || v < cur) && !__atomic_compare_exchange_n(
+			&hist->min, &cur, v ? v : 1, TRUE, __ATOMIC_RELAXED,
+			__ATOMIC_RELAXED))
+		;
+
+	__atomic_fetch_add(&hist->count, 1, __ATOMIC_RELAXED);
+}
+
+/*****************************************************************************
+ * neardal_stats_prv_copy: copy counters with atomic loads
+ ****************************************************************************/
+static void neardal_stats_prv_copy(guint64 *dst, const guint64 *src,
+				   gsize n)
+{
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+}
+
+/*****************************************************************************
+ * neardal_stats_prv_clear: reset counters with atomic stores
+ ****************************************************************************/
+static void neardal_stats_prv_clear(guint64 *counters, gsize n)
+{
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		__atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+}
+
+guint64 neardal_stats_call_begin(neardal_method method)
+{
+	NEARDAL_PROBE1(method_start, neardal_method_name(method));
+
+	return neardal_stats_now();
+}
+
+void neardal_stats_call(neardal_method method, guint64 start, gboolean ok)
+{
+	guint64 now = neardal_stats_now();
+	guint64 ns = now > start ? now - start : 0;
+
+	NEARDAL_PROBE3(method_done, neardal_method_name(method), ns, ok);
+	if ((unsigned) method >= NEARDAL_METHOD_COUNT)
+		return;
+
+	neardal_stats_prv_hist_add(&methods[method].latency, ns);
+	if (!ok)
+		__atomic_fetch_add(&methods[method].errors, 1,
+				   __ATOMIC_RELAXED);
+}
+
+void neardal_stats_msg(neardal_msg msg)
+{
+	if ((unsigned) msg < NEARDAL_MSG_COUNT)
+		__atomic_fetch_add(&messages[msg], 1, __ATOMIC_RELAXED);
+}
+
+/*****************************************************************************
+ * neardal_stats_prv_neard_signal: is it a signal neardal handles ?
+ ****************************************************************************/
+static gboolean neardal_stats_prv_neard_signal(GDBusMessage *msg)
+{
+	const gchar *iface;
+
+	if (g_dbus_message_get_message_type(msg) != G_DBUS_MESSAGE_TYPE_SIGNAL)
+		return FALSE;
+	iface = g_dbus_message_get_interface(msg);
+	if (iface == NULL || g_dbus_message_get_path(msg) == NULL ||
+	    g_dbus_message_get_member(msg) == NULL)
+		return FALSE;
+
+	return g_str_has_prefix(iface, "org.neard.") ||
+	       !strcmp(iface, "org.freedesktop.DBus.Properties") ||
+	       !strcmp(iface, "org.freedesktop.DBus.ObjectManager");
+}
+
+GDBusMessage *neardal_stats_filter(GDBusConnection *conn, GDBusMessage *msg,
+				   gboolean incoming, gpointer user_data)
+{
+	MsgArrival	*a;
+	guint64		now;
+
+	(void) conn; /* remove warning */
+	(void) user_data; /* remove warning */
+
+	if (__builtin_expect(neardal_capture_on, 0))
+		neardal_capture_prv_message(msg, incoming);
+	if (incoming == FALSE)
+		return msg;
+	if (!neardal_stats_prv_neard_signal(msg))
+		return msg;
+	now = neardal_stats_now();
+
+	G_LOCK(arrivals);
+	if (arrivalsLen == ARRIVALS_MAX) {
+		arrivalsHead = (arrivalsHead + 1) % ARRIVALS_MAX;
+		arrivalsLen--;
+	}
+	a = &arrivals[(arrivalsHead + arrivalsLen++) % ARRIVALS_MAX];
+	a->ts		= now;
+	a->member	= g_str_hash(g_dbus_message_get_member(msg));
+	a->path		= g_str_hash(g_dbus_message_get_path(msg));
+	G_UNLOCK(arrivals);
+
+	return msg;
+}
+
+void neardal_stats_msg_begin(const gchar *member, const gchar *path)
+{
+	guint		memberHash = g_str_hash(member);
+	guint		pathHash = g_str_hash(path);
+	MsgArrival	*a;
+
+	msgReceived = 0;
+
+	/*
+	 * Signals are handled in their arrival order: the ones queued before
+	 * this signal were handled already or are ignored, drop them.
+	 */
+	G_LOCK(arrivals);
+	while (arrivalsLen > 0) {
+		a = &arrivals[arrivalsHead];
+		arrivalsHead = (arrivalsHead + 1) % ARRIVALS_MAX;
+		arrivalsLen--;
+		if (a->member == memberHash && a->path == pathHash) {
+			msgReceived = a->ts;
+			break;
+		}
+	}
+	G_UNLOCK(arrivals);
+}
+
+void neardal_stats_msg_end(void)
+{
+	msgReceived = 0;
+}
+
+guint64 neardal_stats_msg_received(void)
+{
+	return msgReceived;
+}
+
+/*****************************************************************************
+ * neardal_stats_prv_adapter: quark of the adapter of an object
+ ****************************************************************************/
+static GQuark neardal_stats_prv_adapter(const gchar *path)
+{
+	char		buf[ADP_PATH_LEN];
+	gsize		len = neardal_tools_prv_adapter_len(path);
+	gchar		*tmp;
+	GQuark		quark;
+
+	if (path[len] == '\0')
+		return g_quark_from_string(path);
+
+	if (len < sizeof(buf)) {
+		memcpy(buf, path, len);
+		buf[len] = '\0';
+		return g_quark_from_string(buf);
+	}
+	tmp = g_strndup(path, len);
+	quark = g_quark_from_string(tmp);
+	g_free(tmp);
+
+	return quark;
+}
+
+neardal_event_info *neardal_stats_event_begin(neardal_event_info *info,
+					      neardal_event kind)
+{
+	neardal_event_info *prev = curEventInfo;
+
+	info->kind		= kind;
+	info->received		= msgReceived;
+	info->dispatched	= neardal_stats_now();
+	curEventInfo		= info;
+
+	return prev;
+}
+
+void neardal_stats_event_end(const neardal_event_info *info,
+			     neardal_event_info *prev, const gchar *path,
+			     guint nbCallbacks)
+{
+	neardal_event	kind = info->kind;
+	guint64		*counts;
+	GQuark		adp;
+
+	curEventInfo = prev;
+	if ((unsigned) kind >= NEARDAL_EVENT_COUNT)
+		return;
+
+	__atomic_fetch_add(&events[kind], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&callbacks[kind], nbCallbacks, __ATOMIC_RELAXED);
+	if (info->received != 0 && info->dispatched >= info->received)
+		neardal_stats_prv_hist_add(&eventLatency[kind],
+					   info->dispatched - info->received);
+
+	if (path == NULL)
+		return;
+	adp = neardal_stats_prv_adapter(path);
+
+	G_LOCK(adapters);
+	if (adapters == NULL)
+		adapters = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+	counts = g_hash_table_lookup(adapters, GUINT_TO_POINTER(adp));
+	if (counts == NULL) {
+		counts = g_new0(guint64, NEARDAL_EVENT_COUNT);
+		g_hash_table_insert(adapters, GUINT_TO_POINTER(adp), counts);
+	}
+	counts[kind]++;
+	G_UNLOCK(adapters);
+}
+
+const neardal_event_info *neardal_current_event_info(void)
+{
+	return curEventInfo;
+}
+
+errorCode_t neardal_get_stats(neardal_stats **stats)
+{
+	neardal_stats	*s;
+	GHashTableIter	iter;
+	gpointer	key, value;
+	unsigned int	i = 0;
+
+	NEARDAL_ASSERT_RET(stats != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
+
+	s = g_try_malloc0(sizeof(*s));
+	if (s == NULL)
+		return NEARDAL_ERROR_NO_MEMORY;
+
+	neardal_stats_prv_copy((guint64 *) s->methods, (guint64 *) methods,
+			       NB_METHOD_COUNTERS);
+	neardal_stats_prv_copy(s->messages, messages, NEARDAL_MSG_COUNT);
+	neardal_stats_prv_copy(s->events, events, NEARDAL_EVENT_COUNT);
+	neardal_stats_prv_copy(s->callbacks, callbacks, NEARDAL_EVENT_COUNT);
+	neardal_stats_prv_copy((guint64 *) s->eventLatency,
+			       (guint64 *) eventLatency, NB_LATENCY_COUNTERS);
+
+	G_LOCK(adapters);
+	if (adapters != NULL && g_hash_table_size(adapters) > 0) {
+		s->adapters = g_new0(neardal_adapter_stats,
+				     g_hash_table_size(adapters));
+		g_hash_table_iter_init(&iter, adapters);
+		while (g_hash_table_iter_next(&iter, &key, &value)) {
+			s->adapters[i].name = g_strdup(g_quark_to_string(
+						GPOINTER_TO_UINT(key)));
+			memcpy(s->adapters[i].events, value,
+			       sizeof(s->adapters[i].events));
+			i++;
+		}
+		s->nbAdapters = i;
+	}
+	G_UNLOCK(adapters);
+
+	*stats = s;
+	return NEARDAL_SUCCESS;
+}
+
+void neardal_free_stats(neardal_stats *stats)
+{
+	unsigned int i;
+
+	if (stats == NULL)
+		return;
+
+	for (i = 0; i < stats->nbAdapters; i++)
+		g_free(stats->adapters[i].name);
+	g_free(stats->adapters);
+	g_free(stats);
+}
+
+void neardal_reset_stats(void)
+{
+	neardal_stats_prv_clear((guint64 *) methods,
+				NB_METHOD_COUNTERS);
+	neardal_stats_prv_clear(messages, NEARDAL_MSG_COUNT);
+	neardal_stats_prv_clear(events, NEARDAL_EVENT_COUNT);
+	neardal_stats_prv_clear(callbacks, NEARDAL_EVENT_COUNT);
+	neardal_stats_prv_clear((guint64 *) eventLatency, NB_LATENCY_COUNTERS);
+
+	G_LOCK(adapters);
+	if (adapters != NULL)
+		g_hash_table_remove_all(adapters);
+	G_UNLOCK(adapters);
+}
+
+uint64_t neardal_histogram_percentile(const neardal_histogram *hist,
+				      double percentile)
+{
+	guint64		rank, seen = 0, low, high;
+	unsigned int	b;
+
+	if (hist == NULL || hist->count == 0)
+		return 0;
+
+	percentile = CLAMP(percentile, 0, 100);
+	rank = (guint64) (percentile / 100 * hist->count + 0.5);
+	if (rank == 0)
+		return hist->min;
+
+	for (b = 0; b < NEARDAL_HIST_BUCKETS - 1; b++) {
+		seen += hist->buckets[b];
+		if (seen >= rank)
+			break;
+	}
+	/* Middle of the bucket, within the values seen */
+	low = neardal_stats_prv_bucket_low(b);
+	high = b < NEARDAL_HIST_BUCKETS - 1 ?
+	       neardal_stats_prv_bucket_low(b + 1) - 1 : hist->max;
+
+	return CLAMP(low + (high - low) / 2, hist->min, hist->max);
+}
+
+const char *neardal_method_name(neardal_method method)
+{
+	if ((unsigned) method >= NEARDAL_METHOD_COUNT)
+		return "Unknown";
+	return neardal_method_names[method];
+}
@@ -0,0 +1,84 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef NEARDAL_STATS_H
+#define NEARDAL_STATS_H
+
+/*****************************************************************************
+ * neardal_stats_now: CLOCK_MONOTONIC time (ns)
+ ****************************************************************************/
+guint64 neardal_stats_now(void);
+
+/*****************************************************************************
+ * neardal_stats_call_begin: a D-Bus method call starts, return its start time
+ ****************************************************************************/
+guint64 neardal_stats_call_begin(neardal_method method);
+
+/*****************************************************************************
+ * neardal_stats_call: account a D-Bus method call started at 'start'
+ ****************************************************************************/
+void neardal_stats_call(neardal_method method, guint64 start, gboolean ok);
+
+/*****************************************************************************
+ * neardal_stats_msg: account a D-Bus message received from Neard
+ ****************************************************************************/
+void neardal_stats_msg(neardal_msg msg);
+
+/*****************************************************************************
+ * neardal_stats_filter: D-Bus connection filter, time stamps Neard signals
+ * on arrival (runs in the GDBus worker thread)
+ ****************************************************************************/
+GDBusMessage *neardal_stats_filter(GDBusConnection *conn, GDBusMessage *msg,
+				   gboolean incoming, gpointer user_data);
+
+/*****************************************************************************
+ * neardal_stats_msg_begin: take the arrival time of the signal 'member' of
+ * object 'path' being handled, until neardal_stats_msg_end()
+ ****************************************************************************/
+void neardal_stats_msg_begin(const gchar *member, const gchar *path);
+
+/*****************************************************************************
+ * neardal_stats_msg_end: the signal taken by neardal_stats_msg_begin() is
+ * handled
+ ****************************************************************************/
+void neardal_stats_msg_end(void);
+
+/*****************************************************************************
+ * neardal_stats_msg_received: arrival time of the signal being handled, 0 if
+ * none or unknown
+ ****************************************************************************/
+guint64 neardal_stats_msg_received(void);
+
+/*****************************************************************************
+ * neardal_stats_event_begin: an event is about to be delivered to client
+ * callbacks, make 'info' the current event info. Return the previous one.
+ ****************************************************************************/
+neardal_event_info *neardal_stats_event_begin(neardal_event_info *info,
+					      neardal_event kind);
+
+/*****************************************************************************
+ * neardal_stats_event_end: account an event of object 'path' and the client
+ * callbacks it was delivered to, 'prev' becomes the current event info again
+ ****************************************************************************/
+void neardal_stats_event_end(const neardal_event_info *info,
+			     neardal_event_info *prev, const gchar *path,
+			     guint callbacks);
+
+#endif /* NEARDAL_STATS_H */
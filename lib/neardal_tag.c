@@ -18,6 +18,8 @@
  *
  */
 
+#define NEARDAL_LOG_CATEGORY	NEARDAL_LOG_CAT_TAG
+
 #include <stdio.h>
 #include <string.h>
 #include <glib.h>
@@ -49,8 +51,10 @@ static void neardal_tag_prv_cb_property_changed(OrgNeardTag *proxy,
 		return;
 
 	NEARDAL_TRACEF("str0='%s'\n", arg_unnamed_arg0);
+	NEARDAL_PROBE2(signal_received, "PropertyChanged", tagProp->name);
+	neardal_stats_msg(NEARDAL_MSG_PROPERTY_CHANGED);
 	NEARDAL_TRACEF("arg_unnamed_arg1=%s (%s)\n",
-		       g_variant_print (arg_unnamed_arg1, TRUE),
+		       neardal_trace_variant(arg_unnamed_arg1),
 		       g_variant_get_type_string(arg_unnamed_arg1));
 
 
@@ -74,8 +78,6 @@ static errorCode_t neardal_tag_prv_read_properties(TagProp *tagProp)
 
 	NEARDAL_TRACEIN();
 	NEARDAL_ASSERT_RET(tagProp != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
-	NEARDAL_ASSERT_RET(tagProp->proxy != NULL
-			  , NEARDAL_ERROR_GENERAL_ERROR);
 
 	tmp = g_datalist_get_data(&(neardalMgr.dbus_data), tagProp->name);
 	if (tmp == NULL) {
@@ -83,7 +85,7 @@ static errorCode_t neardal_tag_prv_read_properties(TagProp *tagProp)
 		NEARDAL_TRACE_ERR("Unable to read tag's properties\n");
 		goto exit;
 	}
-	NEARDAL_TRACEF("Reading:\n%s\n", g_variant_print(tmp, TRUE));
+	NEARDAL_TRACEF("Reading:\n%s\n", neardal_trace_variant(tmp));
 
 	tmpOut = g_variant_lookup_value(tmp, "TagType", G_VARIANT_TYPE_ARRAY);
 	if (tmpOut != NULL) {
@@ -109,46 +111,55 @@ exit:
 }
 
 /*****************************************************************************
- * neardal_tag_init: Get Neard Manager Properties = NFC Tags list.
- * Create a DBus proxy for the first one NFC tag if present
- * Register Neard Manager signals ('PropertyChanged')
+ * neardal_tag_prv_get_proxy: Create the DBus proxy of a NFC tag on first use
+ * (only needed to call Neard tag methods)
  ****************************************************************************/
-static errorCode_t neardal_tag_prv_init(TagProp *tagProp)
+static OrgNeardTag *neardal_tag_prv_get_proxy(TagProp *tagProp)
 {
-	errorCode_t	err = NEARDAL_SUCCESS;
+	guint64 start;
 
-	NEARDAL_TRACEIN();
-	NEARDAL_ASSERT_RET(tagProp != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
+	NEARDAL_ASSERT_RET(tagProp != NULL, NULL);
 
-	if (tagProp->proxy != NULL) {
-		g_signal_handlers_disconnect_by_func(tagProp->proxy,
-			NEARDAL_G_CALLBACK(neardal_tag_prv_cb_property_changed),
-						     NULL);
-		g_object_unref(tagProp->proxy);
-		tagProp->proxy = NULL;
-	}
+	if (tagProp->proxy != NULL)
+		return tagProp->proxy;
 
+	/* Replayed capture: no Neard to call */
+	if (neardalMgr.conn == NULL)
+		return NULL;
+
+	start = neardal_stats_call_begin(NEARDAL_METHOD_NEW_PROXY);
 	tagProp->proxy = org_neard_tag_proxy_new_sync(neardalMgr.conn,
-					G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+					G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
 							NEARD_DBUS_SERVICE,
 							tagProp->name,
 							NULL, /* GCancellable */
 							&neardalMgr.gerror);
+	neardal_stats_call(NEARDAL_METHOD_NEW_PROXY, start,
+			   neardalMgr.gerror == NULL);
+	NEARDAL_TIMELINE_SPAN("tag proxy", tagProp->name, start);
 	if (neardalMgr.gerror != NULL) {
 		NEARDAL_TRACE_ERR(
 			"Unable to create Neard Tag Proxy (%d:%s)\n",
 				  neardalMgr.gerror->code,
 				  neardalMgr.gerror->message);
 		neardal_tools_prv_free_gerror(&neardalMgr.gerror);
-		return NEARDAL_ERROR_DBUS_CANNOT_CREATE_PROXY;
+		tagProp->proxy = NULL;
 	}
 
-	/* Populate Tag datas... */
-	err = neardal_tag_prv_read_properties(tagProp);
-	if (err != NEARDAL_SUCCESS)
-		return err;
+	return tagProp->proxy;
+}
 
-	return err;
+/*****************************************************************************
+ * neardal_tag_init: Populate NFC tag datas from the Neard objects cache.
+ * The DBus proxy is created on demand (see neardal_tag_prv_get_proxy)
+ ****************************************************************************/
+static errorCode_t neardal_tag_prv_init(TagProp *tagProp)
+{
+	NEARDAL_TRACEIN();
+	NEARDAL_ASSERT_RET(tagProp != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
+
+	/* Populate Tag datas... */
+	return neardal_tag_prv_read_properties(tagProp);
 }
 
 /*****************************************************************************
@@ -182,22 +193,18 @@ void neardal_tag_notify_tag_found(TagProp *tagProp)
 
 	NEARDAL_ASSERT(tagProp != NULL);
 
-	if (tagProp->notified == FALSE && neardalMgr.cb.tag_found != NULL) {
-		(neardalMgr.cb.tag_found)(tagProp->name,
-					   neardalMgr.cb.tag_found_ud);
-		tagProp->notified = TRUE;
-	}
+	if (tagProp->notified == FALSE)
+		tagProp->notified = neardal_listener_prv_notify_tag(
+					NEARDAL_EVENT_TAG_FOUND, tagProp);
 
 	len = 0;
-	if (neardalMgr.cb.rcd_found != NULL)
-		while (len < g_list_length(tagProp->rcdList)) {
-			rcdProp = g_list_nth_data(tagProp->rcdList, len++);
-			if (rcdProp->notified == FALSE) {
-				(neardalMgr.cb.rcd_found)(rcdProp->name,
-						neardalMgr.cb.rcd_found_ud);
-				rcdProp->notified = TRUE;
-			}
-		}
+	while (len < g_list_length(tagProp->rcdList)) {
+		rcdProp = g_list_nth_data(tagProp->rcdList, len++);
+		if (rcdProp->notified == FALSE)
+			rcdProp->notified = neardal_listener_prv_notify_record(
+				rcdProp->name,
+				neardal_data_search(rcdProp->name));
+	}
 }
 
 errorCode_t neardal_tag_write(neardal_record *record)
@@ -206,6 +213,8 @@ errorCode_t neardal_tag_write(neardal_record *record)
 	errorCode_t	err;
 	TagProp		*tag;
 	GVariant	*in;
+	guint64		start;
+	gboolean	ok;
 
 	NEARDAL_ASSERT_RET(record != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
 
@@ -216,14 +225,21 @@ errorCode_t neardal_tag_write(neardal_record *record)
 	if (!(tag = neardal_mgr_tag_search(record->name)))
 		return NEARDAL_ERROR_NO_TAG;
 
+	if (neardal_tag_prv_get_proxy(tag) == NULL)
+		return NEARDAL_ERROR_DBUS_CANNOT_CREATE_PROXY;
+
 	in = neardal_record_to_g_variant(record);
 
-	if (org_neard_tag_call_write_sync(tag->proxy, in, NULL, &gerror)
-			== FALSE) {
+	start = neardal_stats_call_begin(NEARDAL_METHOD_TAG_WRITE);
+	ok = org_neard_tag_call_write_sync(tag->proxy, in, NULL, &gerror);
+	neardal_stats_call(NEARDAL_METHOD_TAG_WRITE, start, ok);
+	NEARDAL_TIMELINE_SPAN("Write", record->name, start);
+	if (ok == FALSE) {
 		NEARDAL_TRACE_ERR("Can't write record: %s\n", gerror->message);
 		g_error_free(gerror);
 		err = NEARDAL_ERROR_DBUS;
 	}
+	NEARDAL_TRACE_EVENT(NEARDAL_TRACE_EV_TAG_WRITE, record->name, err, 0);
 
 	return err;
 }
@@ -250,6 +266,7 @@ errorCode_t neardal_tag_prv_add(gchar *tagName, void *parent)
 	tagProp->parent	= adpProp;
 
 	adpProp->tagList = g_list_prepend(adpProp->tagList, tagProp);
+	NEARDAL_PROBE2(registry_add, "Tag", tagProp->name);
 	err = neardal_tag_prv_init(tagProp);
 
 	NEARDAL_TRACEF("NEARDAL LIB tagList contains %d elements\n",
@@ -280,6 +297,7 @@ void neardal_tag_prv_remove(TagProp *tagProp)
 
 	NEARDAL_TRACEF("Removing tag:%s\n", tagProp->name);
 
+	NEARDAL_PROBE2(registry_remove, "Tag", tagProp->name);
 	adpProp = tagProp->parent;
 	adpProp->tagList = g_list_remove(adpProp->tagList,
 					 (gconstpointer) tagProp);
@@ -0,0 +1,226 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+
+#include "neardal.h"
+#include "neardal_prv.h"
+
+static const char * const neardal_timeline_cb_names[NEARDAL_EVENT_COUNT] = {
+	[NEARDAL_EVENT_ADAPTER_ADDED]		= "adp_added callbacks",
+	[NEARDAL_EVENT_ADAPTER_REMOVED]		= "adp_removed callbacks",
+	[NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED] = "adp_prop_changed callbacks",
+	[NEARDAL_EVENT_TAG_FOUND]		= "tag_found callbacks",
+	[NEARDAL_EVENT_TAG_LOST]		= "tag_lost callbacks",
+	[NEARDAL_EVENT_DEV_FOUND]		= "dev_found callbacks",
+	[NEARDAL_EVENT_DEV_LOST]		= "dev_lost callbacks",
+	[NEARDAL_EVENT_RECORD_FOUND]		= "rcd_found callbacks"
+};
+
+/*
+ * Spans are written as complete events ("ph":"X") when they end, the
+ * track (tid) of an object being the one of its adapter. Everything is
+ * under lock: calls may come from any thread.
+ */
+int			neardal_timeline_on;
+static FILE		*timelineFile;
+static int		timelinePid;
+static guint		nbTracks;
+static GHashTable	*tracks;	/* Adapter path -> track id */
+static GHashTable	*tags;		/* Tag path -> lifetime start (ns) */
+G_LOCK_DEFINE_STATIC(timeline);
+
+/*****************************************************************************
+ * neardal_timeline_prv_track: Track of an object, created on first use
+ ****************************************************************************/
+static guint neardal_timeline_prv_track(const char *path)
+{
+	gchar		*adp;
+	gpointer	tid;
+
+	adp = g_strndup(path, neardal_tools_prv_adapter_len(path));
+	tid = g_hash_table_lookup(tracks, adp);
+	if (tid != NULL) {
+		g_free(adp);
+		return GPOINTER_TO_UINT(tid);
+	}
+
+	tid = GUINT_TO_POINTER(++nbTracks);
+	g_hash_table_insert(tracks, adp, tid);
+	fprintf(timelineFile, ",\n{\"name\":\"thread_name\",\"ph\":\"M\","
+		"\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+		timelinePid, GPOINTER_TO_UINT(tid), adp);
+
+	return GPOINTER_TO_UINT(tid);
+}
+
+/*****************************************************************************
+ * neardal_timeline_prv_write: Write a span (timeline lock held)
+ ****************************************************************************/
+static void neardal_timeline_prv_write(const char *name, const char *path,
+				       guint64 start, guint64 end)
+{
+	fprintf(timelineFile, ",\n{\"name\":\"%s\",\"cat\":\"neardal\","
+		"\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+		"\"args\":{\"path\":\"%s\"}}", name, timelinePid,
+		neardal_timeline_prv_track(path), start / 1000.0,
+		(end > start ? end - start : 0) / 1000.0, path);
+}
+
+void neardal_timeline_prv_span(const char *name, const char *path,
+			       guint64 start, guint64 end)
+{
+	if (path == NULL)
+		return;
+
+	G_LOCK(timeline);
+	if (timelineFile != NULL)
+		neardal_timeline_prv_write(name, path, start, end);
+	G_UNLOCK(timeline);
+}
+
+void neardal_timeline_prv_signal(const char *member, const char *path,
+				 guint64 start)
+{
+	guint64 received = neardal_stats_msg_received();
+
+	neardal_timeline_prv_span(member, path, received ? received : start,
+				  neardal_stats_now());
+}
+
+void neardal_timeline_prv_callbacks(unsigned int kind, const char *path,
+				    guint64 start)
+{
+	if (kind < NEARDAL_EVENT_COUNT)
+		neardal_timeline_prv_span(neardal_timeline_cb_names[kind],
+					  path, start, neardal_stats_now());
+}
+
+void neardal_timeline_prv_tag(const char *tag, gboolean found)
+{
+	guint64 ts = neardal_stats_msg_received();
+	guint64 *start;
+
+	/* The lifetime spans from signal arrival to signal arrival */
+	if (ts == 0)
+		ts = neardal_stats_now();
+
+	G_LOCK(timeline);
+	if (timelineFile == NULL)
+		goto exit;
+
+	start = g_hash_table_lookup(tags, tag);
+	if (found == TRUE && start == NULL) {
+		start = g_new(guint64, 1);
+		*start = ts;
+		g_hash_table_insert(tags, g_strdup(tag), start);
+	} else if (found == FALSE && start != NULL) {
+		neardal_timeline_prv_write("tag", tag, *start, ts);
+		g_hash_table_remove(tags, tag);
+	}
+
+exit:
+	G_UNLOCK(timeline);
+}
+
+errorCode_t neardal_timeline_start(const char *path)
+{
+	FILE *fp;
+
+	if (path == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	neardal_timeline_stop();
+
+	fp = fopen(path, "w");
+	if (fp == NULL) {
+		NEARDAL_TRACE_ERR("Can't create '%s'\n", path);
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+	}
+
+	G_LOCK(timeline);
+	timelineFile = fp;
+	timelinePid = getpid();
+	nbTracks = 0;
+	tracks = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	tags = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	fprintf(fp, "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+		"\"args\":{\"name\":\"neardal\"}}", timelinePid);
+	__atomic_store_n(&neardal_timeline_on, 1, __ATOMIC_RELAXED);
+	G_UNLOCK(timeline);
+
+	return NEARDAL_SUCCESS;
+}
+
+void neardal_timeline_stop(void)
+{
+	GHashTableIter	iter;
+	gpointer	tag, start;
+	guint64		now = neardal_stats_now();
+
+	__atomic_store_n(&neardal_timeline_on, 0, __ATOMIC_RELAXED);
+
+	G_LOCK(timeline);
+	if (timelineFile == NULL)
+		goto exit;
+
+	/* Tags still present end with the recording */
+	g_hash_table_iter_init(&iter, tags);
+	while (g_hash_table_iter_next(&iter, &tag, &start))
+		neardal_timeline_prv_write("tag", tag, *(guint64 *) start, now);
+
+	fputs("\n]\n", timelineFile);
+	if (fclose(timelineFile) != 0)
+		NEARDAL_TRACE_ERR("Timeline not fully written\n");
+	timelineFile = NULL;
+	g_hash_table_destroy(tracks);
+	g_hash_table_destroy(tags);
+	tracks = tags = NULL;
+
+exit:
+	G_UNLOCK(timeline);
+}
+
+/*****************************************************************************
+ * neardal_timeline_prv_init: Apply the NEARDAL_TIMELINE environment variable
+ * when the library is loaded
+ ****************************************************************************/
+static void __attribute__((constructor)) neardal_timeline_prv_init(void)
+{
+	const char *s = getenv("NEARDAL_TIMELINE");
+
+	if (s != NULL && *s != '\0' &&
+	    neardal_timeline_start(s) != NEARDAL_SUCCESS)
+		fprintf(stderr, "neardal: invalid NEARDAL_TIMELINE '%s'\n", s);
+}
+
+/*****************************************************************************
+ * neardal_timeline_prv_exit: Complete the timeline file at exit
+ ****************************************************************************/
+static void __attribute__((destructor)) neardal_timeline_prv_exit(void)
+{
+	neardal_timeline_stop();
+}
@@ -0,0 +1,70 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+/*!
+ * @file neardal_timeline.h
+ *
+ * @brief Defines NEARDAL timeline: tag lifecycle spans written as Chrome
+ * Trace Event JSON, to be viewed in Perfetto (ui.perfetto.dev) or
+ * chrome://tracing
+ *
+ ******************************************************************************/
+
+#ifndef NEARDAL_TIMELINE_H
+#define NEARDAL_TIMELINE_H
+
+#include "neardal_errors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/*! @brief NEARDAL timeline
+ * @addtogroup NEARDAL_TIMELINE Timeline
+ * @{
+ * One track (thread) per adapter, holding:
+ * - tag lifetime spans, from the TagFound signal arrival to the TagLost one
+ * - signal spans, from arrival to the end of their handling
+ * - TagProp creation, tag proxy creation, Write and Push calls
+ * - client callbacks of each event
+*/
+
+/*! \fn errorCode_t neardal_timeline_start(const char *path)
+ * @brief Start recording the timeline to a file (truncated), stopping the
+ * recording in progress if any.
+ * Recording may also be started when the library is loaded with the
+ * NEARDAL_TIMELINE=<file> environment variable.
+ * @param path file name
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_timeline_start(const char *path);
+
+/*! \fn void neardal_timeline_stop(void)
+ * @brief Stop recording and close the file. Done at exit if still
+ * recording.
+ **/
+void neardal_timeline_stop(void);
+
+/* @}*/
+
+#ifdef __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif /* NEARDAL_TIMELINE_H */
@@ -37,26 +37,6 @@ void neardal_g_strfreev(void **array, void *end)
 	g_free(array);
 }
 
-void neardal_g_variant_add_parsed(GVariant **v, const char *format, ...)
-{
-	GVariantBuilder b;
-	GVariantIter iter;
-	GVariant *i = NULL;
-	va_list ap;
-
-	g_variant_builder_init(&b, G_VARIANT_TYPE_ARRAY);
-
-	va_start(ap, format);
-	g_variant_builder_add_value(&b, g_variant_new_parsed_va(format, &ap));
-	va_end(ap);
-
-	g_variant_iter_init(&iter, *v);
-	while (g_variant_iter_loop(&iter, "*", &i))
-		g_variant_builder_add_value(&b, i);
-
-	*v = g_variant_builder_end(&b);
-}
-
 void neardal_g_variant_dump(GVariant *data)
 {
 	GVariantIter iter;
@@ -64,7 +44,7 @@ void neardal_g_variant_dump(GVariant *data)
 	GVariant *v = NULL;
 	g_variant_iter_init(&iter, data);
 	while (g_variant_iter_loop(&iter, "{sv}", &s, &v))
-		NEARDAL_TRACEF(".. %s = %s\n", s, g_variant_print(v, 0));
+		NEARDAL_TRACEF(".. %s = %s\n", s, neardal_trace_variant(v));
 }
 
 void *neardal_g_variant_get(GVariant *data, const char *key, const char *fmt)
@@ -102,21 +82,51 @@ guint neardal_data_to_arrayv(void ***array)
 	return *array ? g_strv_length((gchar **) *array) : 0;
 }
 
+/*****************************************************************************
+ * neardal_data_insert: Store a copy of the 'in' properties, with 'Name' and
+ * 'NeardalType' entries added, in the registry. The copy is built in one pass
+ * and is owned by the registry, 'in' is left untouched.
+ ****************************************************************************/
 GVariant *neardal_data_insert(const char *name, const char *type, GVariant *in)
 {
-	GVariant *out = in;
-	GData **l = &(neardalMgr.dbus_data);
-	neardal_g_variant_add_parsed(&out, "{'NeardalType', <%s>}", type);
-	neardal_g_variant_add_parsed(&out, "{'Name', <%s>}", name);
-	g_datalist_set_data_full(l, name, g_variant_ref(out),
-					(GDestroyNotify) g_variant_unref);
+	static gsize	init;
+	static GVariant	*nameKey, *typeKey;
+	GData		**l = &(neardalMgr.dbus_data);
+	GVariantBuilder	b;
+	GVariantIter	iter;
+	GVariant	*out, *i;
+
+	if (g_once_init_enter(&init)) {
+		typeKey = g_variant_ref_sink(g_variant_new_string(
+							"NeardalType"));
+		nameKey = g_variant_ref_sink(g_variant_new_string("Name"));
+		g_once_init_leave(&init, 1);
+	}
+
+	g_variant_builder_init(&b, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add_value(&b, g_variant_new_dict_entry(typeKey,
+			g_variant_new_variant(g_variant_new_string(type))));
+	g_variant_builder_add_value(&b, g_variant_new_dict_entry(nameKey,
+			g_variant_new_variant(g_variant_new_string(name))));
+	g_variant_iter_init(&iter, in);
+	while ((i = g_variant_iter_next_value(&iter)) != NULL) {
+		g_variant_builder_add_value(&b, i);
+		g_variant_unref(i);
+	}
+	out = g_variant_ref_sink(g_variant_builder_end(&b));
+
+	g_datalist_set_data_full(l, name, out, (GDestroyNotify) g_variant_unref);
+	NEARDAL_PROBE2(registry_add, type, name);
 	return out;
 }
 
 void neardal_data_remove(GVariant *data)
 {
 	GData **l = &(neardalMgr.dbus_data);
-	g_datalist_remove_data(l, neardal_g_variant_get(data, "Name", "&s"));
+	const char *name = neardal_g_variant_get(data, "Name", "&s");
+
+	NEARDAL_PROBE2(registry_remove, "Record", name);
+	g_datalist_remove_data(l, name);
 }
 
 char *neardal_dirname(const char *path)
@@ -174,61 +184,25 @@ int neardal_tools_prv_cmp_path(const char *neardalPath, const char *reqPath)
 }
 
 /*****************************************************************************
- * neardal_tools_prv_create_dict: Create a GHashTable for dict_entries.
+ * neardal_tools_prv_adapter_len: Length of the adapter part of an object path
+ * ("/org/neard/nfc0" of "/org/neard/nfc0/tag0/record0")
  ****************************************************************************/
-GHashTable *neardal_tools_prv_create_dict(void)
+gsize neardal_tools_prv_adapter_len(const char *path)
 {
-	return g_hash_table_new(g_str_hash, g_str_equal);
+	const char	*end = path;
+	int		i;
+
+	for (i = 0; i < 3 && end != NULL; i++)
+		end = strchr(end + 1, '/');
+
+	return end != NULL ? (gsize) (end - path) : strlen(path);
 }
 
 /*****************************************************************************
- * neardal_tools_prv_add_dict_entry: add an entry in a dictionnary
+ * neardal_tools_prv_create_dict: Create a GHashTable for dict_entries.
  ****************************************************************************/
-errorCode_t neardal_tools_prv_add_dict_entry(GVariantBuilder *builder
-					     , const gchar *key, void *value
-					     , gsize valueSize
-					     , int gVariantType)
+GHashTable *neardal_tools_prv_create_dict(void)
 {
-	GVariant	*tmp			= NULL;
-	GVariantBuilder	*bytesArrayBuilder	= NULL;
-	unsigned char	*bytePtr;
-	gsize		count;
-	errorCode_t	err			= NEARDAL_SUCCESS;
-
-	NEARDAL_ASSERT_RET(builder != NULL, NEARDAL_ERROR_INVALID_PARAMETER);
-
-	switch (gVariantType) {
-	case G_TYPE_STRING:
-		tmp = g_variant_new_string(value);
-		break;
-	case G_TYPE_UINT:
-		tmp = g_variant_new_uint32(GPOINTER_TO_UINT(value));
-		break;
-	default:
-		/* if valueSize > 0, consider value as byte array
-		 processing like g_variant_new_bytestring() but based on array
-		 size and not a null terminated string  (allowing byte = 0
-		 in array) */
-		if (valueSize > 0) {
-			err = NEARDAL_ERROR_GENERAL_ERROR;
-			bytePtr = (unsigned char*) value;
-			bytesArrayBuilder = g_variant_builder_new(
-						G_VARIANT_TYPE_BYTESTRING);
-			if (bytesArrayBuilder == NULL)
-				break;
-
-			for (count = 0; count < valueSize; count++)
-				g_variant_builder_add(bytesArrayBuilder, "y"
-						      , bytePtr[count]);
-
-			tmp = g_variant_builder_end(bytesArrayBuilder);
-			g_variant_builder_unref(bytesArrayBuilder);
-			err = NEARDAL_SUCCESS;
-		}
-		break;
-	}
-	g_variant_builder_add(builder, "{sv}", key, tmp);
-
-	return err;
+	return g_hash_table_new(g_str_hash, g_str_equal);
 }
 
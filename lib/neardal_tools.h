@@ -58,21 +58,18 @@ void neardal_tools_prv_free_gerror(GError **gerror);
  *****************************************************************************/
 int neardal_tools_prv_cmp_path(const char *neardalPath, const char *reqPath);
 
-/******************************************************************************
- * neardal_tools_prv_create_dict: Create a GHashTable for dict_entries.
+/*****************************************************************************
+ * neardal_tools_prv_adapter_len: Length of the adapter part of an object
+ * path, its 3 first components (/org/neard/nfc0)
  *****************************************************************************/
-GHashTable *neardal_tools_prv_create_dict(void);
+gsize neardal_tools_prv_adapter_len(const char *path);
 
 /******************************************************************************
- * neardal_tools_prv_add_dict_entry: add an entry in a dictionnary
+ * neardal_tools_prv_create_dict: Create a GHashTable for dict_entries.
  *****************************************************************************/
-errorCode_t neardal_tools_prv_add_dict_entry(GVariantBuilder *builder
-					     , const gchar *key, void *value
-					     , gsize valueSize
-					     , int gVariantType);
+GHashTable *neardal_tools_prv_create_dict(void);
 
 void neardal_g_strfreev(void **array, void *end);
-void neardal_g_variant_add_parsed(GVariant **v, const char *format, ...);
 void *neardal_g_variant_get(GVariant *data, const char *key, const char *fmt);
 void *neardal_data_search(const char *name);
 GVariant *neardal_data_insert(const char *name, const char *type, GVariant *in);
@@ -93,20 +90,4 @@ static inline gpointer neardal_g_callback(GCallback gc)
 
 #define NEARDAL_G_CALLBACK(_cb) neardal_g_callback(G_CALLBACK((_cb)))
 
-#define NEARDAL_G_VARIANT_IN(_builder, _format, _data)			\
-do {									\
-	if ((_data))							\
-		g_variant_builder_add_parsed((_builder),		\
-						(_format), (_data));	\
-} while (0)
-
-#define NEARDAL_G_VARIANT_OUT(_dictionary, _key, _format, _data)	\
-do {									\
-	if (g_variant_lookup((_dictionary), (_key), (_format),		\
-			(_data)) == TRUE) {				\
-		NEARDAL_TRACEF("%s = '%" _format "'\n",			\
-				(_key), *(_data));			\
-	}								\
-} while (0)
-
 #endif /* NEARDAL_TOOLS_H */
@@ -0,0 +1,422 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <glib.h>
+
+#include "neardal.h"
+#include "neardal_traces_prv.h"
+
+/* Largest ring accepted (records) */
+#define TRACE_RING_MAX		(1U << 24)
+
+/* Object names kept per ring (power of 2, at most 255) */
+#define TRACE_RING_NAMES	64
+/* Longest object name kept, longer ones are truncated */
+#define TRACE_RING_NAME_LEN	64
+
+/*
+ * Object name of a ring. Record object ids are ring local: slot + 1 in the
+ * low 8 bits, slot generation above, so that records of an evicted name no
+ * longer match it. The owner thread clears 'id' while it rewrites 'name', a
+ * dump drops the names whose 'id' changed while copying.
+ */
+typedef struct {
+	guint32			id;	/* 0 = free or being written */
+	gchar			name[TRACE_RING_NAME_LEN];
+} NeardalTraceName;
+
+/*
+ * Ring of a thread. Only the owner thread writes records and 'head', a dump
+ * copies records then checks 'head' again to drop the ones overwritten while
+ * copying.
+ */
+typedef struct NeardalTraceRing {
+	struct NeardalTraceRing	*next;
+	guint32			thread;
+	guint32			mask;
+	guint32			generation;	/* of the last name added */
+	NeardalTraceName	names[TRACE_RING_NAMES];
+	guint64			head;	/* next write index */
+	neardal_trace_record	rec[];
+} NeardalTraceRing;
+
+/* Copy of a ring taken by a dump */
+typedef struct {
+	guint32			thread;
+	guint32			nbRecords;
+	neardal_trace_record	*rec;
+	NeardalTraceName	names[TRACE_RING_NAMES];
+} NeardalTraceSnap;
+
+static const char * const neardal_trace_ev_names[NEARDAL_TRACE_EV_COUNT] = {
+	[NEARDAL_TRACE_EV_NONE]			= "none",
+	[NEARDAL_TRACE_EV_DISPATCH]		= "dispatch",
+	[NEARDAL_TRACE_EV_AGENT_NDEF]		= "agent_ndef",
+	[NEARDAL_TRACE_EV_AGENT_OOB_REQ]	= "agent_oob_request",
+	[NEARDAL_TRACE_EV_AGENT_OOB_PUSH]	= "agent_oob_push",
+	[NEARDAL_TRACE_EV_AGENT_RELEASE]	= "agent_release",
+	[NEARDAL_TRACE_EV_TAG_WRITE]		= "tag_write",
+	[NEARDAL_TRACE_EV_DEV_PUSH]		= "dev_push",
+	[NEARDAL_TRACE_EV_ADP_SET_PROP]		= "adapter_set_property",
+	[NEARDAL_TRACE_EV_POLL]			= "poll"
+};
+
+static void neardal_trace_ring_prv_free(gpointer data);
+
+int				neardal_trace_ring_on;
+static guint32			ringSize = NEARDAL_TRACE_RING_DEFAULT;
+static NeardalTraceRing		*rings;
+G_LOCK_DEFINE_STATIC(rings);
+static GPrivate			threadRing =
+				G_PRIVATE_INIT(neardal_trace_ring_prv_free);
+
+/*****************************************************************************
+ * neardal_trace_ring_prv_free: Unregister and free the ring of an exiting
+ * thread
+ ****************************************************************************/
+static void neardal_trace_ring_prv_free(gpointer data)
+{
+	NeardalTraceRing	*r = data;
+	NeardalTraceRing	**p;
+
+	G_LOCK(rings);
+	for (p = &rings; *p != NULL; p = &(*p)->next)
+		if (*p == r) {
+			*p = r->next;
+			break;
+		}
+	G_UNLOCK(rings);
+
+	g_free(r);
+}
+
+/*****************************************************************************
+ * neardal_trace_ring_prv_new: Allocate and register the ring of the calling
+ * thread
+ ****************************************************************************/
+static NeardalTraceRing *neardal_trace_ring_prv_new(void)
+{
+	NeardalTraceRing	*r;
+	guint32			size;
+
+	size = __atomic_load_n(&ringSize, __ATOMIC_RELAXED);
+	r = g_try_malloc0(sizeof(*r) + size * sizeof(neardal_trace_record));
+	if (r == NULL)
+		return NULL;
+	r->thread = syscall(SYS_gettid);
+	r->mask = size - 1;
+
+	G_LOCK(rings);
+	r->next = rings;
+	rings = r;
+	G_UNLOCK(rings);
+
+	g_private_set(&threadRing, r);
+	return r;
+}
+
+/*****************************************************************************
+ * neardal_trace_ring_prv_object: Ring local id of an object name, the name
+ * is added to the ring table if missing, evicting the one in its slot
+ ****************************************************************************/
+static guint32 neardal_trace_ring_prv_object(NeardalTraceRing *r,
+					     const char *object)
+{
+	NeardalTraceName	*n;
+	guint32			slot, id;
+
+	slot = g_str_hash(object) & (TRACE_RING_NAMES - 1);
+	n = &r->names[slot];
+	if (n->id != 0 && strncmp(n->name, object, sizeof(n->name) - 1) == 0)
+		return n->id;
+
+	id = (++r->generation << 8) | (slot + 1);
+	__atomic_store_n(&n->id, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	g_strlcpy(n->name, object, sizeof(n->name));
+	__atomic_store_n(&n->id, id, __ATOMIC_RELEASE);
+
+	return id;
+}
+
+void neardal_trace_ring_prv_add(unsigned int event, const char *object,
+				int64_t arg0, int64_t arg1)
+{
+	NeardalTraceRing	*r = g_private_get(&threadRing);
+	neardal_trace_record	*rec;
+	struct timespec		ts;
+
+	if (r == NULL && (r = neardal_trace_ring_prv_new()) == NULL)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	rec = &r->rec[r->head & r->mask];
+	rec->ts = (guint64) ts.tv_sec * G_GUINT64_CONSTANT(1000000000) +
+		  ts.tv_nsec;
+	rec->event = event;
+	rec->reserved = 0;
+	rec->object = object ? neardal_trace_ring_prv_object(r, object) : 0;
+	rec->arg[0] = arg0;
+	rec->arg[1] = arg1;
+	__atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+void neardal_trace_ring_event(unsigned int event, const char *object,
+			      int64_t arg0, int64_t arg1)
+{
+	NEARDAL_TRACE_EVENT(event, object, arg0, arg1);
+}
+
+const char *neardal_trace_event_name(unsigned int event)
+{
+	if (event >= NEARDAL_TRACE_EV_USER)
+		return "user";
+	if (event >= NEARDAL_TRACE_EV_COUNT)
+		return "unknown";
+	return neardal_trace_ev_names[event];
+}
+
+errorCode_t neardal_trace_ring_enable(unsigned int nbRecords)
+{
+	guint32 size = 1;
+
+	if (nbRecords == 0)
+		nbRecords = NEARDAL_TRACE_RING_DEFAULT;
+	if (nbRecords > TRACE_RING_MAX)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+	while (size < nbRecords)
+		size <<= 1;
+
+	__atomic_store_n(&ringSize, size, __ATOMIC_RELAXED);
+	__atomic_store_n(&neardal_trace_ring_on, 1, __ATOMIC_RELAXED);
+
+	return NEARDAL_SUCCESS;
+}
+
+void neardal_trace_ring_disable(void)
+{
+	__atomic_store_n(&neardal_trace_ring_on, 0, __ATOMIC_RELAXED);
+}
+
+/*****************************************************************************
+ * neardal_trace_ring_prv_snap: Copy the valid records of a ring, oldest
+ * first
+ ****************************************************************************/
+static void neardal_trace_ring_prv_snap(NeardalTraceRing *r,
+					NeardalTraceSnap *snap)
+{
+	guint64	size = (guint64) r->mask + 1;
+	guint64	head, end, first;
+	guint32	i, n, id;
+
+	head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	n = MIN(head, size);
+	for (i = 0; i < n; i++)
+		snap->rec[i] = r->rec[(head - n + i) & r->mask];
+
+	/*
+	 * The owner thread may have run meanwhile: records below 'first' were
+	 * (or are being) overwritten
+	 */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	end = __atomic_load_n(&r->head, __ATOMIC_RELAXED) + 1;
+	first = end > size ? end - size : 0;
+	i = 0;
+	if (first > head - n)
+		i = MIN(first - (head - n), n);
+
+	snap->thread = r->thread;
+	snap->nbRecords = n - i;
+	memmove(snap->rec, snap->rec + i, snap->nbRecords * sizeof(*snap->rec));
+
+	/* Names rewritten while copying are dropped like the records */
+	for (i = 0; i < TRACE_RING_NAMES; i++) {
+		id = __atomic_load_n(&r->names[i].id, __ATOMIC_ACQUIRE);
+		memcpy(snap->names[i].name, r->names[i].name,
+		       sizeof(snap->names[i].name));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&r->names[i].id, __ATOMIC_RELAXED) != id)
+			id = 0;
+		snap->names[i].id = id;
+		snap->names[i].name[sizeof(snap->names[i].name) - 1] = '\0';
+	}
+}
+
+/*****************************************************************************
+ * neardal_trace_ring_prv_names: Turn the ring local object ids of the
+ * snapshots into dump wide ones, indexes + 1 of 'names'. Records whose name
+ * was evicted since get an id without name.
+ ****************************************************************************/
+static void neardal_trace_ring_prv_names(GArray *snaps, GPtrArray *names)
+{
+	NeardalTraceSnap	*snap;
+	NeardalTraceName	*n;
+	GHashTable		*ids;
+	gpointer		id;
+	guint32			object;
+	guint			i, j;
+
+	ids = g_hash_table_new(g_str_hash, g_str_equal);
+	for (i = 0; i < snaps->len; i++) {
+		snap = &g_array_index(snaps, NeardalTraceSnap, i);
+		for (j = 0; j < snap->nbRecords; j++) {
+			object = snap->rec[j].object;
+			if (object == 0)
+				continue;
+			n = &snap->names[((object & 0xff) - 1) %
+					 TRACE_RING_NAMES];
+			if (n->id != object) {
+				snap->rec[j].object = G_MAXUINT32;
+				continue;
+			}
+			id = g_hash_table_lookup(ids, n->name);
+			if (id == NULL) {
+				g_ptr_array_add(names, n->name);
+				id = GUINT_TO_POINTER(names->len);
+				g_hash_table_insert(ids, n->name, id);
+			}
+			snap->rec[j].object = GPOINTER_TO_UINT(id);
+		}
+	}
+	g_hash_table_destroy(ids);
+}
+
+/*****************************************************************************
+ * neardal_trace_ring_prv_write: Write the dump file
+ ****************************************************************************/
+static errorCode_t neardal_trace_ring_prv_write(FILE *fp, GArray *snaps)
+{
+	neardal_trace_file_header	hdr;
+	neardal_trace_file_name		name;
+	neardal_trace_file_ring		ring;
+	NeardalTraceSnap		*snap;
+	GPtrArray			*names;
+	const gchar			*str;
+	struct timespec			ts;
+	guint				i;
+	gboolean			ok;
+
+	names = g_ptr_array_new();
+	neardal_trace_ring_prv_names(snaps, names);
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, NEARDAL_TRACE_MAGIC, sizeof(hdr.magic));
+	hdr.version = NEARDAL_TRACE_VERSION;
+	hdr.recordSize = sizeof(neardal_trace_record);
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	hdr.monotonic = (guint64) ts.tv_sec * G_GUINT64_CONSTANT(1000000000) +
+			ts.tv_nsec;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	hdr.realtime = (guint64) ts.tv_sec * G_GUINT64_CONSTANT(1000000000) +
+		       ts.tv_nsec;
+	hdr.nbNames = names->len;
+	hdr.nbRings = snaps->len;
+	ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+
+	for (i = 0; ok && i < names->len; i++) {
+		str = g_ptr_array_index(names, i);
+		name.object = i + 1;
+		name.len = strlen(str);
+		ok = fwrite(&name, sizeof(name), 1, fp) == 1 &&
+		     fwrite(str, 1, name.len, fp) == name.len;
+	}
+	g_ptr_array_free(names, TRUE);
+
+	for (i = 0; ok && i < snaps->len; i++) {
+		snap = &g_array_index(snaps, NeardalTraceSnap, i);
+		ring.thread = snap->thread;
+		ring.nbRecords = snap->nbRecords;
+		ok = fwrite(&ring, sizeof(ring), 1, fp) == 1 &&
+		     fwrite(snap->rec, sizeof(*snap->rec), snap->nbRecords,
+			    fp) == snap->nbRecords;
+	}
+
+	return ok ? NEARDAL_SUCCESS : NEARDAL_ERROR_GENERAL_ERROR;
+}
+
+errorCode_t neardal_trace_ring_dump(const char *path)
+{
+	errorCode_t		err = NEARDAL_ERROR_NO_MEMORY;
+	NeardalTraceRing	*r;
+	NeardalTraceSnap	snap;
+	GArray			*snaps;
+	FILE			*fp;
+	guint			i;
+
+	if (path == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	snaps = g_array_new(FALSE, FALSE, sizeof(NeardalTraceSnap));
+	G_LOCK(rings);
+	for (r = rings; r != NULL; r = r->next) {
+		snap.rec = g_try_malloc(((gsize) r->mask + 1) *
+					sizeof(neardal_trace_record));
+		if (snap.rec == NULL)
+			break;
+		neardal_trace_ring_prv_snap(r, &snap);
+		g_array_append_val(snaps, snap);
+	}
+	G_UNLOCK(rings);
+	if (r != NULL)
+		goto exit;
+
+	fp = fopen(path, "wb");
+	if (fp == NULL) {
+		NEARDAL_TRACE_ERR("Can't create '%s'\n", path);
+		err = NEARDAL_ERROR_INVALID_PARAMETER;
+		goto exit;
+	}
+	err = neardal_trace_ring_prv_write(fp, snaps);
+	if (fclose(fp) != 0)
+		err = NEARDAL_ERROR_GENERAL_ERROR;
+
+exit:
+	for (i = 0; i < snaps->len; i++)
+		g_free(g_array_index(snaps, NeardalTraceSnap, i).rec);
+	g_array_free(snaps, TRUE);
+	return err;
+}
+
+/*****************************************************************************
+ * neardal_trace_ring_prv_init: Apply the NEARDAL_TRACE_RING environment
+ * variable when the library is loaded
+ ****************************************************************************/
+static void __attribute__((constructor)) neardal_trace_ring_prv_init(void)
+{
+	const char	*s = getenv("NEARDAL_TRACE_RING");
+	char		*end;
+	unsigned long	n;
+
+	if (s == NULL || *s == '\0')
+		return;
+	n = strtoul(s, &end, 0);
+	if (*end != '\0' || n > TRACE_RING_MAX ||
+	    neardal_trace_ring_enable(n) != NEARDAL_SUCCESS)
+		fprintf(stderr, "neardal: invalid NEARDAL_TRACE_RING '%s'\n",
+			s);
+}
@@ -0,0 +1,167 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+/*!
+ * @file neardal_trace_ring.h
+ *
+ * @brief Defines NEARDAL binary trace: per thread rings of fixed size event
+ * records, dumped to a file and decoded offline
+ *
+ ******************************************************************************/
+
+#ifndef NEARDAL_TRACE_RING_H
+#define NEARDAL_TRACE_RING_H
+
+#include <stdint.h>
+
+#include "neardal_errors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/*! @brief NEARDAL binary trace
+ * @addtogroup NEARDAL_TRACE_RING Binary trace
+ * @{
+*/
+
+/*! @brief Trace event ids */
+typedef enum {
+	NEARDAL_TRACE_EV_NONE = 0,
+	/*! Event dispatched, arg0: neardal_event, arg1: delivered to client */
+	NEARDAL_TRACE_EV_DISPATCH,
+	/*! Agent GetNDEF request, arg0: number of records */
+	NEARDAL_TRACE_EV_AGENT_NDEF,
+	/*! Agent RequestOOB, arg0: blob length */
+	NEARDAL_TRACE_EV_AGENT_OOB_REQ,
+	/*! Agent PushOOB, arg0: blob length */
+	NEARDAL_TRACE_EV_AGENT_OOB_PUSH,
+	/*! Agent released by neard */
+	NEARDAL_TRACE_EV_AGENT_RELEASE,
+	/*! neardal_tag_write(), arg0: errorCode_t */
+	NEARDAL_TRACE_EV_TAG_WRITE,
+	/*! neardal_dev_push(), arg0: errorCode_t */
+	NEARDAL_TRACE_EV_DEV_PUSH,
+	/*! neardal_set_adapter_property(), arg0: property, arg1: errorCode_t */
+	NEARDAL_TRACE_EV_ADP_SET_PROP,
+	/*! Start (arg0: mode) or stop (arg0: -1) polling, arg1: errorCode_t */
+	NEARDAL_TRACE_EV_POLL,
+	NEARDAL_TRACE_EV_COUNT,
+	/*! First id free for application events */
+	NEARDAL_TRACE_EV_USER = 0x8000
+} neardal_trace_event;
+
+/*! @brief One trace record (32 bytes) */
+typedef struct {
+	uint64_t	ts;		/*!< @brief CLOCK_MONOTONIC (ns) */
+	uint16_t	event;		/*!< @brief neardal_trace_event */
+	uint16_t	reserved;
+	uint32_t	object;		/*!< @brief Object id (0 = none) */
+	int64_t		arg[2];		/*!< @brief Event arguments */
+} neardal_trace_record;
+
+/*! @brief Dump file magic and version */
+#define NEARDAL_TRACE_MAGIC	"NEARDTRC"
+#define NEARDAL_TRACE_VERSION	1
+
+/*!
+ * @brief Dump file header, in host byte order. It is followed by 'nbNames'
+ * neardal_trace_file_name, each followed by its name (not nul terminated),
+ * then by 'nbRings' neardal_trace_file_ring, each followed by its records
+ * (oldest first).
+ */
+typedef struct {
+	char		magic[8];	/*!< @brief NEARDAL_TRACE_MAGIC */
+	uint32_t	version;	/*!< @brief NEARDAL_TRACE_VERSION */
+	uint32_t	recordSize;	/*!< @brief Record size */
+	uint64_t	monotonic;	/*!< @brief Dump CLOCK_MONOTONIC */
+	uint64_t	realtime;	/*!< @brief Dump CLOCK_REALTIME */
+	uint32_t	nbNames;	/*!< @brief Object names count */
+	uint32_t	nbRings;	/*!< @brief Thread rings count */
+} neardal_trace_file_header;
+
+/*! @brief Dump file object name (D-Bus object path) */
+typedef struct {
+	uint32_t	object;		/*!< @brief Object id */
+	uint32_t	len;		/*!< @brief Name length */
+} neardal_trace_file_name;
+
+/*! @brief Dump file thread ring */
+typedef struct {
+	uint32_t	thread;		/*!< @brief Thread id */
+	uint32_t	nbRecords;	/*!< @brief Records count */
+} neardal_trace_file_ring;
+
+/*! @brief Default ring size (records per thread) */
+#define NEARDAL_TRACE_RING_DEFAULT	4096
+
+/*! \fn errorCode_t neardal_trace_ring_enable(unsigned int nbRecords)
+ * @brief Start recording trace events. Each thread writes, without lock nor
+ * formatting, to its own ring keeping its 'nbRecords' last events (rounded
+ * up to a power of 2, 0 for NEARDAL_TRACE_RING_DEFAULT). The size applies to
+ * the rings of threads not traced yet. The ring of a thread, and its events,
+ * go away when the thread exits.
+ * Tracing may also be enabled when the library is loaded with the
+ * NEARDAL_TRACE_RING=<nbRecords> environment variable.
+ * @param nbRecords ring size
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_trace_ring_enable(unsigned int nbRecords);
+
+/*! \fn void neardal_trace_ring_disable(void)
+ * @brief Stop recording trace events. Recorded events are kept, to be
+ * dumped with neardal_trace_ring_dump().
+ **/
+void neardal_trace_ring_disable(void);
+
+/*! \fn errorCode_t neardal_trace_ring_dump(const char *path)
+ * @brief Write the events of all rings to a file, to be decoded with the
+ * neardal_trace_decode tool. May be called from any thread, while tracing
+ * is running.
+ * @param path file name
+ * @return errorCode_t error code
+ **/
+errorCode_t neardal_trace_ring_dump(const char *path);
+
+/*! \fn void neardal_trace_ring_event(unsigned int event, const char *object,
+ * int64_t arg0, int64_t arg1)
+ * @brief Record an event (NEARDAL_TRACE_EV_USER and above for application
+ * events) if tracing is enabled
+ * @param event event id
+ * @param object object name (D-Bus object path), may be NULL
+ * @param arg0 first argument
+ * @param arg1 second argument
+ **/
+void neardal_trace_ring_event(unsigned int event, const char *object,
+			      int64_t arg0, int64_t arg1);
+
+/*! \fn const char *neardal_trace_event_name(unsigned int event)
+ * @brief Get the name of a trace event id
+ * @param event event id
+ * @return event name ("user" for application events, "unknown" otherwise)
+ **/
+const char *neardal_trace_event_name(unsigned int event);
+
+/* @}*/
+
+#ifdef __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif /* NEARDAL_TRACE_RING_H */
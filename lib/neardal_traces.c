@@ -26,99 +26,228 @@
 #include <string.h>
 #include <glib.h>
 
+#include "neardal.h"
 #include "neardal_traces_prv.h"
 
 #define NB_COLUMN		16
+/* Dump line: address, " : ", 3 chars and 1 char per column, nul */
+#define DUMP_LINE_LEN		(2 * sizeof(long) + 3 + 4 * NB_COLUMN + 1)
+
+/* Size of the stack buffer holding the "func(): fmt" format */
+#define TRACE_FMT_LEN		256
+/* Number of strings kept alive by neardal_trace_variant() per thread */
+#define TRACE_VARIANT_RING	8
+
+#ifdef NEARDAL_TRACES
+	#define NEARDAL_LOG_DEFAULT	NEARDAL_LOG_DEBUG
+#else
+	#define NEARDAL_LOG_DEFAULT	NEARDAL_LOG_INFO
+#endif
+
+/* Set to NEARDAL_LOG_DEFAULT when the library is loaded */
+unsigned char neardal_log_levels[NEARDAL_LOG_CAT_COUNT];
+
+static const char * const neardal_log_cat_names[NEARDAL_LOG_CAT_COUNT] = {
+	[NEARDAL_LOG_CAT_CORE]		= "core",
+	[NEARDAL_LOG_CAT_MANAGER]	= "manager",
+	[NEARDAL_LOG_CAT_ADAPTER]	= "adapter",
+	[NEARDAL_LOG_CAT_TAG]		= "tag",
+	[NEARDAL_LOG_CAT_DEVICE]	= "device",
+	[NEARDAL_LOG_CAT_RECORD]	= "record",
+	[NEARDAL_LOG_CAT_AGENT]		= "agent"
+};
+
+static const char * const neardal_log_level_names[] = {
+	[NEARDAL_LOG_NONE]	= "none",
+	[NEARDAL_LOG_ERROR]	= "error",
+	[NEARDAL_LOG_INFO]	= "info",
+	[NEARDAL_LOG_DEBUG]	= "debug"
+};
 
 int (*neardal_output_cb)(FILE *fp, const char *fmt, va_list ap) = vfprintf;
 
 void neardal_trace(const char *func, FILE *fp, char *fmt, ...)
 {
-int dummy;
-
-	va_list ap;
-	char *f = fmt;
-	if (func)
-		dummy = asprintf(&f, "%s(): %s", func, fmt);
+	va_list	ap;
+	char	buf[TRACE_FMT_LEN];
+	char	*f = fmt;
+	int	len;
+
+	if (func) {
+		len = snprintf(buf, sizeof(buf), "%s(): %s", func, fmt);
+		if (len >= 0 && (size_t) len < sizeof(buf))
+			f = buf;
+		else
+			f = g_strconcat(func, "(): ", fmt, NULL);
+	}
 	va_start(ap, fmt);
 	neardal_output_cb(fp, f, ap);
 	va_end(ap);
-	if (f != fmt)
-		free(f);
+	if (f != fmt && f != buf)
+		g_free(f);
 }
 
-static void neardal_prv_dump_data_as_binary_format(char *bufToReadP,
-						    int remainingSize,
-						    GString *bufDestP,
-						    int nbColumn)
+const char *neardal_trace_variant(GVariant *v)
 {
-	int offset = 0;
+	static __thread char		*ring[TRACE_VARIANT_RING];
+	static __thread unsigned int	pos;
 
-	while (offset < nbColumn && offset < remainingSize) {
-		g_string_append_printf(bufDestP, "%02hhX ", bufToReadP[offset]);
-		offset++;
-	}
-	/* Adding space to align ascii format */
-	if (offset < nbColumn) {
-		/* 3 space because each byte in binary format as 2 digit and
-		1 space */
-		remainingSize = (nbColumn - offset) * 3;
-		offset = 0;
-		while ((offset++) < remainingSize)
-			g_string_append_c(bufDestP, ' ');
-	}
+	pos = (pos + 1) % TRACE_VARIANT_RING;
+	g_free(ring[pos]);
+	ring[pos] = v ? g_variant_print(v, TRUE) : g_strdup("(null)");
+
+	return ring[pos];
 }
 
-static void neardal_prv_dump_data_as_ascii_format(char *bufToReadP,
-					      int remainingSize,
-					      GString *bufDestP, int nbColumn)
+/*****************************************************************************
+ * neardal_log_prv_lookup: Index of a name in a table, -1 if not found
+ ****************************************************************************/
+static int neardal_log_prv_lookup(const char * const *names, int nb,
+				  const char *name, size_t len)
 {
-	int		offset = 0;
+	int i;
+
+	for (i = 0; i < nb; i++)
+		if (strlen(names[i]) == len && !strncmp(names[i], name, len))
+			return i;
+
+	return -1;
+}
 
-	while (offset < nbColumn && offset < remainingSize) {
-		if (g_ascii_isprint(((unsigned char) bufToReadP[offset])))
-			g_string_append_c(bufDestP,
-					  ((unsigned char) bufToReadP[offset]));
+/*****************************************************************************
+ * neardal_log_prv_parse: Parse a NEARDAL_LOG like specification into
+ * 'levels', returns FALSE on a syntax error
+ ****************************************************************************/
+static gboolean neardal_log_prv_parse(const char *spec, unsigned char *levels)
+{
+	const char * const	*cats = neardal_log_cat_names;
+	const char * const	*levelNames = neardal_log_level_names;
+	const char		*item = spec, *end, *eq;
+	int			cat, level;
+
+	while (*item != '\0') {
+		end = strchr(item, ',');
+		if (end == NULL)
+			end = item + strlen(item);
+		eq = memchr(item, '=', end - item);
+
+		cat = NEARDAL_LOG_CAT_ALL;
+		if (eq != NULL) {
+			if (eq - item != 1 || *item != '*')
+				cat = neardal_log_prv_lookup(cats,
+						NEARDAL_LOG_CAT_COUNT, item,
+						eq - item);
+			if (cat < 0)
+				return FALSE;
+			item = eq + 1;
+		}
+		level = neardal_log_prv_lookup(levelNames,
+					       NEARDAL_LOG_DEBUG + 1,
+					       item, end - item);
+		if (level < 0)
+			return FALSE;
+
+		if (cat == NEARDAL_LOG_CAT_ALL)
+			memset(levels, level, NEARDAL_LOG_CAT_COUNT);
 		else
-			g_string_append_c(bufDestP, '.');
-		offset++;
-	}
-	/* Adding space to finish ascii column */
- 	if (offset < nbColumn) {
-		remainingSize = nbColumn - offset;
-		offset = 0;
-		while ((offset++) < remainingSize)
-			g_string_append_c(bufDestP, '.');
+			levels[cat] = level;
+
+		item = (*end == ',') ? end + 1 : end;
 	}
+
+	return TRUE;
 }
 
+errorCode_t neardal_log_configure(const char *spec)
+{
+	unsigned char levels[NEARDAL_LOG_CAT_COUNT];
+
+	if (spec == NULL)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	memcpy(levels, neardal_log_levels, sizeof(levels));
+	if (!neardal_log_prv_parse(spec, levels))
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+	memcpy(neardal_log_levels, levels, sizeof(levels));
+
+	return NEARDAL_SUCCESS;
+}
+
+errorCode_t neardal_log_set_level(neardal_log_category category,
+				  neardal_log_level level)
+{
+	if ((unsigned) category > NEARDAL_LOG_CAT_ALL ||
+	    (unsigned) level > NEARDAL_LOG_DEBUG)
+		return NEARDAL_ERROR_INVALID_PARAMETER;
+
+	if (category == NEARDAL_LOG_CAT_ALL)
+		memset(neardal_log_levels, level, NEARDAL_LOG_CAT_COUNT);
+	else
+		neardal_log_levels[category] = level;
+
+	return NEARDAL_SUCCESS;
+}
+
+neardal_log_level neardal_log_get_level(neardal_log_category category)
+{
+	if ((unsigned) category >= NEARDAL_LOG_CAT_COUNT)
+		return NEARDAL_LOG_NONE;
+
+	return neardal_log_levels[category];
+}
+
+/*****************************************************************************
+ * neardal_log_prv_init: Set default levels then apply the NEARDAL_LOG
+ * environment variable when the library is loaded
+ ****************************************************************************/
+static void __attribute__((constructor)) neardal_log_prv_init(void)
+{
+	const char *spec = getenv("NEARDAL_LOG");
+
+	memset(neardal_log_levels, NEARDAL_LOG_DEFAULT,
+	       sizeof(neardal_log_levels));
+	if (spec != NULL && neardal_log_configure(spec) != NEARDAL_SUCCESS)
+		fprintf(stderr, "neardal: invalid NEARDAL_LOG '%s'\n", spec);
+}
+
+/*****************************************************************************
+ * neardal_trace_prv_dump_line: Format one line of a memory dump: address,
+ * up to NB_COLUMN bytes in hexadecimal then as ascii ('.' if not printable)
+ ****************************************************************************/
+static void neardal_trace_prv_dump_line(const unsigned char *data, int len,
+					char *line)
+{
+	static const char	hex[] = "0123456789ABCDEF";
+	char			*p;
+	int			i;
+
+	p = line + sprintf(line, "%08lX : ", (unsigned long) data);
+	for (i = 0; i < NB_COLUMN; i++) {
+		if (i < len) {
+			*p++ = hex[data[i] >> 4];
+			*p++ = hex[data[i] & 0x0F];
+		} else {
+			*p++ = ' ';
+			*p++ = ' ';
+		}
+		*p++ = ' ';
+	}
+	for (i = 0; i < NB_COLUMN; i++)
+		*p++ = (i < len && g_ascii_isprint(data[i])) ? data[i] : '.';
+	*p = '\0';
+}
 
-void neardal_trace_prv_dump_mem(char *bufToReadP, int size)
+void neardal_trace_dump_mem(char *bufToReadP, int size)
 {
-	char	*memP = bufToReadP;
-	int		len = size;
-	int		offset = 0;
-	GString *bufTrace;
+	const unsigned char	*data = (const unsigned char *) bufToReadP;
+	char			line[DUMP_LINE_LEN];
+	int			offset;
 
-	if (!memP || size <= 0)
+	if (!data || size <= 0)
 		return;
 
-	offset	= 0;
-
-	bufTrace = g_string_new(NULL);
-	while (len > 0) {
-		g_string_append_printf(bufTrace, "%08lX : ",
-				       (unsigned long) (&bufToReadP[offset]));
-		neardal_prv_dump_data_as_binary_format(&bufToReadP[offset],
-							len, bufTrace,
-							NB_COLUMN);
-		neardal_prv_dump_data_as_ascii_format(&bufToReadP[offset],
-						       len, bufTrace,
-						       NB_COLUMN);
-		NEARDAL_TRACE("%s\n", bufTrace->str);
-		len		-= NB_COLUMN;
-		offset	+= NB_COLUMN;
-		g_string_truncate(bufTrace, 0);
+	for (offset = 0; offset < size; offset += NB_COLUMN) {
+		neardal_trace_prv_dump_line(data + offset, size - offset, line);
+		neardal_trace(NULL, stdout, "%s\n", line);
 	}
-	g_string_free(bufTrace, TRUE);
 }
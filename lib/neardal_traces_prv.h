@@ -21,27 +21,113 @@
 #ifndef NEARDAL_TRACES_PRV_H
 #define NEARDAL_TRACES_PRV_H
 
-/* a debug output macro */
-#ifdef NEARDAL_TRACES
-	#define NEARDAL_TRACE(...)	neardal_trace(NULL, stdout, __VA_ARGS__)
-	#define NEARDAL_TRACEDUMP(...)	neardal_trace_dump_mem(__VA_ARGS__)
-
-	/* Macro including function name before traces */
-	#define NEARDAL_TRACEF(...)	neardal_trace(__func__, stdout, \
-							__VA_ARGS__)
-	#define NEARDAL_TRACEIN()	neardal_trace(__func__, stdout, \
-							"Processing...\n")
-#else
-	#define NEARDAL_TRACE(...)
-	#define NEARDAL_TRACEDUMP(...)
-	#define NEARDAL_TRACEF(...)
-	#define NEARDAL_TRACEIN(...)
-#endif /* NEARDAL_DEBUG */
-/* always defined */
-#define NEARDAL_TRACE_LOG(...)	neardal_trace(__func__, stdout,	__VA_ARGS__)
-#define NEARDAL_TRACE_ERR(...)	neardal_trace(__func__, stderr, \
-						"Error: " __VA_ARGS__)
+#include <stdint.h>
+
+/*
+ * Log category of the messages of a source file, to be defined before
+ * including this header
+ */
+#ifndef NEARDAL_LOG_CATEGORY
+	#define NEARDAL_LOG_CATEGORY	NEARDAL_LOG_CAT_CORE
+#endif
+
+/* Current level of each category (see neardal_log_level) */
+extern unsigned char neardal_log_levels[];
+
+/*
+ * Single test on a global before any argument is evaluated, disabled
+ * messages cost one predicted branch
+ */
+#define NEARDAL_LOG_ENABLED(_level)					\
+	__builtin_expect(neardal_log_levels[NEARDAL_LOG_CATEGORY] >=	\
+			 (_level), 0)
+
+#define NEARDAL_LOG(_level, _func, _fp, ...)				\
+	do {								\
+		if (NEARDAL_LOG_ENABLED(_level))			\
+			neardal_trace(_func, _fp, __VA_ARGS__);		\
+	} while (0)
+
+/*
+ * Debug output, compiled in whatever the build, filtered at runtime like the
+ * other levels (--enable-trace only makes it the default level)
+ */
+#define NEARDAL_TRACE(...)	NEARDAL_LOG(NEARDAL_LOG_DEBUG, NULL, stdout, \
+					    __VA_ARGS__)
+#define NEARDAL_TRACEDUMP(...)						\
+	do {								\
+		if (NEARDAL_LOG_ENABLED(NEARDAL_LOG_DEBUG))		\
+			neardal_trace_dump_mem(__VA_ARGS__);		\
+	} while (0)
+
+/* Macro including function name before traces */
+#define NEARDAL_TRACEF(...)	NEARDAL_LOG(NEARDAL_LOG_DEBUG, __func__, \
+					    stdout, __VA_ARGS__)
+#define NEARDAL_TRACEIN()	NEARDAL_LOG(NEARDAL_LOG_DEBUG, __func__, \
+					    stdout, "Processing...\n")
+
+#define NEARDAL_TRACE_LOG(...)	NEARDAL_LOG(NEARDAL_LOG_INFO, __func__, \
+					    stdout, __VA_ARGS__)
+#define NEARDAL_TRACE_ERR(...)	NEARDAL_LOG(NEARDAL_LOG_ERROR, __func__, \
+					    stderr, "Error: " __VA_ARGS__)
 
 void neardal_trace_dump_mem(char *dataP, int size);
 
+/* Binary trace is on (see neardal_trace_ring.h) */
+extern int neardal_trace_ring_on;
+
+void neardal_trace_ring_prv_add(unsigned int event, const char *object,
+				int64_t arg0, int64_t arg1);
+
+/* Record a binary trace event, arguments are only evaluated if tracing */
+#define NEARDAL_TRACE_EVENT(_ev, _obj, _arg0, _arg1)			\
+	do {								\
+		if (__builtin_expect(neardal_trace_ring_on, 0))		\
+			neardal_trace_ring_prv_add(_ev, _obj, _arg0,	\
+						   _arg1);		\
+	} while (0)
+
+/* Timeline is recorded (see neardal_timeline.h) */
+extern int neardal_timeline_on;
+
+void neardal_timeline_prv_span(const char *name, const char *path,
+			       guint64 start, guint64 end);
+void neardal_timeline_prv_signal(const char *member, const char *path,
+				 guint64 start);
+void neardal_timeline_prv_callbacks(unsigned int kind, const char *path,
+				    guint64 start);
+void neardal_timeline_prv_tag(const char *tag, gboolean found);
+
+#define NEARDAL_TIMELINE_CALL(_call)					\
+	do {								\
+		if (__builtin_expect(neardal_timeline_on, 0))		\
+			_call;						\
+	} while (0)
+
+/* Start time of a timeline span, 0 if not recording */
+#define NEARDAL_TIMELINE_NOW()						\
+	(__builtin_expect(neardal_timeline_on, 0) ? neardal_stats_now() : 0)
+
+/* Span of a call, started at '_start' */
+#define NEARDAL_TIMELINE_SPAN(_name, _path, _start)			\
+	NEARDAL_TIMELINE_CALL(neardal_timeline_prv_span(_name, _path,	\
+					_start, neardal_stats_now()))
+/* Span of a signal, from its arrival (or '_start') to now */
+#define NEARDAL_TIMELINE_SIGNAL(_member, _path, _start)			\
+	NEARDAL_TIMELINE_CALL(neardal_timeline_prv_signal(_member,	\
+							  _path, _start))
+/* Callbacks of an event, started at '_start' */
+#define NEARDAL_TIMELINE_CALLBACKS(_kind, _path, _start)		\
+	NEARDAL_TIMELINE_CALL(neardal_timeline_prv_callbacks(_kind,	\
+							     _path, _start))
+/* Tag lifetime begins ('_found' TRUE) or ends */
+#define NEARDAL_TIMELINE_TAG(_tag, _found)				\
+	NEARDAL_TIMELINE_CALL(neardal_timeline_prv_tag(_tag, _found))
+
+/*
+ * Text form of a GVariant for a trace argument. The string is owned by a
+ * small per thread ring, and stays valid for the next few calls
+ */
+const char *neardal_trace_variant(GVariant *v);
+
 #endif	/* NEARDAL_TRACES_PRV_H */
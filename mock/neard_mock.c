@@ -0,0 +1,606 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Neard stand-in for tests and benchmarks without NFC hardware. It owns
+ * org.neard (on the session bus unless --system), exposes N adapters and
+ * makes tags and devices appear and disappear at a given rate:
+ *	neard_mock --adapters=2 --tag-rate=10 --write-latency=20
+ * Clients select the session bus with NEARDAL_BUS=session, run-mock.sh
+ * wraps both around a private dbus-daemon.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib-unix.h>
+#include <gio/gio.h>
+
+#include "neard_mock_manager.h"
+#include "neard_mock_objects.h"
+
+#define MOCK_NAME		"org.neard"
+#define MOCK_ROOT		"/"
+#define MOCK_ADP_PREFIX		"/org/neard/nfc"
+#define MOCK_ERROR_FAILED	"org.neard.Error.Failed"
+
+typedef struct {
+	gchar		*path;
+	MockAdapter	*iface;
+	guint		tagSeq;
+	guint		devSeq;
+} Adapter;
+
+/* A tag or a device in the field, with its records */
+typedef struct {
+	Adapter		*adp;
+	gchar		*path;
+	gboolean	isTag;
+	guint		nbRecords;
+} Target;
+
+typedef struct {
+	GDBusMethodInvocation	*inv;
+	GVariant		*reply;
+	gboolean		failed;
+} Reply;
+
+/* Command line */
+static gint		optAdapters	= 1;
+static gdouble		optTagRate;
+static gdouble		optDevRate;
+static gdouble		optPropRate;
+static gint		optHold		= 500;
+static gint		optTags;
+static gint		optRecords	= 1;
+static gchar		*optRecordType;
+static gint		optPayloadLen;
+static gint		optWriteLatency;
+static gint		optPushLatency;
+static gint		optPollLatency;
+static gint		optFailRate;
+static gint		optDuration;
+static gboolean		optSystem;
+static gboolean		optLegacySignals;
+
+static GOptionEntry options[] = {
+	{ "adapters", 'a', 0, G_OPTION_ARG_INT, &optAdapters,
+	  "Number of adapters (1)", "N" },
+	{ "tag-rate", 't', 0, G_OPTION_ARG_DOUBLE, &optTagRate,
+	  "Tags found per second and adapter (0: none)", "HZ" },
+	{ "device-rate", 'd', 0, G_OPTION_ARG_DOUBLE, &optDevRate,
+	  "Devices found per second and adapter (0: none)", "HZ" },
+	{ "prop-rate", 'p', 0, G_OPTION_ARG_DOUBLE, &optPropRate,
+	  "Adapter 'Polling' changes per second (0: none)", "HZ" },
+	{ "hold", 'H', 0, G_OPTION_ARG_INT, &optHold,
+	  "Time a tag or device stays in the field (500 ms)", "MS" },
+	{ "tags", 'n', 0, G_OPTION_ARG_INT, &optTags,
+	  "Stop after N tags per adapter (0: never)", "N" },
+	{ "records", 'r', 0, G_OPTION_ARG_INT, &optRecords,
+	  "Records per tag (1)", "N" },
+	{ "record-type", 'T', 0, G_OPTION_ARG_STRING, &optRecordType,
+	  "URI, Text, SmartPoster or MIME (URI)", "TYPE" },
+	{ "payload-len", 'l', 0, G_OPTION_ARG_INT, &optPayloadLen,
+	  "Length of the URI, text or MIME payload", "BYTES" },
+	{ "write-latency", 'w', 0, G_OPTION_ARG_INT, &optWriteLatency,
+	  "Tag.Write reply delay", "MS" },
+	{ "push-latency", 'P', 0, G_OPTION_ARG_INT, &optPushLatency,
+	  "Device.Push reply delay", "MS" },
+	{ "poll-latency", 'L', 0, G_OPTION_ARG_INT, &optPollLatency,
+	  "Adapter.StartPollLoop reply delay", "MS" },
+	{ "fail-rate", 'f', 0, G_OPTION_ARG_INT, &optFailRate,
+	  "Percentage of Write and Push calls failing", "PERCENT" },
+	{ "duration", 'D', 0, G_OPTION_ARG_INT, &optDuration,
+	  "Exit after SECONDS (0: on SIGINT/SIGTERM)", "SECONDS" },
+	{ "system", 's', 0, G_OPTION_ARG_NONE, &optSystem,
+	  "Own org.neard on the system bus", NULL },
+	{ "legacy-signals", 0, 0, G_OPTION_ARG_NONE, &optLegacySignals,
+	  "Also emit Adapter TagFound/TagLost (neardal registers tags twice)",
+	  NULL },
+	{ NULL }
+};
+
+static GMainLoop		*loop;
+static GDBusObjectManagerServer	*server;
+static MockManager		*manager;
+static Adapter			*adapters;
+static gchar			*payload;
+
+/* Statistics, printed on exit */
+static guint	nbTags, nbDevices, nbWrites, nbPushes, nbFailures;
+
+/*****************************************************************************
+ * reply_cb: send a delayed method reply
+ ****************************************************************************/
+static gboolean reply_cb(gpointer data)
+{
+	Reply *r = data;
+
+	if (r->failed)
+		g_dbus_method_invocation_return_dbus_error(r->inv,
+							   MOCK_ERROR_FAILED,
+							   "Simulated failure");
+	else
+		g_dbus_method_invocation_return_value(r->inv, r->reply);
+	g_free(r);
+
+	return G_SOURCE_REMOVE;
+}
+
+/*****************************************************************************
+ * reply_later: reply 'reply' (NULL: no out argument) to 'inv' after 'ms',
+ * or fail it with a --fail-rate chance if 'mayFail'
+ ****************************************************************************/
+static void reply_later(GDBusMethodInvocation *inv, GVariant *reply, gint ms,
+			gboolean mayFail)
+{
+	Reply *r = g_new0(Reply, 1);
+
+	r->inv = inv;
+	r->reply = reply;
+	r->failed = mayFail && g_random_int_range(0, 100) < optFailRate;
+	if (r->failed)
+		nbFailures++;
+	if (ms > 0)
+		g_timeout_add(ms, reply_cb, r);
+	else
+		reply_cb(r);
+}
+
+/*****************************************************************************
+ * interval_ms: period of a 'hz' rate, 0 if disabled
+ ****************************************************************************/
+static guint interval_ms(gdouble hz)
+{
+	if (hz <= 0)
+		return 0;
+	return MAX(1, (guint) (1000 / hz));
+}
+
+/*---------------------------------------------------------------------------
+ * Method handlers
+ ---------------------------------------------------------------------------*/
+static gboolean on_get_properties(MockManager *mgr, GDBusMethodInvocation *inv,
+				  gpointer data)
+{
+	GVariantBuilder	props, paths;
+	gint		i;
+
+	(void) mgr;
+	(void) data;
+	g_variant_builder_init(&paths, G_VARIANT_TYPE("ao"));
+	for (i = 0; i < optAdapters; i++)
+		g_variant_builder_add(&paths, "o", adapters[i].path);
+	g_variant_builder_init(&props, G_VARIANT_TYPE("a{sv}"));
+	g_variant_builder_add(&props, "{sv}", "Adapters",
+			      g_variant_builder_end(&paths));
+	g_dbus_method_invocation_return_value(inv,
+				g_variant_new("(a{sv})", &props));
+
+	return TRUE;
+}
+
+/* SetProperty and the agents (un)registration: accepted, nothing else */
+static gboolean on_accept(MockManager *mgr, GDBusMethodInvocation *inv,
+			  gpointer data)
+{
+	(void) mgr;
+	(void) data;
+	g_dbus_method_invocation_return_value(inv, NULL);
+
+	return TRUE;
+}
+
+static gboolean on_start_poll_loop(MockAdapter *iface,
+				   GDBusMethodInvocation *inv,
+				   const gchar *mode, gpointer data)
+{
+	(void) data;
+	mock_adapter_set_mode(iface, mode);
+	mock_adapter_set_polling(iface, TRUE);
+	reply_later(inv, NULL, optPollLatency, FALSE);
+
+	return TRUE;
+}
+
+static gboolean on_stop_poll_loop(MockAdapter *iface,
+				  GDBusMethodInvocation *inv, gpointer data)
+{
+	(void) data;
+	mock_adapter_set_polling(iface, FALSE);
+	mock_adapter_set_mode(iface, "Idle");
+	g_dbus_method_invocation_return_value(inv, NULL);
+
+	return TRUE;
+}
+
+static gboolean on_write(MockTag *iface, GDBusMethodInvocation *inv,
+			 GVariant *attributes, gpointer data)
+{
+	(void) iface;
+	(void) attributes;
+	(void) data;
+	nbWrites++;
+	reply_later(inv, NULL, optWriteLatency, TRUE);
+
+	return TRUE;
+}
+
+static gboolean on_get_raw_ndef(MockTag *iface, GDBusMethodInvocation *inv,
+				gpointer data)
+{
+	(void) iface;
+	(void) data;
+	g_dbus_method_invocation_return_value(inv, g_variant_new("(@ay)",
+		g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, NULL, 0, 1)));
+
+	return TRUE;
+}
+
+static gboolean on_push(MockDevice *iface, GDBusMethodInvocation *inv,
+			GVariant *attributes, gpointer data)
+{
+	(void) iface;
+	(void) attributes;
+	(void) data;
+	nbPushes++;
+	reply_later(inv, NULL, optPushLatency, TRUE);
+
+	return TRUE;
+}
+
+/*---------------------------------------------------------------------------
+ * Objects
+ ---------------------------------------------------------------------------*/
+/*****************************************************************************
+ * record_export: export record 'idx' of the tag 'parent', payload built
+ * from --record-type and --payload-len
+ ****************************************************************************/
+static void record_export(const gchar *parent, guint idx)
+{
+	MockObjectSkeleton	*obj;
+	MockRecord		*rcd;
+	gchar			*path;
+
+	path = g_strdup_printf("%s/record%u", parent, idx);
+	obj = mock_object_skeleton_new(path);
+	rcd = mock_record_skeleton_new();
+
+	mock_record_set_type_(rcd, optRecordType);
+	mock_record_set_size(rcd, strlen(payload));
+	if (!strcmp(optRecordType, "MIME")) {
+		mock_record_set_mime(rcd, "text/plain");
+	} else {
+		if (strcmp(optRecordType, "Text") != 0)
+			mock_record_set_uri(rcd, payload);
+		if (strcmp(optRecordType, "URI") != 0) {
+			mock_record_set_encoding(rcd, "UTF-8");
+			mock_record_set_language(rcd, "en");
+			mock_record_set_representation(rcd, payload);
+		}
+	}
+
+	mock_object_skeleton_set_record(obj, rcd);
+	g_dbus_object_manager_server_export(server,
+					    G_DBUS_OBJECT_SKELETON(obj));
+	g_object_unref(rcd);
+	g_object_unref(obj);
+	g_free(path);
+}
+
+/*****************************************************************************
+ * target_leave: the tag or device leaves the field, its records first
+ ****************************************************************************/
+static gboolean target_leave(gpointer data)
+{
+	Target	*target = data;
+	gchar	*path;
+	guint	i;
+
+	for (i = 0; i < target->nbRecords; i++) {
+		path = g_strdup_printf("%s/record%u", target->path, i);
+		g_dbus_object_manager_server_unexport(server, path);
+		g_free(path);
+	}
+	g_dbus_object_manager_server_unexport(server, target->path);
+	if (target->isTag && optLegacySignals)
+		mock_adapter_emit_tag_lost(target->adp->iface, target->path);
+
+	g_free(target->path);
+	g_free(target);
+
+	return G_SOURCE_REMOVE;
+}
+
+/*****************************************************************************
+ * tag_arrive: a new tag enters the field of adapter 'data', InterfacesAdded
+ * for the tag then each record, TagFound with --legacy-signals
+ ****************************************************************************/
+static gboolean tag_arrive(gpointer data)
+{
+	Adapter			*adp = data;
+	Target			*target;
+	MockObjectSkeleton	*obj;
+	MockTag			*tag;
+	guint			i;
+
+	if (optTags > 0 && adp->tagSeq >= (guint) optTags)
+		return G_SOURCE_REMOVE;
+
+	target = g_new0(Target, 1);
+	target->adp = adp;
+	target->path = g_strdup_printf("%s/tag%u", adp->path, adp->tagSeq++);
+	target->isTag = TRUE;
+	target->nbRecords = optRecords;
+
+	obj = mock_object_skeleton_new(target->path);
+	tag = mock_tag_skeleton_new();
+	mock_tag_set_type_(tag, "Type 2");
+	mock_tag_set_protocol(tag, "MIFARE");
+	mock_tag_set_read_only(tag, FALSE);
+	mock_tag_set_adapter(tag, adp->path);
+	g_signal_connect(tag, "handle-write", G_CALLBACK(on_write), NULL);
+	g_signal_connect(tag, "handle-get-raw-ndef",
+			 G_CALLBACK(on_get_raw_ndef), NULL);
+	mock_object_skeleton_set_tag(obj, tag);
+	g_dbus_object_manager_server_export(server,
+					    G_DBUS_OBJECT_SKELETON(obj));
+	g_object_unref(tag);
+	g_object_unref(obj);
+
+	for (i = 0; i < target->nbRecords; i++)
+		record_export(target->path, i);
+
+	if (optLegacySignals)
+		mock_adapter_emit_tag_found(adp->iface, target->path);
+	nbTags++;
+	g_timeout_add(optHold, target_leave, target);
+
+	return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************
+ * device_arrive: a new peer device enters the field of adapter 'data'
+ ****************************************************************************/
+static gboolean device_arrive(gpointer data)
+{
+	Adapter			*adp = data;
+	Target			*target;
+	MockObjectSkeleton	*obj;
+	MockDevice		*dev;
+
+	target = g_new0(Target, 1);
+	target->adp = adp;
+	target->path = g_strdup_printf("%s/device%u", adp->path,
+				       adp->devSeq++);
+
+	obj = mock_object_skeleton_new(target->path);
+	dev = mock_device_skeleton_new();
+	mock_device_set_adapter(dev, adp->path);
+	g_signal_connect(dev, "handle-push", G_CALLBACK(on_push), NULL);
+	mock_object_skeleton_set_device(obj, dev);
+	g_dbus_object_manager_server_export(server,
+					    G_DBUS_OBJECT_SKELETON(obj));
+	g_object_unref(dev);
+	g_object_unref(obj);
+
+	nbDevices++;
+	g_timeout_add(optHold, target_leave, target);
+
+	return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************
+ * prop_toggle: flip 'Polling', PropertiesChanged is sent by the skeleton
+ ****************************************************************************/
+static gboolean prop_toggle(gpointer data)
+{
+	Adapter *adp = data;
+
+	mock_adapter_set_polling(adp->iface,
+				 !mock_adapter_get_polling(adp->iface));
+
+	return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************
+ * adapters_export: export the adapters objects, before owning the name so
+ * that the first GetManagedObjects sees them
+ ****************************************************************************/
+static void adapters_export(void)
+{
+	static const gchar * const protocols[] = { "Felica", "MIFARE", "Jewel",
+						   "ISO-DEP", "NFC-DEP",
+						   NULL };
+	MockObjectSkeleton	*obj;
+	Adapter			*adp;
+	gint			i;
+
+	adapters = g_new0(Adapter, optAdapters);
+	for (i = 0; i < optAdapters; i++) {
+		adp = &adapters[i];
+		adp->path = g_strdup_printf(MOCK_ADP_PREFIX "%d", i);
+		adp->iface = mock_adapter_skeleton_new();
+		mock_adapter_set_mode(adp->iface, "Idle");
+		mock_adapter_set_powered(adp->iface, TRUE);
+		mock_adapter_set_polling(adp->iface, FALSE);
+		mock_adapter_set_protocols(adp->iface, protocols);
+		g_signal_connect(adp->iface, "handle-start-poll-loop",
+				 G_CALLBACK(on_start_poll_loop), NULL);
+		g_signal_connect(adp->iface, "handle-stop-poll-loop",
+				 G_CALLBACK(on_stop_poll_loop), NULL);
+
+		obj = mock_object_skeleton_new(adp->path);
+		mock_object_skeleton_set_adapter(obj, adp->iface);
+		g_dbus_object_manager_server_export(server,
+					G_DBUS_OBJECT_SKELETON(obj));
+		g_object_unref(obj);
+	}
+}
+
+/*****************************************************************************
+ * activity_start: start the tags, devices and properties timers
+ ****************************************************************************/
+static void activity_start(void)
+{
+	Adapter	*adp;
+	guint	ms;
+	gint	i;
+
+	for (i = 0; i < optAdapters; i++) {
+		adp = &adapters[i];
+		ms = interval_ms(optTagRate);
+		if (ms > 0)
+			g_timeout_add(ms, tag_arrive, adp);
+		ms = interval_ms(optDevRate);
+		if (ms > 0)
+			g_timeout_add(ms, device_arrive, adp);
+		ms = interval_ms(optPropRate);
+		if (ms > 0)
+			g_timeout_add(ms, prop_toggle, adp);
+	}
+}
+
+/*---------------------------------------------------------------------------
+ * Bus name
+ ---------------------------------------------------------------------------*/
+static void on_bus_acquired(GDBusConnection *conn, const gchar *name,
+			    gpointer data)
+{
+	GError *error = NULL;
+
+	(void) name;
+	(void) data;
+	manager = mock_manager_skeleton_new();
+	g_signal_connect(manager, "handle-get-properties",
+			 G_CALLBACK(on_get_properties), NULL);
+	g_signal_connect(manager, "handle-set-property",
+			 G_CALLBACK(on_accept), NULL);
+	g_signal_connect(manager, "handle-register-ndefagent",
+			 G_CALLBACK(on_accept), NULL);
+	g_signal_connect(manager, "handle-unregister-ndefagent",
+			 G_CALLBACK(on_accept), NULL);
+	g_signal_connect(manager, "handle-register-handover-agent",
+			 G_CALLBACK(on_accept), NULL);
+	g_signal_connect(manager, "handle-unregister-handover-agent",
+			 G_CALLBACK(on_accept), NULL);
+	if (!g_dbus_interface_skeleton_export(
+			G_DBUS_INTERFACE_SKELETON(manager), conn, MOCK_ROOT,
+			&error)) {
+		g_printerr("neard_mock: %s\n", error->message);
+		g_error_free(error);
+		g_main_loop_quit(loop);
+		return;
+	}
+
+	server = g_dbus_object_manager_server_new(MOCK_ROOT);
+	adapters_export();
+	g_dbus_object_manager_server_set_connection(server, conn);
+}
+
+static void on_name_acquired(GDBusConnection *conn, const gchar *name,
+			     gpointer data)
+{
+	(void) conn;
+	(void) data;
+	activity_start();
+	printf("neard_mock: %s ready, %d adapter(s)\n", name, optAdapters);
+	fflush(stdout);
+}
+
+static void on_name_lost(GDBusConnection *conn, const gchar *name,
+			 gpointer data)
+{
+	(void) data;
+	g_printerr("neard_mock: %s: %s\n", name, conn == NULL ?
+		   "unable to connect to the bus" : "already owned");
+	g_main_loop_quit(loop);
+}
+
+static gboolean on_quit(gpointer data)
+{
+	(void) data;
+	g_main_loop_quit(loop);
+
+	return G_SOURCE_REMOVE;
+}
+
+int main(int argc, char *argv[])
+{
+	GOptionContext	*context;
+	GError		*error = NULL;
+	guint		ownerId;
+
+	context = g_option_context_new("- Neard daemon simulator");
+	g_option_context_add_main_entries(context, options, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("neard_mock: %s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+	g_option_context_free(context);
+
+	if (optRecordType == NULL)
+		optRecordType = g_strdup("URI");
+	if (strcmp(optRecordType, "URI") && strcmp(optRecordType, "Text") &&
+	    strcmp(optRecordType, "SmartPoster") &&
+	    strcmp(optRecordType, "MIME")) {
+		g_printerr("neard_mock: unknown record type '%s'\n",
+			   optRecordType);
+		return 1;
+	}
+	if (optAdapters < 1 || optHold < 0 || optRecords < 0) {
+		g_printerr("neard_mock: invalid argument\n");
+		return 1;
+	}
+
+	/* URIs keep a valid prefix, padded up to --payload-len */
+	payload = g_strdup(strcmp(optRecordType, "Text") ?
+			   "http://example.com/nfc" : "Hello from neard_mock");
+	if ((gint) strlen(payload) < optPayloadLen) {
+		gchar *p = g_strnfill(optPayloadLen, 'x');
+
+		memcpy(p, payload, strlen(payload));
+		g_free(payload);
+		payload = p;
+	}
+
+	loop = g_main_loop_new(NULL, FALSE);
+	g_unix_signal_add(SIGINT, on_quit, NULL);
+	g_unix_signal_add(SIGTERM, on_quit, NULL);
+	if (optDuration > 0)
+		g_timeout_add_seconds(optDuration, on_quit, NULL);
+
+	ownerId = g_bus_own_name(optSystem ? G_BUS_TYPE_SYSTEM :
+				 G_BUS_TYPE_SESSION, MOCK_NAME,
+				 G_BUS_NAME_OWNER_FLAGS_NONE, on_bus_acquired,
+				 on_name_acquired, on_name_lost, NULL, NULL);
+	g_main_loop_run(loop);
+	g_bus_unown_name(ownerId);
+
+	fprintf(stderr, "neard_mock: %u tags, %u devices, %u writes, "
+		"%u pushes, %u failures\n", nbTags, nbDevices, nbWrites,
+		nbPushes, nbFailures);
+
+	return 0;
+}
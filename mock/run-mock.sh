@@ -0,0 +1,54 @@
+#!/bin/sh
+#
+# Run a neardal client against neard_mock on a private session bus:
+#	run-mock.sh [neard_mock options] -- command [arguments]
+# e.g. run-mock.sh --adapters=2 --tag-rate=20 -- ../ncl/ncl
+# The exit status is the command one.
+
+MOCK=${NEARD_MOCK:-$(dirname "$0")/neard_mock}
+
+MOCK_ARGS=
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+	MOCK_ARGS="$MOCK_ARGS $1"
+	shift
+done
+if [ $# -lt 2 ]; then
+	echo "usage: $0 [neard_mock options] -- command [arguments]" >&2
+	exit 2
+fi
+shift
+
+TMP=$(mktemp -d) || exit 1
+dbus-daemon --session --fork --nopidfile --print-address=3 --print-pid=4 \
+	3>"$TMP/address" 4>"$TMP/pid" || exit 1
+DBUS_SESSION_BUS_ADDRESS=$(head -n 1 "$TMP/address")
+NEARDAL_BUS=session
+export DBUS_SESSION_BUS_ADDRESS NEARDAL_BUS
+
+cleanup() {
+	kill "$MOCK_PID" 2>/dev/null
+	wait "$MOCK_PID" 2>/dev/null
+	kill "$(cat "$TMP/pid")" 2>/dev/null
+	rm -rf "$TMP"
+}
+trap cleanup EXIT INT TERM
+
+# shellcheck disable=SC2086
+"$MOCK" $MOCK_ARGS &
+MOCK_PID=$!
+
+# Wait (5 s at most) for org.neard to be owned
+i=0
+until gdbus call --session --dest org.freedesktop.DBus \
+	--object-path /org/freedesktop/DBus \
+	--method org.freedesktop.DBus.NameHasOwner org.neard 2>/dev/null |
+	grep -q true; do
+	i=$((i + 1))
+	if [ $i -gt 50 ] || ! kill -0 "$MOCK_PID" 2>/dev/null; then
+		echo "$0: neard_mock did not start" >&2
+		exit 1
+	fi
+	sleep 0.1
+done
+
+"$@"
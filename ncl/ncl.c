@@ -246,31 +246,65 @@ static NCLError ncl_prv_init(void)
 	return ncl_cmd_init(NULL);
 }
 
+/* Execute a command, report its wall clock latency and dispatch the events
+ * it triggered */
+static NCLError ncl_prv_exec_timed(char *cmd)
+{
+	NCLError	err;
+	gint64		start;
+
+	start = g_get_monotonic_time();
+	err = ncl_exec(cmd);
+	NCL_CMD_PRINT("'%s': %s in %.3f ms\n", cmd, ncl_error_get_text(err),
+		      (g_get_monotonic_time() - start) / 1000.0);
+
+	while (g_main_context_pending(NULL))
+		g_main_context_iteration(NULL, FALSE);
+
+	return err;
+}
+
+/* Run a command file ('-' for stdin) up to the first error. Empty lines and
+ * lines starting with '#' are skipped */
 static void ncl_prv_parse_script_file(char *filename)
 {
 	char *line = NULL;
 	size_t len = 0;
-	FILE *file = fopen(filename, "r");
+	FILE *file;
+	guint nbCmds = 0;
+	gint64 start;
+
+	if (!strcmp(filename, "-"))
+		file = stdin;
+	else
+		file = fopen(filename, "r");
 
 	if (file == NULL) {
+		NCL_CMD_PRINTERR("Can't open '%s'\n", filename);
 		gNclCtx.errOnExit = NCLERR_GLOBAL_ERROR;
 		return;
 	}
 
+	start = g_get_monotonic_time();
 	while (getline(&line, &len, file) != -1) {
+		g_strstrip(line);
+		if (line[0] == '\0' || line[0] == '#')
+			continue;
 
 		NCL_CMD_PRINT("$$$$$$$$$$$$$$$$$$$$$$$$$'\n");
-		NCL_CMD_PRINT("Executing '%s'", line);
+		NCL_CMD_PRINT("Executing '%s'\n", line);
 		NCL_CMD_PRINT("$$$$$$$$$$$$$$$$$$$$$$$$$'\n");
 
-		if ((gNclCtx.errOnExit = ncl_exec(line)) != NCLERR_NOERROR)
+		nbCmds++;
+		if ((gNclCtx.errOnExit = ncl_prv_exec_timed(line))
+				!= NCLERR_NOERROR)
 			break;
-
-		while (g_main_context_pending(NULL))
-			g_main_context_iteration(NULL, FALSE);
 	}
+	NCL_CMD_PRINT("%u commands in %.3f ms\n", nbCmds,
+		      (g_get_monotonic_time() - start) / 1000.0);
 	g_free(line);
-	fclose(file);
+	if (file != stdin)
+		fclose(file);
 }
 
 static int ncl_trace(FILE *fp, const char *fmt, va_list ap)
@@ -290,22 +324,19 @@ int main(int argc, char *argv[])
 	GError *error = NULL;
 	char **opt_command = NULL;
 	char *opt_script = NULL;
-	gboolean opt_keep_running = FALSE, show_help = FALSE;
+	gboolean opt_keep_running = FALSE, show_help = FALSE, interactive;
 	GOptionEntry options[] = {
 		{ "exec", 'e', 0, G_OPTION_ARG_STRING_ARRAY, &opt_command,
 		  "Execute command", "command" },
 		{ "script", 's', 0, G_OPTION_ARG_STRING	, &opt_script,
 		  "Execute script", "filename" },
+		{ "file", 'f', 0, G_OPTION_ARG_STRING	, &opt_script,
+		  "Execute script ('-' for stdin)", "filename" },
 		{ "keep", 'k', 0, G_OPTION_ARG_NONE, &opt_keep_running,
 		  "Keep running after command/script execution" },
 		{ NULL }
 	};
 
-	neardal_output_cb = ncl_trace;
-	rl_callback_handler_install(NCL_PROMPT, ncl_parse_line);
-
-	NCL_CMD_PRINT("Compiled at %s : %s\n\n", __DATE__, __TIME__);
-
 	context = g_option_context_new(NULL);
 	g_option_context_add_main_entries(context, options, NULL);
 	if (g_option_context_parse(context, &argc, &argv, &error) == FALSE) {
@@ -315,31 +346,41 @@ int main(int argc, char *argv[])
 	}
 	g_option_context_free(context);
 
-	if ((err = ncl_prv_init()) != NCLERR_NOERROR)
-		goto exit;
-
 	if (!opt_script && !opt_command) {
 		opt_keep_running = TRUE;
 		show_help = TRUE;
 	}
 
+	/* Batch runs: plain output, no prompt. Stdin is the script if '-' */
+	interactive = opt_keep_running &&
+		      !(opt_script && !strcmp(opt_script, "-"));
+	if (interactive) {
+		neardal_output_cb = ncl_trace;
+		rl_callback_handler_install(NCL_PROMPT, ncl_parse_line);
+	}
+
+	NCL_CMD_PRINT("Compiled at %s : %s\n\n", __DATE__, __TIME__);
+
+	if ((err = ncl_prv_init()) != NCLERR_NOERROR)
+		goto exit;
+
 	if (opt_script)
 		ncl_prv_parse_script_file(opt_script);
 
 	while (opt_command) {
-		gNclCtx.errOnExit = ncl_exec(*opt_command);
-		while (g_main_context_pending(NULL))
-			g_main_context_iteration(NULL, FALSE);
+		gNclCtx.errOnExit = ncl_prv_exec_timed(*opt_command);
 		g_free(*opt_command++);
 		if (!*opt_command)
 			opt_command = NULL;
 	}
 
 	if (opt_keep_running) {
-		gNclCtx.channel = g_io_channel_unix_new(STDIN_FILENO);
-		gNclCtx.tag = g_io_add_watch(gNclCtx.channel, G_IO_IN,
+		if (interactive) {
+			gNclCtx.channel = g_io_channel_unix_new(STDIN_FILENO);
+			gNclCtx.tag = g_io_add_watch(gNclCtx.channel, G_IO_IN,
 					(GIOFunc) ncl_prv_kbinput_cb, &gNclCtx);
-		g_io_channel_unref(gNclCtx.channel);
+			g_io_channel_unref(gNclCtx.channel);
+		}
 
 		if (show_help)
 			ncl_exec(LISTCMD_NAME);
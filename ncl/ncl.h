@@ -49,6 +49,9 @@ NCLContext *ncl_get_ctx(void);
 /* Name of the command interpretor to display commands list */
 #define LISTCMD_NAME	"help"
 
+/* Execute one command line */
+NCLError ncl_exec(char *cmd);
+
 /* Display prompt */
 void ncl_prompt(void);
 void ncl_trace_dump_mem(char *bufToReadP, int size);
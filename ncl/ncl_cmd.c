@@ -281,6 +281,9 @@ static void ncl_cmd_cb_adapter_added(const char *adpName, void *user_data)
 	neardal_adapter	*adapter;
 
 	(void) user_data; /* Remove warning */
+	sNclCmdCtx.events[NEARDAL_EVENT_ADAPTER_ADDED]++;
+	if (sNclCmdCtx.quiet)
+		return;
 
 	NCL_CMD_PRINTF("NFC Adapter added '%s'\n", adpName);
 	ec = neardal_get_adapter_properties(adpName, &adapter);
@@ -298,6 +301,9 @@ static void ncl_cmd_cb_adapter_added(const char *adpName, void *user_data)
 static void ncl_cmd_cb_adapter_removed(const char *adpName, void *user_data)
 {
 	(void) user_data; /* remove warning */
+	sNclCmdCtx.events[NEARDAL_EVENT_ADAPTER_REMOVED]++;
+	if (sNclCmdCtx.quiet)
+		return;
 
 	NCL_CMD_PRINTF("NFC Adapter removed '%s'\n", adpName);
 }
@@ -308,6 +314,9 @@ static void ncl_cmd_cb_adapter_prop_changed(char *adpName, char *propName,
 	int		polling;
 
 	(void) user_data; /* remove warning */
+	sNclCmdCtx.events[NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED]++;
+	if (sNclCmdCtx.quiet)
+		return;
 
 	if (!strcmp(propName, "Polling")) {
 		polling = *(int*)&value;
@@ -325,6 +334,11 @@ static void ncl_cmd_cb_tag_found(const char *tagName, void *user_data)
 	errorCode_t	ec;
 
 	(void) user_data; /* remove warning */
+	sNclCmdCtx.events[NEARDAL_EVENT_TAG_FOUND]++;
+	g_free(sNclCmdCtx.lastTag);
+	sNclCmdCtx.lastTag = g_strdup(tagName);
+	if (sNclCmdCtx.quiet)
+		return;
 
 	NCL_CMD_PRINTF("NFC Tag found (%s)\n", tagName);
 
@@ -342,6 +356,9 @@ static void ncl_cmd_cb_tag_found(const char *tagName, void *user_data)
 static void ncl_cmd_cb_tag_lost(const char *tagName, void *user_data)
 {
 	(void) user_data; /* remove warning */
+	sNclCmdCtx.events[NEARDAL_EVENT_TAG_LOST]++;
+	if (sNclCmdCtx.quiet)
+		return;
 	NCL_CMD_PRINTF("NFC Tag lost (%s)\n", tagName);
 }
 
@@ -351,6 +368,9 @@ static void ncl_cmd_cb_dev_found(const char *devName, void *user_data)
 	errorCode_t	ec;
 
 	(void) user_data; /* remove warning */
+	sNclCmdCtx.events[NEARDAL_EVENT_DEV_FOUND]++;
+	if (sNclCmdCtx.quiet)
+		return;
 
 	NCL_CMD_PRINTF("NFC Device found (%s)\n", devName);
 
@@ -368,6 +388,9 @@ static void ncl_cmd_cb_dev_found(const char *devName, void *user_data)
 static void ncl_cmd_cb_dev_lost(const char *devName, void *user_data)
 {
 	(void) user_data; /* remove warning */
+	sNclCmdCtx.events[NEARDAL_EVENT_DEV_LOST]++;
+	if (sNclCmdCtx.quiet)
+		return;
 	NCL_CMD_PRINTF("NFC Dev lost (%s)\n", devName);
 }
 
@@ -377,6 +400,9 @@ static void ncl_cmd_cb_record_found(const char *rcdName, void *user_data)
 	neardal_record	*record;
 
 	(void) user_data; /* remove warning */
+	sNclCmdCtx.events[NEARDAL_EVENT_RECORD_FOUND]++;
+	if (sNclCmdCtx.quiet)
+		return;
 
 	NCL_CMD_PRINTF("Tag Record found (%s)\n", rcdName);
 	ec = neardal_get_record_properties(rcdName, &record);
@@ -1525,6 +1551,479 @@ exit:
  ****************************************************************************/
 
 
+/*****************************************************************************
+ * ncl_cmd_wait : BEGIN
+ * Wait for a neardal event, for scripts (e.g. 'wait tag_found 5s')
+ ****************************************************************************/
+#define WAIT_DEFAULT_TIMEOUT	"10s"
+
+static const char * const ncl_cmd_events[NEARDAL_EVENT_COUNT] = {
+	[NEARDAL_EVENT_ADAPTER_ADDED]		= "adapter_added",
+	[NEARDAL_EVENT_ADAPTER_REMOVED]		= "adapter_removed",
+	[NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED] = "adapter_property_changed",
+	[NEARDAL_EVENT_TAG_FOUND]		= "tag_found",
+	[NEARDAL_EVENT_TAG_LOST]		= "tag_lost",
+	[NEARDAL_EVENT_DEV_FOUND]		= "dev_found",
+	[NEARDAL_EVENT_DEV_LOST]		= "dev_lost",
+	[NEARDAL_EVENT_RECORD_FOUND]		= "record_found"
+};
+
+/* Duration as '5s', '500ms' or '2.5' (seconds), in microseconds (-1 if
+ * invalid) */
+static gint64 ncl_cmd_prv_parse_duration(const char *str)
+{
+	gdouble	val;
+	char	*end;
+
+	val = g_ascii_strtod(str, &end);
+	if (end == str || val < 0)
+		return -1;
+	if (!strcmp(end, "ms"))
+		return val * 1000;
+	if (*end == '\0' || !strcmp(end, "s"))
+		return val * G_USEC_PER_SEC;
+	return -1;
+}
+
+static gboolean ncl_cmd_prv_wait_timeout(gpointer data)
+{
+	*(gboolean *) data = TRUE;
+	return FALSE;
+}
+
+/* Run the main loop until 'ev' is received (since the previous wait on it)
+ * or 'timeout' (us) elapses */
+static gboolean ncl_cmd_prv_wait_event(int ev, gint64 timeout)
+{
+	gboolean	timedOut	= FALSE;
+	guint		timeoutId;
+
+	timeoutId = g_timeout_add(timeout / 1000, ncl_cmd_prv_wait_timeout,
+				  &timedOut);
+	while (sNclCmdCtx.events[ev] == sNclCmdCtx.eventsWaited[ev] &&
+	       timedOut == FALSE)
+		g_main_context_iteration(NULL, TRUE);
+	if (timedOut == FALSE)
+		g_source_remove(timeoutId);
+
+	if (sNclCmdCtx.events[ev] == sNclCmdCtx.eventsWaited[ev])
+		return FALSE;
+	sNclCmdCtx.eventsWaited[ev] = sNclCmdCtx.events[ev];
+
+	return TRUE;
+}
+
+static NCLError ncl_cmd_wait(int argc, char *argv[])
+{
+	gint64		timeout, start;
+	int		ev;
+
+	if (argc < 2 || argc > 3) {
+		NCL_CMD_PRINT("Usage: wait <event> [timeout, default "
+			      WAIT_DEFAULT_TIMEOUT "]\n");
+		return NCLERR_PARSING_PARAMETERS;
+	}
+
+	for (ev = 0; ev < NEARDAL_EVENT_COUNT; ev++)
+		if (!strcmp(argv[1], ncl_cmd_events[ev]))
+			break;
+	if (ev == NEARDAL_EVENT_COUNT) {
+		NCL_CMD_PRINTERR("Unknown event '%s'\n", argv[1]);
+		return NCLERR_PARSING_PARAMETERS;
+	}
+
+	timeout = ncl_cmd_prv_parse_duration(argc > 2 ? argv[2] :
+					     WAIT_DEFAULT_TIMEOUT);
+	if (timeout < 0) {
+		NCL_CMD_PRINTERR("Invalid timeout '%s'\n", argv[2]);
+		return NCLERR_PARSING_PARAMETERS;
+	}
+
+	/* Install Neardal Callback*/
+	if (sNclCmdCtx.cb_initialized == false)
+		ncl_cmd_install_callback();
+
+	start = g_get_monotonic_time();
+	if (ncl_cmd_prv_wait_event(ev, timeout) == FALSE) {
+		NCL_CMD_PRINTERR("No '%s' within %.3f s\n", argv[1],
+				 (double) timeout / G_USEC_PER_SEC);
+		return NCLERR_GLOBAL_ERROR;
+	}
+	NCL_CMD_PRINT("'%s' after %.3f ms\n", argv[1],
+		      (g_get_monotonic_time() - start) / 1000.0);
+
+	return NCLERR_NOERROR;
+}
+/*****************************************************************************
+ * ncl_cmd_wait : END
+ ****************************************************************************/
+
+
+/*****************************************************************************
+ * ncl_cmd_repeat : BEGIN
+ * Run a command several times, stopping at the first error, and report its
+ * latency
+ ****************************************************************************/
+static NCLError ncl_cmd_repeat(int argc, char *argv[])
+{
+	NCLError	err	= NCLERR_NOERROR;
+	GString		*cmd;
+	char		*line, *end;
+	gint64		start, t, total = 0, min = G_MAXINT64, max = 0;
+	guint64		count, n;
+	int		i;
+
+	if (argc < 3) {
+		NCL_CMD_PRINT("Usage: repeat <count> <command> [parameters]\n");
+		return NCLERR_PARSING_PARAMETERS;
+	}
+	count = g_ascii_strtoull(argv[1], &end, 10);
+	if (*end != '\0' || count == 0) {
+		NCL_CMD_PRINTERR("Invalid count '%s'\n", argv[1]);
+		return NCLERR_PARSING_PARAMETERS;
+	}
+
+	/* Quoted again, as ncl_exec() parses the command line */
+	cmd = g_string_new(NULL);
+	for (i = 2; i < argc; i++) {
+		line = g_shell_quote(argv[i]);
+		g_string_append_printf(cmd, "%s%s", i > 2 ? " " : "", line);
+		g_free(line);
+	}
+
+	for (n = 0; n < count && err == NCLERR_NOERROR; n++) {
+		line = g_strdup(cmd->str);
+		start = g_get_monotonic_time();
+		err = ncl_exec(line);
+		t = g_get_monotonic_time() - start;
+		g_free(line);
+
+		total += t;
+		min = MIN(min, t);
+		max = MAX(max, t);
+
+		while (g_main_context_pending(NULL))
+			g_main_context_iteration(NULL, FALSE);
+	}
+
+	NCL_CMD_PRINT("'%s' x%llu: min %.3f ms, avg %.3f ms, max %.3f ms\n",
+		      cmd->str, (unsigned long long) n, min / 1000.0,
+		      total / 1000.0 / n, max / 1000.0);
+	g_string_free(cmd, TRUE);
+
+	return err;
+}
+/*****************************************************************************
+ * ncl_cmd_repeat : END
+ ****************************************************************************/
+
+
+/*****************************************************************************
+ * ncl_cmd_bench : BEGIN
+ * Throughput and latency of Write, Push, tag properties reads or full
+ * poll -> tag found -> read cycles, to qualify a reader and tag on site
+ ****************************************************************************/
+#define BENCH_DEFAULT_COUNT	100
+#define BENCH_DEFAULT_URI	"http://www.example.com"
+
+typedef struct {
+	char		*adpName;
+	char		*target;	/* Tag or device name */
+	char		*uri;		/* Written or pushed URI */
+	gint64		timeout;	/* 'cycle' tag_found timeout (us) */
+} NCLBench;
+
+/* First tag (or device) of the adapter, to be freed */
+static char *ncl_cmd_prv_bench_first(char *adpName, gboolean dev)
+{
+	char		**array	= NULL;
+	char		*name	= NULL;
+	errorCode_t	ec;
+
+	if (dev)
+		ec = neardal_get_devices(adpName, &array, NULL);
+	else
+		ec = neardal_get_tags(adpName, &array, NULL);
+	if (ec == NEARDAL_SUCCESS && array != NULL && array[0] != NULL)
+		name = g_strdup(array[0]);
+	neardal_free_array(&array);
+
+	return name;
+}
+
+static errorCode_t ncl_cmd_prv_bench_write(NCLBench *bench)
+{
+	neardal_record	rcd;
+
+	memset(&rcd, 0, sizeof(rcd));
+	rcd.name	= bench->target;
+	rcd.type	= "URI";
+	rcd.uri		= bench->uri;
+
+	return neardal_tag_write(&rcd);
+}
+
+static errorCode_t ncl_cmd_prv_bench_push(NCLBench *bench)
+{
+	neardal_record	rcd;
+
+	memset(&rcd, 0, sizeof(rcd));
+	rcd.name	= bench->target;
+	rcd.type	= "URI";
+	rcd.uri		= bench->uri;
+
+	return neardal_dev_push(&rcd);
+}
+
+/* Tag properties, then its records properties */
+static errorCode_t ncl_cmd_prv_bench_read(char *tagName)
+{
+	neardal_tag	*tag;
+	neardal_record	*record;
+	errorCode_t	ec;
+	int		i;
+
+	ec = neardal_get_tag_properties(tagName, &tag);
+	if (ec != NEARDAL_SUCCESS)
+		return ec;
+
+	for (i = 0; i < tag->nbRecords && ec == NEARDAL_SUCCESS; i++) {
+		ec = neardal_get_record_properties(tag->records[i], &record);
+		if (ec == NEARDAL_SUCCESS)
+			neardal_free_record(record);
+	}
+	neardal_free_tag(tag);
+
+	return ec;
+}
+
+static errorCode_t ncl_cmd_prv_bench_props(NCLBench *bench)
+{
+	neardal_tag	*tag;
+	errorCode_t	ec;
+
+	ec = neardal_get_tag_properties(bench->target, &tag);
+	if (ec == NEARDAL_SUCCESS)
+		neardal_free_tag(tag);
+
+	return ec;
+}
+
+/* Polling is left on, ncl_cmd_bench() stops it after the last cycle */
+static errorCode_t ncl_cmd_prv_bench_cycle(NCLBench *bench)
+{
+	errorCode_t	ec;
+
+	ec = neardal_start_poll(bench->adpName);
+	if (ec != NEARDAL_SUCCESS && ec != NEARDAL_ERROR_POLLING_ALREADY_ACTIVE)
+		return ec;
+
+	if (ncl_cmd_prv_wait_event(NEARDAL_EVENT_TAG_FOUND, bench->timeout)
+			== FALSE || sNclCmdCtx.lastTag == NULL)
+		return NEARDAL_ERROR_NO_TAG;
+
+	/* The tag of the event which ended the wait */
+	return ncl_cmd_prv_bench_read(sNclCmdCtx.lastTag);
+}
+
+static int ncl_cmd_prv_bench_cmp(gconstpointer a, gconstpointer b)
+{
+	gint64 x = *(const gint64 *) a, y = *(const gint64 *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* 'pct' percentile of the sorted latencies, in ms */
+static double ncl_cmd_prv_bench_pct(GArray *lat, double pct)
+{
+	guint i = pct / 100 * lat->len;
+
+	if (i >= lat->len)
+		i = lat->len - 1;
+	return g_array_index(lat, gint64, i) / 1000.0;
+}
+
+static void ncl_cmd_prv_bench_report(const char *op, GArray *lat,
+				     GHashTable *errors, gint64 elapsed)
+{
+	GHashTableIter	iter;
+	gpointer	key, value;
+	guint		nbErrors = 0;
+
+	g_hash_table_iter_init(&iter, errors);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		nbErrors += GPOINTER_TO_UINT(value);
+
+	NCL_CMD_PRINT("bench %s: %u ops in %.3f s, %.1f ops/s, %u errors\n",
+		      op, lat->len, elapsed / 1e6,
+		      elapsed > 0 ? lat->len * 1e6 / elapsed : 0, nbErrors);
+	if (lat->len == 0)
+		return;
+
+	g_array_sort(lat, ncl_cmd_prv_bench_cmp);
+	NCL_CMD_PRINT("latency (ms): min %.3f, p50 %.3f, p90 %.3f, "
+		      "p99 %.3f, max %.3f\n",
+		      g_array_index(lat, gint64, 0) / 1000.0,
+		      ncl_cmd_prv_bench_pct(lat, 50),
+		      ncl_cmd_prv_bench_pct(lat, 90),
+		      ncl_cmd_prv_bench_pct(lat, 99),
+		      g_array_index(lat, gint64, lat->len - 1) / 1000.0);
+
+	g_hash_table_iter_init(&iter, errors);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		NCL_CMD_PRINT("error %d='%s': %u\n", GPOINTER_TO_INT(key),
+			      neardal_error_get_text(GPOINTER_TO_INT(key)),
+			      GPOINTER_TO_UINT(value));
+}
+
+static NCLError ncl_cmd_bench(int argc, char *argv[])
+{
+	NCLError		nclErr;
+	NCLBench		bench;
+	errorCode_t		(*op)(NCLBench *);
+	errorCode_t		ec;
+	GArray			*lat;
+	GHashTable		*errors;
+	gpointer		nb;
+	gint64			start, now, end, t;
+	static char		*opName, *adpName, *target, *uri;
+	static int		count, timeout;
+	static double		duration;
+
+	static GOptionEntry options[] = {
+		{ "op", 'o', 0, G_OPTION_ARG_STRING, &opName
+				, "write, push, props or cycle", "write" },
+
+		{ "adp", 'a', 0, G_OPTION_ARG_STRING, &adpName
+				, "Adapter name", "/org/neard/nfc0" },
+
+		{ "target", 't', 0, G_OPTION_ARG_STRING, &target
+				, "Tag or device (default: adapter's 1st)"
+				, "/org/neard/nfc0/tag0" },
+
+		{ "count", 'n', 0, G_OPTION_ARG_INT, &count
+				, "Iterations", "100" },
+
+		{ "duration", 'd', 0, G_OPTION_ARG_DOUBLE, &duration
+				, "Duration, instead of iterations (s)", "10" },
+
+		{ "uri", 'u', 0, G_OPTION_ARG_STRING, &uri
+				, "URI written or pushed", BENCH_DEFAULT_URI },
+
+		{ "timeout", 'w', 0, G_OPTION_ARG_INT, &timeout
+				, "'cycle' tag found timeout (s)", "10" },
+
+		{ NULL, 0, 0, 0, NULL, NULL, NULL} /* End of List */
+	};
+
+	opName = adpName = target = uri = NULL;
+	count = timeout = 0;
+	duration = 0;
+	if (argc > 1)
+		nclErr = ncl_cmd_prv_parseOptions(&argc, &argv, options);
+	else
+		nclErr = NCLERR_PARSING_PARAMETERS;
+
+	op = NULL;
+	if (nclErr == NCLERR_NOERROR && opName != NULL) {
+		if (!strcmp(opName, "write"))
+			op = ncl_cmd_prv_bench_write;
+		else if (!strcmp(opName, "push"))
+			op = ncl_cmd_prv_bench_push;
+		else if (!strcmp(opName, "props"))
+			op = ncl_cmd_prv_bench_props;
+		else if (!strcmp(opName, "cycle"))
+			op = ncl_cmd_prv_bench_cycle;
+	}
+	if (nclErr == NCLERR_NOERROR && (op == NULL || adpName == NULL ||
+					 count < 0 || duration < 0))
+		nclErr = NCLERR_PARSING_PARAMETERS;
+
+	if (nclErr != NCLERR_NOERROR) {
+		NCL_CMD_PRINT("e.g. < bench --op=write --adp=/org/neard/nfc0 "
+			      "--count=100 >\n");
+		NCL_CMD_PRINT("e.g. < bench --op=cycle --adp=/org/neard/nfc0 "
+			      "--duration=60 >\n");
+		goto exit;
+	}
+
+	/* Install Neardal Callback*/
+	if (sNclCmdCtx.cb_initialized == false)
+		ncl_cmd_install_callback();
+
+	bench.adpName	= adpName;
+	bench.uri	= uri != NULL ? uri : BENCH_DEFAULT_URI;
+	bench.timeout	= (timeout > 0 ? timeout : 10) * G_USEC_PER_SEC;
+	bench.target	= target;
+	if (bench.target == NULL && op != ncl_cmd_prv_bench_cycle)
+		bench.target = ncl_cmd_prv_bench_first(adpName,
+					op == ncl_cmd_prv_bench_push);
+	else
+		bench.target = g_strdup(target);
+	if (bench.target == NULL && op != ncl_cmd_prv_bench_cycle) {
+		NCL_CMD_PRINTERR("No %s on '%s'\n",
+				 op == ncl_cmd_prv_bench_push ? "device" : "tag",
+				 adpName);
+		nclErr = NCLERR_LIB_ERROR;
+		goto exit;
+	}
+	if (count == 0 && duration == 0)
+		count = BENCH_DEFAULT_COUNT;
+
+	lat = g_array_new(FALSE, FALSE, sizeof(gint64));
+	errors = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	/* Only tag found events from now on make a 'cycle' */
+	sNclCmdCtx.eventsWaited[NEARDAL_EVENT_TAG_FOUND] =
+				sNclCmdCtx.events[NEARDAL_EVENT_TAG_FOUND];
+	sNclCmdCtx.quiet = TRUE;
+
+	start = now = g_get_monotonic_time();
+	end = start + duration * G_USEC_PER_SEC;
+	while ((count == 0 || lat->len < (guint) count) &&
+	       (duration == 0 || now < end)) {
+		ec = op(&bench);
+		t = g_get_monotonic_time() - now;
+		g_array_append_val(lat, t);
+		if (ec != NEARDAL_SUCCESS) {
+			nb = g_hash_table_lookup(errors, GINT_TO_POINTER(ec));
+			g_hash_table_insert(errors, GINT_TO_POINTER(ec),
+				GUINT_TO_POINTER(GPOINTER_TO_UINT(nb) + 1));
+		}
+
+		/* Signals triggered by the operation */
+		while (g_main_context_pending(NULL))
+			g_main_context_iteration(NULL, FALSE);
+		now = g_get_monotonic_time();
+	}
+
+	sNclCmdCtx.quiet = FALSE;
+	if (op == ncl_cmd_prv_bench_cycle) {
+		/* Neard may have stopped it on the last tag found */
+		ec = neardal_stop_poll(adpName);
+		if (ec != NEARDAL_SUCCESS)
+			NCL_CMD_PRINTF("stop_poll: %s\n",
+				       neardal_error_get_text(ec));
+	}
+	ncl_cmd_prv_bench_report(opName, lat, errors, now - start);
+
+	g_array_free(lat, TRUE);
+	g_hash_table_destroy(errors);
+	g_free(bench.target);
+
+exit:
+	g_free(opName);
+	g_free(adpName);
+	g_free(target);
+	g_free(uri);
+
+	return nclErr;
+}
+/*****************************************************************************
+ * ncl_cmd_bench : END
+ ****************************************************************************/
+
+
 /*****************************************************************************
  * test parameter type (sample code) : BEGIN
  ****************************************************************************/
@@ -1678,6 +2177,10 @@ static NCLCmdInterpretor itFunc[] = {
 	ncl_cmd_exit,
 	"Exit from command line interpretor" },
 
+	{ "bench",
+	ncl_cmd_bench,
+	"Throughput and latency of write, push, props or poll cycles"},
+
 	{ "get_adapters",
 	ncl_cmd_get_adapters,
 	"Get adapters list"},
@@ -1726,6 +2229,10 @@ static NCLCmdInterpretor itFunc[] = {
 	ncl_cmd_register_NDEF_agent,
 	"register a handler for a specific NDEF tag type"},
 
+	{ "repeat",
+	ncl_cmd_repeat,
+	"Run a command N times, reporting its latency (repeat <N> <command>)"},
+
 	{ "set_adp_property",
 	ncl_cmd_set_adapter_property,
 	"Request Neard to set a proprety on defined adapter"},
@@ -1750,6 +2257,11 @@ static NCLCmdInterpretor itFunc[] = {
 	ncl_cmd_unregister_NDEF_agent,
 	"unregister a handler for a specific NDEF tag type"},
 
+	{ "wait",
+	ncl_cmd_wait,
+	"Wait for an event received since the previous wait on it "
+	"(wait tag_found 5s)"},
+
 	{ "write",
 	ncl_cmd_write,
 	"Creates and write a NDEF record to a NFC tag"}
@@ -1834,6 +2346,8 @@ void ncl_cmd_finalize(void)
 
 	if (sNclCmdCtx.clBuf != NULL)
 		g_string_free(sNclCmdCtx.clBuf, TRUE);
+	g_free(sNclCmdCtx.lastTag);
+	sNclCmdCtx.lastTag = NULL;
 
 	/* Release NFC object */
 	neardal_destroy();
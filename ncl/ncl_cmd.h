@@ -36,6 +36,12 @@ typedef struct {
 	/* command line interpretor context */
 	GString		*clBuf;		/* Command line buffer */
 
+	/* Events received, and already waited for by 'wait' */
+	guint		events[NEARDAL_EVENT_COUNT];
+	guint		eventsWaited[NEARDAL_EVENT_COUNT];
+	gboolean	quiet;		/* Events not dumped (bench) */
+	gchar		*lastTag;	/* Name of the last tag found */
+
 } NCLCmdContext;
 
 /* Array prototype of command line functions interpretor */
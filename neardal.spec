@@ -3,7 +3,7 @@
 %define neardal_pkg %{_libdir}/pkgconfig
 %define neardal_inc %{_includedir}/neardal
 
-%define glib2_version   		2.30.0
+%define glib2_version   		2.36.0
 # << macros
 
 Name: neardal
@@ -0,0 +1,135 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Replay a capture (see neardal_capture_start()) through neardal and
+ * report the events delivered to the client:
+ *	neardal_replay [-r] <file>
+ * -r replays with the captured timing instead of as fast as possible.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+
+#include "neardal.h"
+
+static unsigned int	events[NEARDAL_EVENT_COUNT];
+
+static const char * const eventKinds[NEARDAL_EVENT_COUNT] = {
+	[NEARDAL_EVENT_ADAPTER_ADDED]		= "adapter_added",
+	[NEARDAL_EVENT_ADAPTER_REMOVED]		= "adapter_removed",
+	[NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED] = "adapter_property_changed",
+	[NEARDAL_EVENT_TAG_FOUND]		= "tag_found",
+	[NEARDAL_EVENT_TAG_LOST]		= "tag_lost",
+	[NEARDAL_EVENT_DEV_FOUND]		= "dev_found",
+	[NEARDAL_EVENT_DEV_LOST]		= "dev_lost",
+	[NEARDAL_EVENT_RECORD_FOUND]		= "record_found"
+};
+
+#define COUNT_CB(fn, ev)					\
+static void fn(const char *name, void *user_data)		\
+{								\
+	(void) name;						\
+	(void) user_data;					\
+	events[ev]++;						\
+}
+
+COUNT_CB(on_adp_added, NEARDAL_EVENT_ADAPTER_ADDED)
+COUNT_CB(on_adp_removed, NEARDAL_EVENT_ADAPTER_REMOVED)
+COUNT_CB(on_tag_found, NEARDAL_EVENT_TAG_FOUND)
+COUNT_CB(on_tag_lost, NEARDAL_EVENT_TAG_LOST)
+COUNT_CB(on_dev_found, NEARDAL_EVENT_DEV_FOUND)
+COUNT_CB(on_dev_lost, NEARDAL_EVENT_DEV_LOST)
+COUNT_CB(on_rcd_found, NEARDAL_EVENT_RECORD_FOUND)
+
+static void on_adp_prop_changed(char *adpName, char *propName, void *value,
+				void *user_data)
+{
+	(void) adpName;
+	(void) propName;
+	(void) value;
+	(void) user_data;
+	events[NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED]++;
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+	neardal_listener_cb	cb;
+	errorCode_t		ec;
+	unsigned int		nbMessages, nbEvents = 0, i;
+	int			realtime = 0;
+	double			secs;
+
+	if (argc > 1 && !strcmp(argv[1], "-r")) {
+		realtime = 1;
+		argc--;
+		argv++;
+	}
+	if (argc != 2) {
+		fprintf(stderr, "Usage: neardal_replay [-r] <file>\n");
+		return 1;
+	}
+
+	memset(&cb, 0, sizeof(cb));
+	cb.adp_added		= on_adp_added;
+	cb.adp_removed		= on_adp_removed;
+	cb.adp_prop_changed	= on_adp_prop_changed;
+	cb.tag_found		= on_tag_found;
+	cb.tag_lost		= on_tag_lost;
+	cb.dev_found		= on_dev_found;
+	cb.dev_lost		= on_dev_lost;
+	cb.rcd_found		= on_rcd_found;
+	if (neardal_add_listener(NULL, &cb, NULL) == 0) {
+		fprintf(stderr, "neardal_replay: can't add a listener\n");
+		return 1;
+	}
+
+	secs = now_s();
+	ec = neardal_replay_file(argv[1], realtime, &nbMessages);
+	secs = now_s() - secs;
+	if (ec != NEARDAL_SUCCESS)
+		fprintf(stderr, "neardal_replay: %s\n", neardal_error_get_text(ec));
+
+	for (i = 0; i < NEARDAL_EVENT_COUNT; i++) {
+		nbEvents += events[i];
+		if (events[i] > 0)
+			printf("%-26s %u\n", eventKinds[i], events[i]);
+	}
+	printf("%u messages, %u events in %.3f s (%.0f messages/s, "
+	       "%.0f events/s)\n", nbMessages, nbEvents, secs,
+	       secs > 0 ? nbMessages / secs : 0, secs > 0 ? nbEvents / secs : 0);
+
+	neardal_destroy();
+
+	return ec == NEARDAL_SUCCESS ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+/*
+ *     NEARDAL (Neard Abstraction Library)
+ *
+ *     Copyright 2012-2014 Intel Corporation. All rights reserved.
+ *
+ *     This program is free software; you can redistribute it and/or modify
+ *     it under the terms of the GNU Lesser General Public License version 2
+ *     as published by the Free Software Foundation.
+ *
+ *     This program is distributed in the hope that it will be useful,
+ *     but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *     GNU General Public License for more details.
+ *
+ *     You should have received a copy of the GNU General Public License
+ *     along with this program; if not, write to the Free Software Foundation,
+ *     Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Render a binary trace dump (see neardal_trace_ring_dump()) as text, all
+ * threads merged in time order:
+ *	neardal_trace_decode [-r] <file>
+ * -r prints times relative to the first event instead of the wall clock.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+
+#include "neardal.h"
+
+typedef struct {
+	uint32_t		thread;
+	neardal_trace_record	rec;
+} Event;
+
+typedef struct {
+	uint32_t	object;
+	char		*name;
+} Name;
+
+static const char * const eventKinds[NEARDAL_EVENT_COUNT] = {
+	[NEARDAL_EVENT_ADAPTER_ADDED]		= "adapter_added",
+	[NEARDAL_EVENT_ADAPTER_REMOVED]		= "adapter_removed",
+	[NEARDAL_EVENT_ADAPTER_PROPERTY_CHANGED] = "adapter_property_changed",
+	[NEARDAL_EVENT_TAG_FOUND]		= "tag_found",
+	[NEARDAL_EVENT_TAG_LOST]		= "tag_lost",
+	[NEARDAL_EVENT_DEV_FOUND]		= "dev_found",
+	[NEARDAL_EVENT_DEV_LOST]		= "dev_lost",
+	[NEARDAL_EVENT_RECORD_FOUND]		= "record_found"
+};
+
+static int cmp_event(const void *a, const void *b)
+{
+	const Event *ea = a, *eb = b;
+
+	if (ea->rec.ts != eb->rec.ts)
+		return ea->rec.ts < eb->rec.ts ? -1 : 1;
+	return 0;
+}
+
+static int cmp_name(const void *a, const void *b)
+{
+	const Name *na = a, *nb = b;
+
+	if (na->object != nb->object)
+		return na->object < nb->object ? -1 : 1;
+	return 0;
+}
+
+static const char *object_name(const Name *names, uint32_t nbNames,
+			       uint32_t object)
+{
+	Name	key = { .object = object };
+	Name	*n;
+
+	if (object == 0)
+		return "-";
+	n = bsearch(&key, names, nbNames, sizeof(*names), cmp_name);
+	return n ? n->name : "?";
+}
+
+static void print_args(const neardal_trace_record *rec)
+{
+	int64_t a0 = rec->arg[0], a1 = rec->arg[1];
+
+	switch (rec->event) {
+	case NEARDAL_TRACE_EV_DISPATCH:
+		printf("%s delivered=%d",
+		       a0 >= 0 && a0 < NEARDAL_EVENT_COUNT ? eventKinds[a0] :
+							     "unknown",
+		       (int) a1);
+		break;
+	case NEARDAL_TRACE_EV_AGENT_NDEF:
+		printf("records=%lld", (long long) a0);
+		break;
+	case NEARDAL_TRACE_EV_AGENT_OOB_REQ:
+	case NEARDAL_TRACE_EV_AGENT_OOB_PUSH:
+		printf("blob=%lld bytes", (long long) a0);
+		break;
+	case NEARDAL_TRACE_EV_AGENT_RELEASE:
+		break;
+	case NEARDAL_TRACE_EV_TAG_WRITE:
+	case NEARDAL_TRACE_EV_DEV_PUSH:
+		printf("%s", neardal_error_get_text(a0));
+		break;
+	case NEARDAL_TRACE_EV_ADP_SET_PROP:
+		printf("property=%lld %s", (long long) a0,
+		       neardal_error_get_text(a1));
+		break;
+	case NEARDAL_TRACE_EV_POLL:
+		if (a0 < 0)
+			printf("stop %s", neardal_error_get_text(a1));
+		else
+			printf("start mode=%lld %s", (long long) a0,
+			       neardal_error_get_text(a1));
+		break;
+	default:
+		if (rec->event >= NEARDAL_TRACE_EV_USER)
+			printf("id=%u ", rec->event - NEARDAL_TRACE_EV_USER);
+		printf("arg0=%lld arg1=%lld", (long long) a0, (long long) a1);
+		break;
+	}
+}
+
+static void print_time(const neardal_trace_file_header *hdr, uint64_t ts,
+		       uint64_t first, int relative)
+{
+	uint64_t	wall;
+	time_t		secs;
+	struct tm	tm;
+	char		buf[32];
+
+	if (relative) {
+		printf("%14.6f", (double) (ts - first) / 1e6);
+		return;
+	}
+	/* Monotonic to wall clock, using the dump time of both clocks */
+	wall = hdr->realtime - (hdr->monotonic - ts);
+	secs = wall / 1000000000ULL;
+	localtime_r(&secs, &tm);
+	strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+	printf("%s.%06u", buf, (unsigned) (wall % 1000000000ULL / 1000));
+}
+
+/*
+ * Bytes left to read, counts read from the file are checked against it
+ * before anything is allocated for them
+ */
+static size_t file_left(FILE *fp)
+{
+	struct stat	st;
+	long		pos = ftell(fp);
+
+	if (pos < 0 || fstat(fileno(fp), &st) != 0 || st.st_size < pos)
+		return 0;
+	return (size_t) (st.st_size - pos);
+}
+
+static int decode(FILE *fp, int relative)
+{
+	neardal_trace_file_header	hdr;
+	neardal_trace_file_name		fname;
+	neardal_trace_file_ring		fring;
+	Name				*names;
+	Event				*events = NULL;
+	size_t				nbEvents = 0;
+	uint32_t			i, j;
+	int				ret = 1;
+
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    memcmp(hdr.magic, NEARDAL_TRACE_MAGIC, sizeof(hdr.magic)) ||
+	    hdr.version != NEARDAL_TRACE_VERSION ||
+	    hdr.recordSize != sizeof(neardal_trace_record)) {
+		fprintf(stderr, "Not a neardal trace (or other version)\n");
+		return 1;
+	}
+
+	if (hdr.nbNames > file_left(fp) / sizeof(fname)) {
+		fprintf(stderr, "Invalid names count %u\n", hdr.nbNames);
+		return 1;
+	}
+	names = calloc((size_t) hdr.nbNames + 1, sizeof(*names));
+	if (names == NULL)
+		return 1;
+	for (i = 0; i < hdr.nbNames; i++) {
+		if (fread(&fname, sizeof(fname), 1, fp) != 1 ||
+		    fname.len > 4096)
+			goto truncated;
+		names[i].object = fname.object;
+		names[i].name = calloc(fname.len + 1, 1);
+		if (names[i].name == NULL ||
+		    fread(names[i].name, 1, fname.len, fp) != fname.len)
+			goto truncated;
+	}
+	qsort(names, hdr.nbNames, sizeof(*names), cmp_name);
+
+	for (i = 0; i < hdr.nbRings; i++) {
+		Event *tmp;
+
+		if (fread(&fring, sizeof(fring), 1, fp) != 1)
+			goto truncated;
+		if (fring.nbRecords > file_left(fp) /
+				      sizeof(neardal_trace_record) ||
+		    fring.nbRecords > SIZE_MAX / sizeof(*events) - nbEvents)
+			goto truncated;
+		if (fring.nbRecords == 0)
+			continue;
+		tmp = realloc(events, (nbEvents + fring.nbRecords) *
+				      sizeof(*events));
+		if (tmp == NULL)
+			goto exit;
+		events = tmp;
+		for (j = 0; j < fring.nbRecords; j++, nbEvents++) {
+			events[nbEvents].thread = fring.thread;
+			if (fread(&events[nbEvents].rec,
+				  sizeof(neardal_trace_record), 1, fp) != 1)
+				goto truncated;
+		}
+	}
+	qsort(events, nbEvents, sizeof(*events), cmp_event);
+
+	for (i = 0; i < nbEvents; i++) {
+		const neardal_trace_record *rec = &events[i].rec;
+
+		print_time(&hdr, rec->ts, events[0].rec.ts, relative);
+		printf(" [%u] %-20s %s ", events[i].thread,
+		       neardal_trace_event_name(rec->event),
+		       object_name(names, hdr.nbNames, rec->object));
+		print_args(rec);
+		printf("\n");
+	}
+	ret = 0;
+	goto exit;
+
+truncated:
+	fprintf(stderr, "Truncated trace file\n");
+exit:
+	for (i = 0; i < hdr.nbNames; i++)
+		free(names[i].name);
+	free(names);
+	free(events);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	FILE	*fp;
+	int	relative = 0;
+	int	ret;
+
+	if (argc > 1 && !strcmp(argv[1], "-r")) {
+		relative = 1;
+		argc--;
+		argv++;
+	}
+	if (argc != 2) {
+		fprintf(stderr, "Usage: neardal_trace_decode [-r] <file>\n");
+		return 1;
+	}
+
+	fp = fopen(argv[1], "rb");
+	if (fp == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	ret = decode(fp, relative);
+	fclose(fp);
+
+	return ret;
+}